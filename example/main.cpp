@@ -1,5 +1,6 @@
 #include "data_file_loader.h"
 #include "data_manager.h"
+#include "data_view.h"
 #include "fm_device_wrapper.h"
 #include "fm_pdr.h"
 #include "json_operator.h"
@@ -143,9 +144,8 @@ int main( int argc, char* argv[] )
 
                 // 计时开始，测试PDR处理时间
                 // auto start_time = std::chrono::steady_clock::now();
-                CFmDataManager* segment = slice( dynamic_cast< CFmDataFileLoader& >( *pdr_data ), s, e );
-                Eigen::MatrixXd t       = pdr.pdr( si, *segment );
-                delete segment;
+                CFmDataView     segment( *pdr_data, s, e );
+                Eigen::MatrixXd t = pdr.pdr( si, segment, e >= pdr_size );
 
                 size_t rows = t.rows();
                 size_t cols = t.cols();
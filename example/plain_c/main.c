@@ -271,14 +271,19 @@ int main( int argc, char** argv )
                         continue;
                     }
 
+                    // 输出采集统计，丢弃的采样点数(overruns)大于0表示推算跟不上采集
+                    PDRAcquisitionStats stats;
+                    if ( fm_pdr_get_acquisition_stats( pdr_handler, &stats ) == PDR_RESULT_SUCCESS )
+                        fprintf( stderr, "采集统计：采集%llu，处理%llu，丢弃%llu，读取失败%llu，错过采样时刻%llu，队列最大积压%lu/%lu，传感器时钟偏差%.1fppm\n", stats.acquired, stats.consumed, stats.overruns, stats.read_errors, stats.missed_deadlines, stats.max_queue_depth, stats.queue_capacity, stats.clock_skew_ppm );
+
                     quit = 1;
                 }
 
-                // 保存推算出的航迹
+                // 保存推算出的航迹：放入输出队列即返回，由输出线程写入文件，队列已满而丢弃的条数计入输出统计
                 if ( output_path_value )
                 {
-                    ret = fm_pdr_save_trajectory_data( ( char* )"Trajectory.csv", &trajectories_array );
-                    if ( ret != PDR_RESULT_SUCCESS )
+                    ret = fm_pdr_save_trajectory_data_async( pdr_handler, ( char* )"Trajectory.csv", &trajectories_array );
+                    if ( ret < PDR_RESULT_SUCCESS )
                     {
                         fm_pdr_free_trajectory( &trajectories_array );
                         fprintf( stderr, "行人航迹数据保存失败\n" );
@@ -290,7 +295,13 @@ int main( int argc, char** argv )
                 fm_pdr_free_trajectory( &trajectories_array );
 
                 if ( quit )
+                {
+                    // 输出统计，丢弃(dropped)或写入失败大于0表示存储跟不上或不可写；剩余的数据在fm_pdr_uninit时写完
+                    PDROutputStats output_stats;
+                    if ( fm_pdr_get_output_stats( pdr_handler, &output_stats ) == PDR_RESULT_SUCCESS )
+                        fprintf( stderr, "输出统计：入队%llu，写入%llu，丢弃%llu，写入失败%llu，队列最大积压%lu/%lu\n", output_stats.queued, output_stats.written, output_stats.dropped, output_stats.write_errors, output_stats.max_depth, output_stats.capacity );
                     break;
+                }
 
                 sleep( 4 );
             }
@@ -0,0 +1,392 @@
+#include "async_writer.h"
+#include "exception.h"
+#include "sensor_log.h"
+#include "sensor_record.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 写入线程一次从队列取出的记录数
+constexpr size_t kDequeueBatch = 1024;
+// 一个输出缓冲的数据达到该长度时立即写出，否则在队列取空时写出
+constexpr size_t kWriteBufferBytes = 256 * 1024;
+// 队列为空时写入线程的等待时间，也是入队数据写入文件的最大延迟
+constexpr std::chrono::milliseconds kIdleWait( 100 );
+
+namespace
+{
+// 按列数据逐行生成定长记录：入队时记录直接构造在队列的存储中，不需要中间缓冲区
+class ColumnRecordIterator
+{
+public:
+    ColumnRecordIterator( uint32_t sink, uint32_t cols, const double* const* columns ) : m_sink( sink ), m_cols( cols ), m_columns( columns ), m_row( 0 ) {}
+
+    FmOutputRecord operator*() const
+    {
+        FmOutputRecord record;
+        record.sink    = m_sink;
+        record.columns = m_cols;
+        for ( uint32_t k = 0; k < m_cols; ++k )
+            record.values[ k ] = m_columns[ k ][ m_row ];
+        return record;
+    }
+
+    ColumnRecordIterator& operator++()
+    {
+        ++m_row;
+        return *this;
+    }
+
+    ColumnRecordIterator operator++( int )
+    {
+        ColumnRecordIterator it( *this );
+        ++m_row;
+        return it;
+    }
+private:
+    uint32_t             m_sink;
+    uint32_t             m_cols;
+    const double* const* m_columns;
+    size_t               m_row;
+};
+}  // namespace
+
+struct CFmAsyncWriter::Sink
+{
+    std::string                          path;
+    std::vector< std::string >           header;
+    FmOutputFormat                       format;
+    size_t                               cols;
+    int                                  fd;       // CSV文件，-1表示未打开
+    std::unique_ptr< CFmTableWriter >    table;    // 二进制记录或压缩日志
+    std::string                          text;     // 待写入的CSV文本
+    std::vector< std::vector< double > > columns;  // 待写入的二进制记录或压缩日志各列
+    size_t                               rows;     // 缓冲中的行数
+    bool                                 dirty;    // 写入后尚未fsync
+
+    Sink( const std::string& file_path, const std::vector< std::string >& names, FmOutputFormat output_format ) : path( file_path ), header( names ), format( output_format ), cols( names.size() ), fd( -1 ), columns( names.size() ), rows( 0 ), dirty( false ) {}
+    ~Sink()
+    {
+        if ( fd >= 0 )
+            close( fd );
+    }
+};
+
+static void append_value( std::string& text, double value )
+{
+    // NaN为空单元格；定点格式的double最长约330个字符
+    if ( std::isnan( value ) )
+        return;
+    char       buffer[ 400 ];
+    const auto result = std::to_chars( buffer, buffer + sizeof( buffer ), value, std::chars_format::fixed, 8 );
+    text.append( buffer, result.ptr );
+}
+
+static bool write_all( int fd, const char* data, size_t size )
+{
+    while ( size > 0 )
+    {
+        const ssize_t n = write( fd, data, size );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast< size_t >( n );
+    }
+    return true;
+}
+
+// 以追加方式打开CSV文件，新文件先写入列名
+static int open_csv( const std::string& path, const std::vector< std::string >& header )
+{
+    const int fd = open( path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+    if ( fd < 0 )
+        return -1;
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        return -1;
+    }
+    if ( st.st_size == 0 )
+    {
+        std::string line;
+        for ( size_t k = 0; k < header.size(); ++k )
+        {
+            if ( k > 0 )
+                line += ',';
+            line += "\"" + header[ k ] + "\"";
+        }
+        line += '\n';
+        if ( ! write_all( fd, line.data(), line.size() ) )
+        {
+            close( fd );
+            return -1;
+        }
+    }
+    return fd;
+}
+
+CFmAsyncWriter::CFmAsyncWriter( size_t capacity, int fsync_interval_ms )
+    : m_capacity( capacity ), m_fsync_interval_ms( fsync_interval_ms ), m_queue( capacity ), m_depth( 0 ), m_max_depth( 0 ), m_queued( 0 ), m_written( 0 ), m_dropped( 0 ), m_write_errors( 0 ), m_sink_count( 0 ), m_taken( 0 ),
+      m_completed( 0 ), m_flush_requested( false ), m_stop( false ), m_last_sync( std::chrono::steady_clock::now() )
+{
+    if ( capacity == 0 )
+        throw std::invalid_argument( "Output queue capacity must be positive" );
+    m_thread = std::thread( &CFmAsyncWriter::run, this );
+}
+
+CFmAsyncWriter::~CFmAsyncWriter()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_stop = true;
+    }
+    m_wakeup.notify_one();
+    if ( m_thread.joinable() )
+        m_thread.join();
+}
+
+int CFmAsyncWriter::add_sink( const std::string& path, const std::vector< std::string >& header, FmOutputFormat format )
+{
+    if ( header.empty() || header.size() > kMaxOutputColumns )
+        throw std::invalid_argument( "Invalid output column count: " + path );
+
+    std::lock_guard< std::mutex > lock( m_sinks_mutex );
+    const size_t                  count = m_sink_count.load( std::memory_order_relaxed );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        if ( m_sinks[ i ]->path == path )
+            return static_cast< int >( i );
+    }
+    if ( count >= kMaxOutputSinks )
+        throw std::out_of_range( "Too many output files: " + path );
+
+    // 先构造输出再发布编号，生产者与写入线程只访问编号小于m_sink_count的输出
+    m_sinks[ count ] = std::make_unique< Sink >( path, header, format );
+    m_sink_count.store( count + 1, std::memory_order_release );
+    return static_cast< int >( count );
+}
+
+size_t CFmAsyncWriter::reserve( size_t count )
+{
+    // 先占用队列容量再入队，队列深度不超过m_capacity
+    size_t depth = m_depth.load( std::memory_order_relaxed );
+    size_t taken;
+    do
+    {
+        taken = std::min( count, m_capacity - std::min( depth, m_capacity ) );
+        if ( taken == 0 )
+            break;
+    } while ( ! m_depth.compare_exchange_weak( depth, depth + taken, std::memory_order_relaxed ) );
+
+    if ( taken < count )
+        m_dropped.fetch_add( count - taken, std::memory_order_relaxed );
+
+    size_t max_depth = m_max_depth.load( std::memory_order_relaxed );
+    while ( depth + taken > max_depth && ! m_max_depth.compare_exchange_weak( max_depth, depth + taken, std::memory_order_relaxed ) )
+        ;
+    return taken;
+}
+
+bool CFmAsyncWriter::push( int sink, const double* values )
+{
+    // 一行的各列即values的各元素
+    const size_t  cols = sink >= 0 && static_cast< size_t >( sink ) < m_sink_count.load( std::memory_order_acquire ) ? m_sinks[ sink ]->cols : 0;
+    const double* columns[ kMaxOutputColumns ];
+    for ( size_t k = 0; k < cols; ++k )
+        columns[ k ] = values + k;
+    return push_columns( sink, columns, 1 ) == 1;
+}
+
+size_t CFmAsyncWriter::push_columns( int sink, const double* const* columns, size_t rows )
+{
+    if ( sink < 0 || static_cast< size_t >( sink ) >= m_sink_count.load( std::memory_order_acquire ) )
+        throw std::out_of_range( "Invalid output sink: " + std::to_string( sink ) );
+    if ( rows == 0 )
+        return 0;
+
+    const size_t accepted = reserve( rows );
+    if ( accepted == 0 )
+        return 0;
+
+    // 调用者的按列数据在入队时逐行转为定长记录，批量入队
+    const uint32_t cols = static_cast< uint32_t >( m_sinks[ sink ]->cols );
+    m_queue.enqueue_bulk( ColumnRecordIterator( static_cast< uint32_t >( sink ), cols, columns ), accepted );
+    m_queued.fetch_add( accepted, std::memory_order_release );
+    return accepted;
+}
+
+void CFmAsyncWriter::flush()
+{
+    const unsigned long long target = m_queued.load( std::memory_order_acquire );
+
+    std::unique_lock< std::mutex > lock( m_mutex );
+    m_flush_requested = true;
+    m_wakeup.notify_one();
+    m_done.wait( lock, [ & ] { return m_completed >= target; } );
+}
+
+FmOutputStats CFmAsyncWriter::stats() const
+{
+    FmOutputStats s;
+    s.queued       = m_queued.load( std::memory_order_relaxed );
+    s.written      = m_written.load( std::memory_order_relaxed );
+    s.dropped      = m_dropped.load( std::memory_order_relaxed );
+    s.write_errors = m_write_errors.load( std::memory_order_relaxed );
+    s.depth        = static_cast< unsigned long >( m_depth.load( std::memory_order_relaxed ) );
+    s.max_depth    = static_cast< unsigned long >( m_max_depth.load( std::memory_order_relaxed ) );
+    s.capacity     = static_cast< unsigned long >( m_capacity );
+    return s;
+}
+
+void CFmAsyncWriter::format_records( const FmOutputRecord* records, size_t count )
+{
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const FmOutputRecord& r    = records[ i ];
+        Sink&                 sink = *m_sinks[ r.sink ];
+        if ( sink.format == FM_OUTPUT_CSV )
+        {
+            for ( uint32_t k = 0; k < r.columns; ++k )
+            {
+                if ( k > 0 )
+                    sink.text += ',';
+                append_value( sink.text, r.values[ k ] );
+            }
+            sink.text += '\n';
+        }
+        else
+        {
+            for ( uint32_t k = 0; k < r.columns; ++k )
+                sink.columns[ k ].push_back( r.values[ k ] );
+        }
+        ++sink.rows;
+
+        const size_t buffered = sink.format == FM_OUTPUT_CSV ? sink.text.size() : sink.rows * sink.cols * sizeof( double );
+        if ( buffered >= kWriteBufferBytes )
+            write_sink( sink );
+    }
+}
+
+void CFmAsyncWriter::write_sink( Sink& sink )
+{
+    if ( sink.rows == 0 )
+        return;
+
+    bool ok = false;
+    if ( sink.format == FM_OUTPUT_CSV )
+    {
+        // 打开失败时丢弃本次数据，下次写入时重试
+        if ( sink.fd < 0 )
+            sink.fd = open_csv( sink.path, sink.header );
+        ok = sink.fd >= 0 && write_all( sink.fd, sink.text.data(), sink.text.size() );
+        sink.text.clear();
+    }
+    else
+    {
+        // 缓冲中的全部行作为一个数据块追加
+        try
+        {
+            if ( ! sink.table && sink.format == FM_OUTPUT_RECORD )
+                sink.table = std::make_unique< CFmRecordWriter >( sink.path, sink.header );
+            else if ( ! sink.table )
+                sink.table = std::make_unique< CFmLogWriter >( sink.path, sink.header );
+            const double* columns[ kMaxOutputColumns ];
+            for ( size_t k = 0; k < sink.cols; ++k )
+                columns[ k ] = sink.columns[ k ].data();
+            sink.table->append( columns, sink.rows );
+            ok = true;
+        }
+        catch ( const PDRException& e )
+        {
+            std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        }
+        catch ( const std::exception& e )
+        {
+            std::cerr << "[StdError] " << e.what() << std::endl;
+        }
+        for ( auto& column : sink.columns )
+            column.clear();
+    }
+
+    ( ok ? m_written : m_write_errors ).fetch_add( sink.rows, std::memory_order_relaxed );
+    sink.dirty = sink.dirty || ok;
+    sink.rows  = 0;
+}
+
+void CFmAsyncWriter::write_sinks( bool final )
+{
+    const size_t count = m_sink_count.load( std::memory_order_acquire );
+    for ( size_t i = 0; i < count; ++i )
+        write_sink( *m_sinks[ i ] );
+
+    // fsync策略：<0不调用，0每次写入后调用，>0至少间隔该毫秒数；退出时只要启用就调用
+    if ( m_fsync_interval_ms < 0 )
+        return;
+    const auto now = std::chrono::steady_clock::now();
+    if ( ! final && now - m_last_sync < std::chrono::milliseconds( m_fsync_interval_ms ) )
+        return;
+    m_last_sync = now;
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        Sink& sink = *m_sinks[ i ];
+        if ( ! sink.dirty )
+            continue;
+        try
+        {
+            if ( sink.fd >= 0 && fdatasync( sink.fd ) != 0 )
+                throw FileException( FileException::WRITE_FAILED, sink.path.c_str() );
+            if ( sink.table )
+                sink.table->sync();
+        }
+        catch ( const PDRException& e )
+        {
+            std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        }
+        sink.dirty = false;
+    }
+}
+
+void CFmAsyncWriter::run()
+{
+    std::vector< FmOutputRecord > batch( kDequeueBatch );
+    while ( true )
+    {
+        const size_t count = m_queue.try_dequeue_bulk( batch.data(), batch.size() );
+        if ( count > 0 )
+        {
+            m_depth.fetch_sub( count, std::memory_order_relaxed );
+            format_records( batch.data(), count );
+            m_taken += count;
+            continue;
+        }
+
+        // 队列已取空：写出所有缓冲，通知等待flush的调用者
+        std::unique_lock< std::mutex > lock( m_mutex );
+        const bool                     stop = m_stop;
+        lock.unlock();
+        write_sinks( stop );
+
+        lock.lock();
+        m_completed = m_taken;
+        m_done.notify_all();
+        // 析构时生产者已停止，队列取空后退出
+        if ( stop && m_depth.load( std::memory_order_relaxed ) == 0 )
+            break;
+        if ( ! m_flush_requested && ! m_stop )
+            m_wakeup.wait_for( lock, kIdleWait );
+        m_flush_requested = false;
+    }
+}
\ No newline at end of file
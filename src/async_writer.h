@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <moodycamel/concurrentqueue.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 输出文件格式
+typedef enum _FmOutputFormat
+{
+    FM_OUTPUT_CSV,     // 与append_to_csv相同的CSV文本，NaN输出为空单元格
+    FM_OUTPUT_RECORD,  // 二进制记录(sensor_record.h)
+    FM_OUTPUT_LOG,     // 压缩日志(sensor_log.h)
+} FmOutputFormat;
+
+// 一条记录的最大列数（位置/航迹数据为8列）
+constexpr int kMaxOutputColumns = 8;
+// 最多可注册的输出文件数
+constexpr int kMaxOutputSinks = 16;
+
+// 定长输出记录：一行数据
+struct FmOutputRecord
+{
+    uint32_t sink;
+    uint32_t columns;
+    double   values[ kMaxOutputColumns ];
+};
+
+struct FmOutputStats
+{
+    unsigned long long queued;        // 入队的记录数
+    unsigned long long written;       // 已写入文件的记录数
+    unsigned long long dropped;       // 队列已满而丢弃的记录数
+    unsigned long long write_errors;  // 写入失败而丢失的记录数
+    unsigned long      depth;         // 队列中当前的记录数
+    unsigned long      max_depth;     // 队列中记录数的最大值
+    unsigned long      capacity;      // 队列容量（记录数）
+};
+
+// 异步输出：生产者(推算线程、调用者线程)把定长记录放入无锁队列即返回，不做格式化与文件I/O；
+// 写入线程批量取出记录，按输出文件格式化到缓冲区后整块写入，存储跟不上时队列满则丢弃并计数
+class CFmAsyncWriter
+{
+public:
+    // capacity为队列可缓存的记录数；fsync_interval_ms<0时不调用fsync，0为每次写入后调用，>0为至少间隔该毫秒数调用一次
+    CFmAsyncWriter( size_t capacity, int fsync_interval_ms );
+    // 写完队列中的全部记录后退出写入线程
+    ~CFmAsyncWriter();
+
+    CFmAsyncWriter( const CFmAsyncWriter& )            = delete;
+    CFmAsyncWriter& operator=( const CFmAsyncWriter& ) = delete;
+
+    // 注册输出文件，返回输出编号，同一路径返回同一编号；文件在写入线程首次写入时以追加方式打开，
+    // CSV文件为空时先写入列名
+    int add_sink( const std::string& path, const std::vector< std::string >& header, FmOutputFormat format );
+
+    // 追加一行，values的个数为注册时的列数，队列已满时丢弃并返回false
+    bool push( int sink, const double* values );
+    // 按列追加rows行，columns[k]为第k列，返回入队的行数
+    size_t push_columns( int sink, const double* const* columns, size_t rows );
+
+    // 等待调用前已入队的记录全部写入文件
+    void flush();
+
+    FmOutputStats stats() const;
+private:
+    struct Sink;
+
+    size_t reserve( size_t count );
+    void   run();
+    void   format_records( const FmOutputRecord* records, size_t count );
+    void   write_sink( Sink& sink );
+    void   write_sinks( bool final );
+
+    const size_t m_capacity;
+    const int    m_fsync_interval_ms;
+
+    moodycamel::ConcurrentQueue< FmOutputRecord > m_queue;
+    std::atomic< size_t >                         m_depth;
+    std::atomic< size_t >                         m_max_depth;
+    std::atomic< unsigned long long >             m_queued;
+    std::atomic< unsigned long long >             m_written;
+    std::atomic< unsigned long long >             m_dropped;
+    std::atomic< unsigned long long >             m_write_errors;
+
+    // 输出注册后不再移动，生产者按编号读取列数，缓冲区只由写入线程访问
+    std::mutex                                    m_sinks_mutex;  // 串行化add_sink
+    std::unique_ptr< Sink >                       m_sinks[ kMaxOutputSinks ];
+    std::atomic< size_t >                         m_sink_count;
+
+    std::mutex                                    m_mutex;  // 唤醒写入线程、等待写入完成
+    std::condition_variable                       m_wakeup;
+    std::condition_variable                       m_done;
+    unsigned long long                            m_taken;      // 写入线程取出的记录数
+    unsigned long long                            m_completed;  // 已写入(或写入失败)的记录数
+    bool                                          m_flush_requested;
+    bool                                          m_stop;
+    std::chrono::steady_clock::time_point         m_last_sync;
+    std::thread                                   m_thread;
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "clock.h"
+#include <cerrno>
+#include <iterator>
+#include <time.h>
+
+CFmClock::~CFmClock() {}
+
+void CFmClock::attach() {}
+
+void CFmClock::detach() {}
+
+void CFmClock::sleep_for( int64_t duration_ns )
+{
+    sleep_until( now_ns() + duration_ns );
+}
+
+CFmClock& CFmClock::real()
+{
+    static CFmRealClock clock;
+    return clock;
+}
+
+int64_t CFmRealClock::now_ns()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return static_cast< int64_t >( ts.tv_sec ) * 1000000000LL + ts.tv_nsec;
+}
+
+void CFmRealClock::sleep_until( int64_t deadline )
+{
+    // 按绝对时刻睡眠，被信号中断时继续等待
+    struct timespec ts;
+    ts.tv_sec  = deadline / 1000000000LL;
+    ts.tv_nsec = deadline % 1000000000LL;
+    while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr ) == EINTR )
+        ;
+}
+
+CFmSimulatedClock::CFmSimulatedClock( int64_t start_ns ) : m_now( start_ns ), m_participants( 0 ) {}
+
+CFmSimulatedClock::~CFmSimulatedClock() {}
+
+int64_t CFmSimulatedClock::now_ns()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_now;
+}
+
+void CFmSimulatedClock::sleep_until( int64_t deadline )
+{
+    std::unique_lock< std::mutex > lock( m_mutex );
+    if ( deadline <= m_now )
+        return;
+
+    auto it = m_deadlines.insert( deadline );
+    try_advance_locked();
+    m_cv.wait( lock, [ & ] { return m_now >= deadline; } );
+    m_deadlines.erase( it );
+}
+
+void CFmSimulatedClock::attach()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_participants++;
+}
+
+void CFmSimulatedClock::detach()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_participants--;
+    try_advance_locked();
+}
+
+void CFmSimulatedClock::advance( int64_t duration_ns )
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if ( duration_ns > 0 )
+        m_now += duration_ns;
+    m_cv.notify_all();
+}
+
+void CFmSimulatedClock::try_advance_locked()
+{
+    // 唤醒时刻已到的线程视为运行中；仍有登记的线程在运行时时间不前进，未登记的线程睡眠时同样会推动时间
+    auto first = m_deadlines.upper_bound( m_now );
+    if ( first == m_deadlines.end() || std::distance( first, m_deadlines.end() ) < m_participants )
+        return;
+
+    m_now = *first;
+    m_cv.notify_all();
+}
\ No newline at end of file
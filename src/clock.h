@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+
+// 时钟接口：实时流程中的取时与睡眠都经由时钟完成（单调时钟，单位：纳秒），
+// 真实时钟对应CLOCK_MONOTONIC，模拟时钟下可在数秒内模拟数小时的运行，且结果可复现
+class CFmClock
+{
+public:
+    virtual ~CFmClock();
+
+    virtual int64_t now_ns()                        = 0;
+    virtual void    sleep_until( int64_t deadline ) = 0;
+
+    // 参与模拟的线程在开始、结束时登记，真实时钟不需要
+    virtual void attach();
+    virtual void detach();
+
+    void sleep_for( int64_t duration_ns );
+
+    // 进程共用的真实时钟
+    static CFmClock& real();
+};
+
+class CFmRealClock : public CFmClock
+{
+public:
+    int64_t now_ns() override;
+    void    sleep_until( int64_t deadline ) override;
+};
+
+// 模拟时钟（离散事件）：睡眠的线程登记各自的唤醒时刻，所有登记的线程都在睡眠时，时间直接跳到最早的唤醒时刻；
+// 线程运行期间时间不前进，计算耗时需要模拟时由advance注入
+class CFmSimulatedClock : public CFmClock
+{
+public:
+    CFmSimulatedClock( int64_t start_ns = 0 );
+    ~CFmSimulatedClock();
+
+    int64_t now_ns() override;
+    void    sleep_until( int64_t deadline ) override;
+    void    attach() override;
+    void    detach() override;
+
+    // 时间前进duration_ns，用于模拟计算耗时或调度延迟
+    void advance( int64_t duration_ns );
+private:
+    std::mutex               m_mutex;
+    std::condition_variable  m_cv;
+    int64_t                  m_now;           // 当前模拟时间
+    int                      m_participants;  // 登记参与模拟的线程数
+    std::multiset< int64_t > m_deadlines;     // 正在睡眠的线程的唤醒时刻
+
+    void try_advance_locked();
+};
\ No newline at end of file
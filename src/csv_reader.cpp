@@ -0,0 +1,184 @@
+#include "csv_reader.h"
+#include "exception.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 行尾，兼容\r\n
+static const char* line_end( const char* p, const char* end )
+{
+    const char* eol = static_cast< const char* >( memchr( p, '\n', end - p ) );
+    return eol ? eol : end;
+}
+
+static bool is_blank_line( const char* p, const char* eol )
+{
+    for ( ; p < eol; ++p )
+    {
+        if ( *p != '\r' && *p != ' ' && *p != '\t' )
+            return false;
+    }
+    return true;
+}
+
+// 单元格结束位置，引号内的逗号不作为分隔符
+static const char* cell_end( const char* p, const char* eol )
+{
+    bool quoted = false;
+    for ( ; p < eol; ++p )
+    {
+        if ( *p == '"' )
+            quoted = ! quoted;
+        else if ( *p == ',' && ! quoted )
+            break;
+    }
+    return p;
+}
+
+// 去掉单元格首尾的空白、\r与引号
+static void trim_cell( const char*& first, const char*& last )
+{
+    while ( first < last && ( *first == ' ' || *first == '\t' || *first == '"' ) )
+        ++first;
+    while ( last > first && ( last[ -1 ] == ' ' || last[ -1 ] == '\t' || last[ -1 ] == '\r' || last[ -1 ] == '"' ) )
+        --last;
+}
+
+static double parse_cell( const char* first, const char* last )
+{
+    trim_cell( first, last );
+    if ( first < last && *first == '+' )
+        ++first;
+    if ( first == last )
+        return std::numeric_limits< double >::quiet_NaN();
+
+    double value;
+    auto   result = std::from_chars( first, last, value );
+    if ( result.ec != std::errc() )
+        return std::numeric_limits< double >::quiet_NaN();
+    return value;
+}
+
+CFmCsvReader::CFmCsvReader( const std::string& file_path ) : m_file_path( file_path ), m_data( nullptr ), m_size( 0 ), m_body( nullptr )
+{
+    int fd = ::open( file_path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        throw FileException( FileException::READ_FAILED, file_path.c_str() );
+    }
+
+    m_size = static_cast< size_t >( st.st_size );
+    if ( m_size > 0 )
+    {
+        void* addr = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( addr == MAP_FAILED )
+        {
+            close( fd );
+            throw FileException( FileException::READ_FAILED, file_path.c_str() );
+        }
+        madvise( addr, m_size, MADV_SEQUENTIAL );
+        m_data = static_cast< const char* >( addr );
+    }
+    close( fd );
+
+    const char* p   = m_data;
+    const char* end = m_data + m_size;
+
+    // 跳过UTF-8 BOM
+    if ( m_size >= 3 && memcmp( p, "\xEF\xBB\xBF", 3 ) == 0 )
+        p += 3;
+
+    // 列名行
+    if ( p < end )
+    {
+        const char* eol = line_end( p, end );
+        while ( p <= eol )
+        {
+            const char* last  = cell_end( p, eol );
+            const char* first = p;
+            const char* tail  = last;
+            trim_cell( first, tail );
+            m_header.emplace_back( first, tail - first );
+            p = last + 1;
+        }
+        p = eol < end ? eol + 1 : end;
+    }
+    m_body = p;
+
+    // 数据行数，之后按行数预先分配
+    while ( p < end )
+    {
+        const char* eol = line_end( p, end );
+        if ( ! is_blank_line( p, eol ) )
+            m_rows++;
+        p = eol + 1;
+    }
+}
+
+CFmCsvReader::~CFmCsvReader()
+{
+    if ( m_data )
+        munmap( const_cast< char* >( m_data ), m_size );
+}
+
+size_t CFmCsvReader::read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const
+{
+    if ( start_col < 0 || count <= 0 )
+        return 0;
+
+    const char* p        = m_body;
+    const char* end      = m_data + m_size;
+    const int   last_col = start_col + count;
+    size_t      skipped  = 0;
+    size_t      row      = 0;
+
+    while ( p < end && row < max_rows )
+    {
+        const char* eol = line_end( p, end );
+        if ( is_blank_line( p, eol ) )
+        {
+            p = eol + 1;
+            continue;
+        }
+
+        // 之前的行只查找行尾，不解析
+        if ( skipped < first_row )
+        {
+            skipped++;
+            p = eol + 1;
+            continue;
+        }
+
+        // 逐个单元格解析，之后的列不再扫描
+        int col = 0;
+        while ( col < last_col && p <= eol )
+        {
+            const char* cell = p;
+            const char* last = cell_end( p, eol );
+            if ( col >= start_col )
+                columns[ col - start_col ][ row ] = parse_cell( cell, last );
+            p = last + 1;
+            col++;
+        }
+        // 缺少的列
+        for ( ; col < last_col; ++col )
+        {
+            if ( col >= start_col )
+                columns[ col - start_col ][ row ] = std::numeric_limits< double >::quiet_NaN();
+        }
+
+        row++;
+        p = eol + 1;
+    }
+
+    return row;
+}
\ No newline at end of file
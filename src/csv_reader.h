@@ -0,0 +1,23 @@
+#pragma once
+#include "table_reader.h"
+
+// CSV读取：文件整体mmap映射，首行为列名（可带引号，如Phyphox导出的"Time (s)"），其余每行为数值，
+// 数值使用std::from_chars解析（支持科学计数法），直接写入调用者预先分配的列数组或Eigen矩阵，不产生中间字符串
+class CFmCsvReader : public CFmTableReader
+{
+public:
+    explicit CFmCsvReader( const std::string& file_path );
+    ~CFmCsvReader();
+
+    CFmCsvReader( const CFmCsvReader& )            = delete;
+    CFmCsvReader& operator=( const CFmCsvReader& ) = delete;
+
+    // 跳过first_row行后解析第start_col列开始的count列的至多max_rows行，行号不含列名行与空行；
+    // 空单元格或无法解析的单元格为NaN
+    size_t read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const override;
+private:
+    std::string m_file_path;
+    const char* m_data;  // 映射的文件内容
+    size_t      m_size;
+    const char* m_body;  // 首个数据行
+};
\ No newline at end of file
@@ -1,11 +1,13 @@
 #include "data_buffer_loader.h"
 #include "data_manager.h"
 #include <Eigen/src/Core/Matrix.h>
+#include <algorithm>
 #include <ostream>
 
 CFmDataBufferLoader::CFmDataBufferLoader() : CFmDataManager( DATA_TYPE_BUFFER ) {}
 
-CFmDataBufferLoader::CFmDataBufferLoader( const PDRConfig& config, size_t train_data_size, const PDRData& data ) : CFmDataManager( config, DATA_TYPE_BUFFER, train_data_size )
+CFmDataBufferLoader::CFmDataBufferLoader( const PDRConfig& config, size_t train_data_size, const PDRData& data, CFmGravityEstimator* gravity_estimator )
+    : CFmDataManager( config, DATA_TYPE_BUFFER, train_data_size, gravity_estimator )
 {
     m_have_location_true        = ( data.true_data.length > 0 );
     m_have_line_accelererometer = ( data.sensor_data.lacc_x != nullptr && data.sensor_data.lacc_y != nullptr && data.sensor_data.lacc_z != nullptr );
@@ -187,19 +189,22 @@ void CFmDataBufferLoader::generate_data()
             m_y                   = ( m_longitude.array() - m_longitude( m_train_data_size - 1 ) ) * kK;
         }
 
-        // 处理真实定位数据
-        m_latitude_true            = m_location_true.col( 1 );
-        m_longitude_true           = m_location_true.col( 2 );
-        m_height_true              = m_location_true.col( 3 );
-        m_velocity_true            = m_location_true.col( 4 );
-        m_direction_true           = m_location_true.col( 5 );
-        m_horizontal_accuracy_true = m_location_true.col( 6 );
-        m_vertical_accuracy_true   = m_location_true.col( 7 );
-        m_x_true                   = ( m_latitude_true.array() - m_latitude_true( 0 ) ) * kK;
-        m_y_true                   = ( m_longitude_true.array() - m_longitude_true( 0 ) ) * kK;
-
-        // 如果包含训练数据，则以最后一个训练数据的经纬度作为原点；否则以第一条数据作为原点
-        m_origin = make_pair( m_train_data_size > 0 ? m_latitude( m_train_data_size - 1 ) : m_latitude_true( 0 ), m_train_data_size > 0 ? m_longitude( m_train_data_size - 1 ) : m_longitude_true( 0 ) );
+        // 处理真实定位数据，切片范围内可能没有定位记录，此时保留切片前的原点
+        if ( m_location_true.rows() > 0 )
+        {
+            m_latitude_true            = m_location_true.col( 1 );
+            m_longitude_true           = m_location_true.col( 2 );
+            m_height_true              = m_location_true.col( 3 );
+            m_velocity_true            = m_location_true.col( 4 );
+            m_direction_true           = m_location_true.col( 5 );
+            m_horizontal_accuracy_true = m_location_true.col( 6 );
+            m_vertical_accuracy_true   = m_location_true.col( 7 );
+            m_x_true                   = ( m_latitude_true.array() - m_latitude_true( 0 ) ) * kK;
+            m_y_true                   = ( m_longitude_true.array() - m_longitude_true( 0 ) ) * kK;
+
+            // 如果包含训练数据，则以最后一个训练数据的经纬度作为原点；否则以第一条数据作为原点
+            m_origin = make_pair( m_train_data_size > 0 ? m_latitude( m_train_data_size - 1 ) : m_latitude_true( 0 ), m_train_data_size > 0 ? m_longitude( m_train_data_size - 1 ) : m_longitude_true( 0 ) );
+        }
     }
     else
     {
@@ -238,14 +243,20 @@ CFmDataBufferLoader* slice( const CFmDataBufferLoader& buffer_loader, size_t sta
 
     // 切片传感器数据
     new_buffer_loader->m_a  = buffer_loader.m_a.block( start, 0, num_rows, buffer_loader.m_a.cols() );
-    new_buffer_loader->m_la = buffer_loader.m_la.block( start, 0, num_rows, buffer_loader.m_la.cols() );
     new_buffer_loader->m_gs = buffer_loader.m_gs.block( start, 0, num_rows, buffer_loader.m_gs.cols() );
     new_buffer_loader->m_m  = buffer_loader.m_m.block( start, 0, num_rows, buffer_loader.m_m.cols() );
     new_buffer_loader->m_g  = buffer_loader.m_g.block( start, 0, num_rows, buffer_loader.m_g.cols() );
 
-    // 切片时间位置数据
-    size_t _start = start / buffer_loader.m_config->sample_rate;
-    size_t _end   = end / buffer_loader.m_config->sample_rate;
+    // 没有线性加速度计数据时，对应的矩阵为空
+    if ( buffer_loader.m_have_line_accelererometer )
+        new_buffer_loader->m_la = buffer_loader.m_la.block( start, 0, num_rows, buffer_loader.m_la.cols() );
+
+    // 按时间查找切片范围内的位置数据：时间不早于切片首个采样点的第一条记录，到时间晚于切片末个采样点的第一条记录为止
+    const double start_time = buffer_loader.m_time[ start ];
+    const double end_time   = buffer_loader.m_time[ end - 1 ];
+    const auto&  time_true  = buffer_loader.m_time_location_true;
+    size_t       _start     = std::lower_bound( time_true.data(), time_true.data() + time_true.size(), start_time ) - time_true.data();
+    size_t       _end       = std::upper_bound( time_true.data(), time_true.data() + time_true.size(), end_time ) - time_true.data();
 
     // 处理位置输入切片和训练数据时间切片
     size_t start_input = ( _start < buffer_loader.m_train_data_size ) ? _start : buffer_loader.m_train_data_size;
@@ -269,9 +280,12 @@ CFmDataBufferLoader* slice( const CFmDataBufferLoader& buffer_loader, size_t sta
     new_buffer_loader->m_have_location_true = buffer_loader.m_have_location_true;
     if ( buffer_loader.m_have_location_true && buffer_loader.m_location_true.rows() > 0 )
     {
-        size_t true_rows                        = _end - _start;
-        new_buffer_loader->m_time_location_true = buffer_loader.m_time_location_true.segment( _start, true_rows );
-        new_buffer_loader->m_location_true      = buffer_loader.m_location_true.block( _start, 0, true_rows, buffer_loader.m_location_true.cols() );
+        // 定位数据的末尾可能不足一个完整的秒
+        size_t true_end                         = std::min( _end, static_cast< size_t >( buffer_loader.m_location_true.rows() ) );
+        size_t true_start                       = std::min( _start, true_end );
+        size_t true_rows                        = true_end - true_start;
+        new_buffer_loader->m_time_location_true = buffer_loader.m_time_location_true.segment( true_start, true_rows );
+        new_buffer_loader->m_location_true      = buffer_loader.m_location_true.block( true_start, 0, true_rows, buffer_loader.m_location_true.cols() );
     }
 
     // 重新生成数据
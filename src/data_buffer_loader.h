@@ -5,7 +5,7 @@ class CFmDataBufferLoader : public CFmDataManager
 {
 public:
     CFmDataBufferLoader( );
-    CFmDataBufferLoader( const PDRConfig& config, size_t train_data_size, const PDRData& data );
+    CFmDataBufferLoader( const PDRConfig& config, size_t train_data_size, const PDRData& data, CFmGravityEstimator* gravity_estimator = nullptr );
     ~CFmDataBufferLoader();
 
     friend CFmDataBufferLoader *slice( const CFmDataBufferLoader& buffer_loader, size_t start, size_t end );
@@ -1,12 +1,14 @@
 #include "data_file_loader.h"
+#include "exception.h"
+#include "table_reader.h"
 #include <Eigen/src/Core/Matrix.h>
-#include <filesystem>
+#include <algorithm>
+#include <limits>
 
-namespace fs = filesystem;
+CFmDataFileLoader::CFmDataFileLoader() : CFmDataManager( DATA_TYPE_FILE ), m_start_time( -numeric_limits< double >::infinity() ), m_end_time( numeric_limits< double >::infinity() ) {}
 
-CFmDataFileLoader::CFmDataFileLoader() : CFmDataManager( DATA_TYPE_FILE ) {}
-
-CFmDataFileLoader::CFmDataFileLoader( const PDRConfig& config, size_t train_data_size, const string& file_path ) : CFmDataManager( config, DATA_TYPE_FILE, train_data_size ), m_file_path( file_path )
+CFmDataFileLoader::CFmDataFileLoader( const PDRConfig& config, size_t train_data_size, const string& file_path )
+    : CFmDataManager( config, DATA_TYPE_FILE, train_data_size ), m_file_path( file_path ), m_start_time( -numeric_limits< double >::infinity() ), m_end_time( numeric_limits< double >::infinity() )
 {
     if ( file_path.empty() )
         throw std::invalid_argument( "File path cannot be empty." );
@@ -17,40 +19,57 @@ CFmDataFileLoader::CFmDataFileLoader( const PDRConfig& config, size_t train_data
     // debug_print_data( 10 );
 }
 
+CFmDataFileLoader::CFmDataFileLoader( const PDRConfig& config, const string& file_path, double start_time, double end_time )
+    : CFmDataManager( config, DATA_TYPE_FILE, 0 ), m_file_path( file_path ), m_start_time( start_time ), m_end_time( end_time )
+{
+    if ( file_path.empty() )
+        throw std::invalid_argument( "File path cannot be empty." );
+    if ( ! ( start_time < end_time ) )
+        throw std::invalid_argument( "Invalid time range." );
+
+    load_data_from_file( file_path );
+    if ( m_doc_accelerometer.rows() == 0 )
+        throw DataException( DataException::EMPTY_ERROR, "No accelerometer data in time range" );
+    preprocess_data( false );
+    generate_data();
+}
+
 CFmDataFileLoader::~CFmDataFileLoader() {}
 
-Document CFmDataFileLoader::load_csv( const string& filename )
+Eigen::MatrixXd CFmDataFileLoader::load_table( const string& name )
 {
-    string full_path = m_file_path + "/" + filename;
-    if ( ! fs::exists( full_path ) )
-        throw runtime_error( "File not found: " + full_path );
-    return Document( full_path, LabelParams( 0, -1 ) );
+    // 同名的二进制记录优先于CSV，只读取加载时间范围内的行
+    auto table = CFmTableReader::open( m_file_path, name );
+    if ( ! table )
+        throw runtime_error( "File not found: " + m_file_path + "/" + name + ".csv" );
+    return table->read_time_range( m_start_time, m_end_time );
 }
 
 void CFmDataFileLoader::load_data_from_file( const string& file_path )
 {
     // 读取加速度计数据
-    m_doc_accelerometer = load_csv( "Accelerometer.csv" );
+    m_doc_accelerometer = load_table( "Accelerometer" );
 
     // 读取陀螺仪数据
-    m_doc_gyroscope = load_csv( "Gyroscope.csv" );
+    m_doc_gyroscope = load_table( "Gyroscope" );
 
     // 读取磁力计数据
-    m_doc_magnetometer = load_csv( "Magnetometer.csv" );
+    m_doc_magnetometer = load_table( "Magnetometer" );
 
     // 读取位置输入数据
     // m_doc_location_input = load_csv( "Location_input.csv" );
 
     // 读取线性加速度计数据
-    m_have_line_accelererometer = fs::exists( m_file_path + "/" + "Linear Accelerometer.csv" );
+    m_have_line_accelererometer = CFmTableReader::exists( m_file_path, "Linear Accelerometer" );
     if ( m_have_line_accelererometer )
-        m_doc_linear_accelererometer = load_csv( "Linear Accelerometer.csv" );
+        m_doc_linear_accelererometer = load_table( "Linear Accelerometer" );
 
     // 检查并读取真实位置数据，如果存在真实位置数据，则可以训练和评估，否则不需要读取真实位置数据（即：只能预测）
-    m_have_location_true = fs::exists( m_file_path + "/" + "Location.csv" );
+    m_have_location_true = CFmTableReader::exists( m_file_path, "Location" );
     if ( m_have_location_true )
     {
-        m_doc_location = load_csv( "Location.csv" );
+        m_doc_location       = load_table( "Location" );
+        m_have_location_true = m_doc_location.rows() > 0;
     }
     else
     {
@@ -62,16 +81,15 @@ void CFmDataFileLoader::load_data_from_file( const string& file_path )
 void CFmDataFileLoader::preprocess_data( bool is_save )
 {
     m_slice_start = 0;
-    m_slice_end   = m_doc_accelerometer.GetRowCount();
+    m_slice_end   = m_doc_accelerometer.rows();
 
     // 如果包含训练数据，则先对齐真实位置时间戳，在进行训练和预测
     if ( m_train_data_size > 0 )
     {
         if ( m_have_location_true )
         {
-            const vector< double >& time_location_vec = m_doc_location.GetColumn< double >( 0 );
-            Map< const VectorXd >   time_location_map( time_location_vec.data(), time_location_vec.size() );
-            Eigen::Index            time_location_size = time_location_map.size();
+            Map< const VectorXd > time_location_map( m_doc_location.data(), m_doc_location.rows() );
+            Eigen::Index          time_location_size = time_location_map.size();
             if ( m_train_data_size > ( size_t )time_location_size )
             {
                 if (m_train_data_size == (size_t)-1)
@@ -91,17 +109,14 @@ void CFmDataFileLoader::preprocess_data( bool is_save )
             m_time.segment( last_index * m_config->sample_rate, m_config->sample_rate ) = VectorXd::LinSpaced( m_config->sample_rate, m_time_location_true[ last_index ], m_time_location_true[ last_index ] + ( 1 - 1.0 / m_config->sample_rate ) );
 
             // 获取 a, la, gs, m
-            const size_t&           acc_num_rows = m_doc_accelerometer.GetRowCount();
-            const vector< double >& acc_time_vec = m_doc_accelerometer.GetColumn< double >( 0 );
-            Map< const VectorXd >   acc_time_map( acc_time_vec.data(), acc_time_vec.size() );
+            const long            acc_num_rows = m_doc_accelerometer.rows();
+            Map< const VectorXd > acc_time_map( m_doc_accelerometer.data(), acc_num_rows );
 
-            const size_t&           gyrp_num_rows = m_doc_gyroscope.GetRowCount();
-            const vector< double >& gyrp_time_vec = m_doc_gyroscope.GetColumn< double >( 0 );
-            Map< const VectorXd >   gyrp_time_map( gyrp_time_vec.data(), gyrp_time_vec.size() );
+            const long            gyrp_num_rows = m_doc_gyroscope.rows();
+            Map< const VectorXd > gyrp_time_map( m_doc_gyroscope.data(), gyrp_num_rows );
 
-            const size_t&           mag_num_rows = m_doc_magnetometer.GetRowCount();
-            const vector< double >& mag_time_vec = m_doc_magnetometer.GetColumn< double >( 0 );
-            Map< const VectorXd >   mag_time_map( mag_time_vec.data(), mag_time_vec.size() );
+            const long            mag_num_rows = m_doc_magnetometer.rows();
+            Map< const VectorXd > mag_time_map( m_doc_magnetometer.data(), mag_num_rows );
 
             // 根据 m_time 使用最近邻插值获取 a, la, gs, m
             m_a  = nearest_neighbor_interpolation( m_time, acc_time_map, extract_eigen_matrix( m_doc_accelerometer, 1, 3, acc_num_rows ) );
@@ -109,9 +124,8 @@ void CFmDataFileLoader::preprocess_data( bool is_save )
             m_m  = nearest_neighbor_interpolation( m_time, mag_time_map, extract_eigen_matrix( m_doc_magnetometer, 1, 3, mag_num_rows ) );
             if ( m_have_line_accelererometer )
             {
-                const size_t&           lacc_num_rows = m_doc_linear_accelererometer.GetRowCount();
-                const vector< double >& lacc_time_vec = m_doc_linear_accelererometer.GetColumn< double >( 0 );
-                Map< const VectorXd >   lacc_time_map( lacc_time_vec.data(), lacc_time_vec.size() );
+                const long            lacc_num_rows = m_doc_linear_accelererometer.rows();
+                Map< const VectorXd > lacc_time_map( m_doc_linear_accelererometer.data(), lacc_num_rows );
                 m_la = nearest_neighbor_interpolation( m_time, lacc_time_map, extract_eigen_matrix( m_doc_linear_accelererometer, 1, 3, lacc_num_rows ) );
 
                 // 通过 a - la 算出它自带的 g
@@ -129,23 +143,19 @@ void CFmDataFileLoader::preprocess_data( bool is_save )
     }
     else
     {
-        const vector< double >& time_location_vec = m_doc_location.GetColumn< double >( 0 );
-        Map< const VectorXd >   time_location_map( time_location_vec.data(), time_location_vec.size() );
+        Map< const VectorXd > time_location_map( m_doc_location.data(), m_doc_location.rows() );
         m_time_location_true = time_location_map;
 
         // 如果没有训练数据，则直接使用ACC数据的时间戳作为时间轴
         // 获取 a, la, gs, m
-        const size_t&           acc_num_rows = m_doc_accelerometer.GetRowCount();
-        const vector< double >& acc_time_vec = m_doc_accelerometer.GetColumn< double >( 0 );
-        Map< const VectorXd >   acc_time_map( acc_time_vec.data(), acc_time_vec.size() );
+        const long            acc_num_rows = m_doc_accelerometer.rows();
+        Map< const VectorXd > acc_time_map( m_doc_accelerometer.data(), acc_num_rows );
 
-        const size_t&           gyrp_num_rows = m_doc_gyroscope.GetRowCount();
-        const vector< double >& gyrp_time_vec = m_doc_gyroscope.GetColumn< double >( 0 );
-        Map< const VectorXd >   gyrp_time_map( gyrp_time_vec.data(), gyrp_time_vec.size() );
+        const long            gyrp_num_rows = m_doc_gyroscope.rows();
+        Map< const VectorXd > gyrp_time_map( m_doc_gyroscope.data(), gyrp_num_rows );
 
-        const size_t&           mag_num_rows = m_doc_magnetometer.GetRowCount();
-        const vector< double >& mag_time_vec = m_doc_magnetometer.GetColumn< double >( 0 );
-        Map< const VectorXd >   mag_time_map( mag_time_vec.data(), mag_time_vec.size() );
+        const long            mag_num_rows = m_doc_magnetometer.rows();
+        Map< const VectorXd > mag_time_map( m_doc_magnetometer.data(), mag_num_rows );
 
         m_time    = acc_time_map;
 
@@ -154,9 +164,8 @@ void CFmDataFileLoader::preprocess_data( bool is_save )
         m_m  = nearest_neighbor_interpolation( m_time, mag_time_map, extract_eigen_matrix( m_doc_magnetometer, 1, 3, mag_num_rows ) );
         if ( m_have_line_accelererometer )
         {
-            const size_t&           lacc_num_rows = m_doc_linear_accelererometer.GetRowCount();
-            const vector< double >& lacc_time_vec = m_doc_linear_accelererometer.GetColumn< double >( 0 );
-            Map< const VectorXd >   lacc_time_map( lacc_time_vec.data(), lacc_time_vec.size() );
+            const long            lacc_num_rows = m_doc_linear_accelererometer.rows();
+            Map< const VectorXd > lacc_time_map( m_doc_linear_accelererometer.data(), lacc_num_rows );
             m_la = nearest_neighbor_interpolation( m_time, lacc_time_map, extract_eigen_matrix( m_doc_linear_accelererometer, 1, 3, lacc_num_rows ) );
 
             // 通过 a - la 算出它自带的 g
@@ -246,19 +255,22 @@ void CFmDataFileLoader::generate_data()
             m_y                   = ( m_longitude.array() - m_longitude( m_train_data_size - 1 ) ) * kK;
         }
 
-        // 处理真实定位数据
-        m_latitude_true            = m_location_true.col( 1 );
-        m_longitude_true           = m_location_true.col( 2 );
-        m_height_true              = m_location_true.col( 3 );
-        m_velocity_true            = m_location_true.col( 4 );
-        m_direction_true           = m_location_true.col( 5 );
-        m_horizontal_accuracy_true = m_location_true.col( 6 );
-        m_vertical_accuracy_true   = m_location_true.col( 7 );
-        m_x_true                   = ( m_latitude_true.array() - m_latitude_true( 0 ) ) * kK;
-        m_y_true                   = ( m_longitude_true.array() - m_longitude_true( 0 ) ) * kK;
-
-        // 如果包含训练数据，则以最后一个训练数据的经纬度作为原点；否则以第一条数据作为原点
-        m_origin = make_pair( m_train_data_size > 0 ? m_latitude( m_train_data_size - 1 ) : m_latitude_true( 0 ), m_train_data_size > 0 ? m_longitude( m_train_data_size - 1 ) : m_longitude_true( 0 ) );
+        // 处理真实定位数据，切片范围内可能没有定位记录，此时保留切片前的原点
+        if ( m_location_true.rows() > 0 )
+        {
+            m_latitude_true            = m_location_true.col( 1 );
+            m_longitude_true           = m_location_true.col( 2 );
+            m_height_true              = m_location_true.col( 3 );
+            m_velocity_true            = m_location_true.col( 4 );
+            m_direction_true           = m_location_true.col( 5 );
+            m_horizontal_accuracy_true = m_location_true.col( 6 );
+            m_vertical_accuracy_true   = m_location_true.col( 7 );
+            m_x_true                   = ( m_latitude_true.array() - m_latitude_true( 0 ) ) * kK;
+            m_y_true                   = ( m_longitude_true.array() - m_longitude_true( 0 ) ) * kK;
+
+            // 如果包含训练数据，则以最后一个训练数据的经纬度作为原点；否则以第一条数据作为原点
+            m_origin = make_pair( m_train_data_size > 0 ? m_latitude( m_train_data_size - 1 ) : m_latitude_true( 0 ), m_train_data_size > 0 ? m_longitude( m_train_data_size - 1 ) : m_longitude_true( 0 ) );
+        }
     }
     else
     {
@@ -298,14 +310,20 @@ CFmDataFileLoader* slice( const CFmDataFileLoader& file_loader, size_t start, si
 
     // 切片传感器数据
     new_file_loader->m_a  = file_loader.m_a.block( start, 0, num_rows, file_loader.m_a.cols() );
-    new_file_loader->m_la = file_loader.m_la.block( start, 0, num_rows, file_loader.m_la.cols() );
     new_file_loader->m_gs = file_loader.m_gs.block( start, 0, num_rows, file_loader.m_gs.cols() );
     new_file_loader->m_m  = file_loader.m_m.block( start, 0, num_rows, file_loader.m_m.cols() );
     new_file_loader->m_g  = file_loader.m_g.block( start, 0, num_rows, file_loader.m_g.cols() );
 
-    // 切片时间位置数据
-    size_t _start = start / file_loader.m_config->sample_rate;
-    size_t _end   = end / file_loader.m_config->sample_rate;
+    // 没有线性加速度计数据时，对应的矩阵为空
+    if ( file_loader.m_have_line_accelererometer )
+        new_file_loader->m_la = file_loader.m_la.block( start, 0, num_rows, file_loader.m_la.cols() );
+
+    // 按时间查找切片范围内的位置数据：时间不早于切片首个采样点的第一条记录，到时间晚于切片末个采样点的第一条记录为止
+    const double start_time = file_loader.m_time[ start ];
+    const double end_time   = file_loader.m_time[ end - 1 ];
+    const auto&  time_true  = file_loader.m_time_location_true;
+    size_t       _start     = std::lower_bound( time_true.data(), time_true.data() + time_true.size(), start_time ) - time_true.data();
+    size_t       _end       = std::upper_bound( time_true.data(), time_true.data() + time_true.size(), end_time ) - time_true.data();
 
     // 处理位置输入切片和训练数据时间切片
     size_t start_input = ( _start < file_loader.m_train_data_size ) ? _start : file_loader.m_train_data_size;
@@ -329,9 +347,12 @@ CFmDataFileLoader* slice( const CFmDataFileLoader& file_loader, size_t start, si
     new_file_loader->m_have_location_true = file_loader.m_have_location_true;
     if ( file_loader.m_have_location_true && file_loader.m_location_true.rows() > 0 )
     {
-        size_t true_rows                      = _end - _start;
-        new_file_loader->m_time_location_true = file_loader.m_time_location_true.segment( _start, true_rows );
-        new_file_loader->m_location_true      = file_loader.m_location_true.block( _start, 0, true_rows, file_loader.m_location_true.cols() );
+        // 定位数据的末尾可能不足一个完整的秒
+        size_t true_end                       = std::min( _end, static_cast< size_t >( file_loader.m_location_true.rows() ) );
+        size_t true_start                     = std::min( _start, true_end );
+        size_t true_rows                      = true_end - true_start;
+        new_file_loader->m_time_location_true = file_loader.m_time_location_true.segment( true_start, true_rows );
+        new_file_loader->m_location_true      = file_loader.m_location_true.block( true_start, 0, true_rows, file_loader.m_location_true.cols() );
     }
 
     // 重新生成数据
@@ -340,11 +361,11 @@ CFmDataFileLoader* slice( const CFmDataFileLoader& file_loader, size_t start, si
     return new_file_loader;
 }
 
-Eigen::MatrixXd CFmDataFileLoader::extract_eigen_matrix( Document& data, int start_col, int end_col, long num_rows )
+Eigen::MatrixXd CFmDataFileLoader::extract_eigen_matrix( const Eigen::MatrixXd& data, int start_col, int end_col, long num_rows )
 {
     // 获取文档的实际尺寸
-    const long total_rows = static_cast< long >( data.GetRowCount() );
-    const long total_cols = static_cast< long >( data.GetColumnCount() );
+    const long total_rows = static_cast< long >( data.rows() );
+    const long total_cols = static_cast< long >( data.cols() );
 
     // 处理 num_rows 参数
     if ( num_rows < 0 )
@@ -362,54 +383,11 @@ Eigen::MatrixXd CFmDataFileLoader::extract_eigen_matrix( Document& data, int sta
         actual_start_col = start_col;
         actual_end_col   = end_col;
     }
-    else if ( start_col == -1 || end_col == -1 )
-    {
-        // 如果任一列为-1，则获取所有列
-        actual_start_col = 0;
-        actual_end_col   = total_cols - 1;
-    }
 
     // 验证列范围有效性
     if ( actual_start_col < 0 || actual_end_col >= total_cols || actual_start_col > actual_end_col )
         throw invalid_argument( "无效的列范围" );
 
-    // 计算实际列数
-    const long num_cols = actual_end_col - actual_start_col + 1;
-
-    // 创建结果矩阵
-    Eigen::MatrixXd mat( num_rows, num_cols );
-
-    // 填充矩阵数据
-    for ( long row = 0; row < num_rows; ++row )
-    {
-        // 先获取字符串格式的行数据
-        std::vector< std::string > strRow = data.GetRow< std::string >( row );
-
-        for ( long col = 0; col < num_cols; ++col )
-        {
-            if ( strRow[ actual_start_col + col ].empty() )
-            {
-                // 空值处理：使用特殊值或NaN
-                mat( row, col ) = std::numeric_limits< double >::quiet_NaN();
-            }
-            else
-            {
-                try
-                {
-                    // 处理科学计数法
-                    std::stringstream ss( strRow[ actual_start_col + col ] );
-                    double            val;
-                    ss >> val;
-                    mat( row, col ) = val;
-                }
-                catch ( ... )
-                {
-                    // 处理转换失败
-                    mat( row, col ) = std::numeric_limits< double >::quiet_NaN();
-                }
-            }
-        }
-    }
-
-    return mat;
+    // CSV在加载时已解析为数值（空值为NaN），这里只复制所需的行列
+    return data.block( 0, actual_start_col, num_rows, actual_end_col - actual_start_col + 1 );
 }
\ No newline at end of file
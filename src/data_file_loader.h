@@ -1,28 +1,30 @@
 #pragma once
 #include "data_manager.h"
-#include <rapidcsv.h>
-
-using namespace rapidcsv;
 
 class CFmDataFileLoader : public CFmDataManager
 {
 public:
     CFmDataFileLoader();
     CFmDataFileLoader( const PDRConfig& config, size_t train_data_size, const string& file_path );
+    // 只加载时间在[start_time, end_time)内的数据（不含训练数据），二进制记录按块索引定位，只读取涉及的数据块
+    CFmDataFileLoader( const PDRConfig& config, const string& file_path, double start_time, double end_time );
     ~CFmDataFileLoader();
 
     friend CFmDataFileLoader *slice( const CFmDataFileLoader& data_manager, size_t start, size_t end );
 private:
     string m_file_path;
+    double m_start_time;  // 加载的时间范围，默认为全部
+    double m_end_time;
 
-    Document m_doc_accelerometer;
-    Document m_doc_linear_accelererometer;
-    Document m_doc_gyroscope;
-    Document m_doc_magnetometer;
-    Document m_doc_location;
+    // 各数据文件(CSV或二进制记录)的全部列，按列存储
+    Eigen::MatrixXd m_doc_accelerometer;
+    Eigen::MatrixXd m_doc_linear_accelererometer;
+    Eigen::MatrixXd m_doc_gyroscope;
+    Eigen::MatrixXd m_doc_magnetometer;
+    Eigen::MatrixXd m_doc_location;
 private:
-    Document        load_csv( const string& filename );
-    Eigen::MatrixXd extract_eigen_matrix( Document& data, int start_col, int end_col, long num_rows );
+    Eigen::MatrixXd load_table( const string& name );
+    Eigen::MatrixXd extract_eigen_matrix( const Eigen::MatrixXd& data, int start_col, int end_col, long num_rows );
 
     void load_data_from_file( const string& file_path );
     void preprocess_data( bool is_save );
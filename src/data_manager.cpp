@@ -4,58 +4,18 @@
 
 using namespace rapidcsv;
 
-CFmDataManager::CFmDataManager( DataType type ) : m_config( nullptr ), m_data_type( type ), m_train_data_size( 0 ) {}
-CFmDataManager::CFmDataManager( const PDRConfig& config, DataType type, size_t train_data_size ) : m_config( &config ), m_data_type( type ), m_train_data_size( train_data_size )
-{
-    FusionOffsetInitialise( &m_offset, config.sample_rate );
-    FusionAhrsInitialise( &m_ahrs );
-
-    // Set AHRS algorithm settings
-    const FusionAhrsSettings settings = {
-        .convention            = FusionConventionEnu,
-        .gain                  = 0.5f,
-        .gyroscopeRange        = 2000.0f, /* replace this with actual gyroscope range in degrees/s */
-        .accelerationRejection = 10.0f,
-        .magneticRejection     = 10.0f,
-        .recoveryTriggerPeriod = 5 * ( unsigned int )config.sample_rate, /* 5 seconds */
-    };
-    FusionAhrsSetSettings( &m_ahrs, &settings );
-}
+CFmDataManager::CFmDataManager( DataType type ) : m_config( nullptr ), m_data_type( type ), m_train_data_size( 0 ), m_gravity_estimator( nullptr ) {}
+CFmDataManager::CFmDataManager( const PDRConfig& config, DataType type, size_t train_data_size, CFmGravityEstimator* gravity_estimator ) : m_config( &config ), m_data_type( type ), m_train_data_size( train_data_size ), m_gravity_estimator( gravity_estimator ) {}
 CFmDataManager::~CFmDataManager() {}
 
 Eigen::MatrixXd CFmDataManager::get_gravity_with_ahrs( Eigen::MatrixXd& accelerometer, Eigen::MatrixXd& gyroscope, Eigen::MatrixXd& magnetometer )
 {
-    const int rows = accelerometer.rows();
-    MatrixXd  gravity( rows, 3 );
-
-    for ( int i = 0; i < rows; ++i )
-    {
-        FusionVector acc  = { { static_cast< float >( accelerometer( i, 0 ) ), static_cast< float >( accelerometer( i, 1 ) ), static_cast< float >( accelerometer( i, 2 ) ) } };
-        FusionVector gyro = { { static_cast< float >( gyroscope( i, 0 ) ), static_cast< float >( gyroscope( i, 1 ) ), static_cast< float >( gyroscope( i, 2 ) ) } };
-        FusionVector mag  = { { static_cast< float >( magnetometer( i, 0 ) ), static_cast< float >( magnetometer( i, 1 ) ), static_cast< float >( magnetometer( i, 2 ) ) } };
-
-        // Apply calibration
-        gyro = FusionCalibrationInertial( gyro, m_gyroscopeMisalignment, m_gyroscopeSensitivity, m_gyroscopeOffset );
-        acc  = FusionCalibrationInertial( acc, m_accelerometerMisalignment, m_accelerometerSensitivity, m_accelerometerOffset );
-        mag  = FusionCalibrationMagnetic( mag, m_softIronMatrix, m_hardIronOffset );
-
-        // Update gyroscope offset correction algorithm
-        gyro = FusionOffsetUpdate( &m_offset, gyro );
-
-        // Calculate delta time (in seconds) to account for gyroscope sample clock error
-        const float deltaTime = 1.0f / m_config->sample_rate;
-
-        // Update gyroscope AHRS algorithm
-        FusionAhrsUpdate( &m_ahrs, gyro, acc, mag, deltaTime );
-
-        // Get gravity vector
-        const FusionVector grav = FusionAhrsGetGravity( &m_ahrs );
-        gravity( i, 0 )         = grav.axis.x;
-        gravity( i, 1 )         = grav.axis.y;
-        gravity( i, 2 )         = grav.axis.z;
-    }
+    // 有外部重力估计器时延续其姿态状态，否则从初始状态开始估计
+    if ( m_gravity_estimator )
+        return m_gravity_estimator->update_batch( accelerometer, gyroscope, magnetometer );
 
-    return gravity;
+    CFmGravityEstimator gravity_estimator( *m_config );
+    return gravity_estimator.update_batch( accelerometer, gyroscope, magnetometer );
 }
 
 void CFmDataManager::set_location_output( const Eigen::MatrixXd& trajectory )
@@ -1,6 +1,6 @@
 #pragma once
-#include "Fusion.h"
 #include "fm_pdr.h"
+#include "gravity_estimator.h"
 #include <eigen3/Eigen/Dense>
 #include <rapidcsv.h>
 
@@ -11,8 +11,12 @@ typedef enum _DataType
 {
     DATA_TYPE_BUFFER,  ///< 训练数据
     DATA_TYPE_FILE,    ///< PDR数据
+    DATA_TYPE_VIEW,    ///< 切片视图
 } DataType;
 
+// 数据列的只读引用，可以指向完整数据，也可以指向切片视图中的一段连续数据
+typedef Eigen::Ref< const Eigen::VectorXd > ConstVectorRef;
+
 typedef enum _PDRDataField
 {
     PDR_DATA_FIELD_TIME = 0,
@@ -58,7 +62,7 @@ class CFmDataManager
 {
 public:
     CFmDataManager( DataType type );
-    CFmDataManager( const PDRConfig& config, DataType type, size_t train_data_size );
+    CFmDataManager( const PDRConfig& config, DataType type, size_t train_data_size, CFmGravityEstimator* gravity_estimator = nullptr );
     virtual ~CFmDataManager();
 
     void set_location_output( const Eigen::MatrixXd& trajectory );
@@ -91,12 +95,12 @@ public:
         return m_have_line_accelererometer;
     }
 
-    inline size_t get_pdr_data_size() const
+    virtual size_t get_pdr_data_size() const
     {
         return m_time.size();
     }
 
-    inline const VectorXd& get_pdr_data( PDRDataField field ) const
+    virtual ConstVectorRef get_pdr_data( PDRDataField field ) const
     {
         switch ( field )
         {
@@ -147,12 +151,12 @@ public:
         }
     }
 
-    inline size_t get_true_data_size() const
+    virtual size_t get_true_data_size() const
     {
         return m_time_location_true.size();
     }
 
-    inline const VectorXd& get_true_data( TrueDataField field ) const
+    virtual ConstVectorRef get_true_data( TrueDataField field ) const
     {
         switch ( field )
         {
@@ -181,12 +185,12 @@ public:
         }
     }
 
-    inline size_t get_train_data_size() const
+    virtual size_t get_train_data_size() const
     {
         return m_train_data_size;
     }
 
-    inline const VectorXd& get_train_data( TrueDataField field ) const
+    virtual ConstVectorRef get_train_data( TrueDataField field ) const
     {
         if ( m_train_data_size == 0 )
             throw std::invalid_argument( "No training data available" );
@@ -267,21 +271,8 @@ protected:
     static constexpr double kK = 1e5;
     const PDRConfig*        m_config;
     DataType                m_data_type;
-    size_t                  m_train_data_size;  // 对于切片后得到对象，该数据为0，表示包含训练数据的对象不允许切片
-
-    // Define calibration (replace with actual calibration data if available)
-    FusionMatrix m_gyroscopeMisalignment     = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
-    FusionVector m_gyroscopeSensitivity      = { 1.0f, 1.0f, 1.0f };
-    FusionVector m_gyroscopeOffset           = { 0.0f, 0.0f, 0.0f };
-    FusionMatrix m_accelerometerMisalignment = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
-    FusionVector m_accelerometerSensitivity  = { 1.0f, 1.0f, 1.0f };
-    FusionVector m_accelerometerOffset       = { 0.0f, 0.0f, 0.0f };
-    FusionMatrix m_softIronMatrix            = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
-    FusionVector m_hardIronOffset            = { 0.0f, 0.0f, 0.0f };
-
-    // Initialise algorithms
-    FusionOffset m_offset;
-    FusionAhrs   m_ahrs;
+    size_t                  m_train_data_size;    // 对于切片后得到对象，该数据为0，表示包含训练数据的对象不允许切片
+    CFmGravityEstimator*    m_gravity_estimator;  // 外部持有的重力估计器，为空时每次从初始状态开始估计
 
     bool m_have_location_true        = false;  // 如果存在真实位置数据，则可以训练和评估，否则只能预测
     bool m_have_line_accelererometer = false;  // 如果存在线性加速度计数据，则使用线性加速度计计算重力加速度，否则，使用加速度计来计算重力加速度
@@ -0,0 +1,53 @@
+#include "data_ready.h"
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CFmDataReadyLine::~CFmDataReadyLine() {}
+
+CFmEventFdDataReadyLine::CFmEventFdDataReadyLine()
+{
+    m_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if ( m_fd < 0 )
+        throw std::runtime_error( "Failed to create eventfd data-ready line" );
+}
+
+CFmEventFdDataReadyLine::~CFmEventFdDataReadyLine()
+{
+    close( m_fd );
+}
+
+int CFmEventFdDataReadyLine::Wait( int64_t timeout_ns, int64_t& timestamp_ns )
+{
+    timestamp_ns = -1;
+
+    // 以纳秒精度等待，不足1毫秒的超时不会被截断为0而变成忙等
+    struct pollfd pfd;
+    pfd.fd     = m_fd;
+    pfd.events = POLLIN;
+    struct timespec timeout;
+    timeout.tv_sec  = timeout_ns / 1000000000LL;
+    timeout.tv_nsec = timeout_ns % 1000000000LL;
+    int ret         = ppoll( &pfd, 1, timeout_ns < 0 ? nullptr : &timeout, nullptr );
+    if ( ret < 0 )
+        return errno == EINTR ? 0 : -1;
+    if ( ret == 0 )
+        return 0;
+
+    // 读出的计数即积压的边沿数
+    uint64_t count = 0;
+    if ( read( m_fd, &count, sizeof( count ) ) != sizeof( count ) )
+        return errno == EAGAIN ? 0 : -1;
+    return count > INT_MAX ? INT_MAX : static_cast< int >( count );
+}
+
+void CFmEventFdDataReadyLine::Signal()
+{
+    const uint64_t one = 1;
+    if ( write( m_fd, &one, sizeof( one ) ) < 0 )
+        return;
+}
\ No newline at end of file
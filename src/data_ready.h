@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+struct gpiod_chip;
+struct gpiod_line_request;
+struct gpiod_edge_event_buffer;
+
+// 传感器数据就绪中断线：采集线程阻塞等待数据就绪(或FIFO水位)边沿，代替按采样时刻睡眠轮询
+class CFmDataReadyLine
+{
+public:
+    virtual ~CFmDataReadyLine();
+
+    // 等待边沿，返回本次取出的边沿数，0表示超时，<0表示出错；
+    // timestamp_ns为最后一个边沿的时间戳(CLOCK_MONOTONIC，单位：纳秒)，中断线不提供时间戳时为-1
+    virtual int Wait( int64_t timeout_ns, int64_t& timestamp_ns ) = 0;
+};
+
+#ifdef FM_PDR_GPIOD
+// GPIO中断线(libgpiod v2，实现在gpio_data_ready.cpp，找到libgpiod时才编译)：上升沿触发，时间戳由内核在中断时记录，可使用gpio-sim模拟的中断线
+class CFmGpioDataReadyLine : public CFmDataReadyLine
+{
+public:
+    CFmGpioDataReadyLine( const char* chip_path, unsigned int offset );
+    ~CFmGpioDataReadyLine();
+
+    int Wait( int64_t timeout_ns, int64_t& timestamp_ns ) override;
+private:
+    struct gpiod_chip*              m_chip;
+    struct gpiod_line_request*      m_request;
+    struct gpiod_edge_event_buffer* m_events;  // 一次取出全部积压的边沿
+};
+#endif
+
+// eventfd代替的中断线：向fd写入8字节计数即模拟一次(或多次)边沿，用于回放、合成数据及测试
+class CFmEventFdDataReadyLine : public CFmDataReadyLine
+{
+public:
+    CFmEventFdDataReadyLine();
+    ~CFmEventFdDataReadyLine();
+
+    int Wait( int64_t timeout_ns, int64_t& timestamp_ns ) override;
+
+    inline int fd() const
+    {
+        return m_fd;
+    }
+    // 模拟一次边沿
+    void Signal();
+private:
+    int m_fd;
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "data_view.h"
+#include <algorithm>
+
+CFmDataView::CFmDataView( const CFmDataManager& parent, size_t start, size_t end )
+    : CFmDataManager( parent.get_config(), DATA_TYPE_VIEW, 0 ), m_parent( parent ), m_start( start ), m_rows( 0 ), m_true_start( 0 ), m_true_rows( 0 ), m_train_start( 0 )
+{
+    const size_t size = parent.get_pdr_data_size();
+
+    // 处理负索引
+    if ( end == 0 )
+        end = size;
+
+    // 边界检查
+    if ( end > size || start >= end )
+        throw out_of_range( "Invalid slice range: start=" + to_string( start ) + ", end=" + to_string( end ) + ", size=" + to_string( size ) );
+
+    m_rows                      = end - start;
+    m_have_line_accelererometer = parent.have_line_accelererometer_data();
+    m_have_location_true        = parent.have_location_true();
+
+    // 按时间查找切片范围内的位置数据：时间不早于切片首个采样点的第一条记录，到时间晚于切片末个采样点的第一条记录为止
+    ConstVectorRef time       = parent.get_pdr_data( PDR_DATA_FIELD_TIME );
+    ConstVectorRef time_true  = parent.get_true_data( TRUE_DATA_FIELD_TIME );
+    const double   start_time = time[ start ];
+    const double   end_time   = time[ end - 1 ];
+    size_t         _start     = std::lower_bound( time_true.data(), time_true.data() + time_true.size(), start_time ) - time_true.data();
+    size_t         _end       = std::upper_bound( time_true.data(), time_true.data() + time_true.size(), end_time ) - time_true.data();
+
+    // 处理位置输入切片和训练数据时间切片
+    const size_t parent_train_size = parent.get_train_data_size();
+    size_t       start_input       = ( _start < parent_train_size ) ? _start : parent_train_size;
+    size_t       end_input         = ( _end < parent_train_size ) ? _end : parent_train_size;
+
+    m_train_start     = start_input;
+    m_train_data_size = end_input - start_input;
+
+    // 处理有效位置数据，定位数据的末尾可能不足一个完整的秒
+    const size_t parent_true_size = parent.get_true_data_size();
+    if ( m_have_location_true && parent_true_size > 0 )
+    {
+        _end         = std::min( _end, parent_true_size );
+        m_true_start = std::min( _start, _end );
+        m_true_rows  = _end - m_true_start;
+    }
+
+    // X/Y依赖于切片的原点，只对秒级定位数据重新计算
+    if ( m_have_location_true )
+    {
+        if ( m_train_data_size > 0 )
+        {
+            ConstVectorRef latitude  = get_train_data( TRUE_DATA_FIELD_LATITUDE );
+            ConstVectorRef longitude = get_train_data( TRUE_DATA_FIELD_LONGITUDE );
+            m_x                      = ( latitude.array() - latitude( m_train_data_size - 1 ) ) * kK;
+            m_y                      = ( longitude.array() - longitude( m_train_data_size - 1 ) ) * kK;
+        }
+
+        if ( m_true_rows > 0 )
+        {
+            ConstVectorRef latitude_true  = get_true_data( TRUE_DATA_FIELD_LATITUDE );
+            ConstVectorRef longitude_true = get_true_data( TRUE_DATA_FIELD_LONGITUDE );
+            m_x_true                      = ( latitude_true.array() - latitude_true( 0 ) ) * kK;
+            m_y_true                      = ( longitude_true.array() - longitude_true( 0 ) ) * kK;
+        }
+    }
+}
+
+CFmDataView::~CFmDataView() {}
+
+size_t CFmDataView::get_pdr_data_size() const
+{
+    return m_rows;
+}
+
+ConstVectorRef CFmDataView::get_pdr_data( PDRDataField field ) const
+{
+    ConstVectorRef data = m_parent.get_pdr_data( field );
+
+    // 没有线性加速度计数据时，对应的列为空
+    if ( data.size() == 0 )
+        return data;
+    return data.segment( m_start, m_rows );
+}
+
+size_t CFmDataView::get_true_data_size() const
+{
+    return m_true_rows;
+}
+
+ConstVectorRef CFmDataView::get_true_data( TrueDataField field ) const
+{
+    if ( field == TRUE_DATA_FIELD_X )
+        return m_x_true;
+    if ( field == TRUE_DATA_FIELD_Y )
+        return m_y_true;
+    if ( m_true_rows == 0 )
+        return m_x_true;
+
+    return m_parent.get_true_data( field ).segment( m_true_start, m_true_rows );
+}
+
+size_t CFmDataView::get_train_data_size() const
+{
+    return m_train_data_size;
+}
+
+ConstVectorRef CFmDataView::get_train_data( TrueDataField field ) const
+{
+    if ( m_train_data_size == 0 )
+        throw std::invalid_argument( "No training data available" );
+
+    if ( field == TRUE_DATA_FIELD_X )
+        return m_x;
+    if ( field == TRUE_DATA_FIELD_Y )
+        return m_y;
+
+    return m_parent.get_train_data( field ).segment( m_train_start, m_train_data_size );
+}
\ No newline at end of file
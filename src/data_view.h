@@ -0,0 +1,26 @@
+#pragma once
+#include "data_manager.h"
+
+// 切片视图：不复制数据，通过Eigen::Ref指向父对象中[start, end)区间的连续数据，构造代价为O(1)，
+// 提供与切片相同的get_pdr_data/get_true_data/get_train_data接口，父对象的生命周期必须长于视图。
+// 真实位置的X/Y以切片内的第一个点（训练数据为最后一个点）为原点，按秒级定位数据重新计算。
+class CFmDataView : public CFmDataManager
+{
+public:
+    CFmDataView( const CFmDataManager& parent, size_t start, size_t end );
+    ~CFmDataView();
+
+    size_t         get_pdr_data_size() const override;
+    ConstVectorRef get_pdr_data( PDRDataField field ) const override;
+    size_t         get_true_data_size() const override;
+    ConstVectorRef get_true_data( TrueDataField field ) const override;
+    size_t         get_train_data_size() const override;
+    ConstVectorRef get_train_data( TrueDataField field ) const override;
+private:
+    const CFmDataManager& m_parent;
+    size_t                m_start;        // 传感器数据起始索引
+    size_t                m_rows;         // 传感器数据行数
+    size_t                m_true_start;   // 真实定位数据起始索引（单位：秒）
+    size_t                m_true_rows;    // 真实定位数据行数
+    size_t                m_train_start;  // 训练定位数据起始索引（单位：秒）
+};
\ No newline at end of file
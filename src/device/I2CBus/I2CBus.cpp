@@ -0,0 +1,123 @@
+#include "I2CBus.h"
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+
+// 写入数据较短时使用栈上缓存，避免每次写入分配内存
+#define I2C_BUS_STACK_WRITE 32
+
+static std::mutex                                        bus_mutex;
+static std::map< std::string, std::weak_ptr< I2CBus > > bus_registry;
+
+I2CBus::I2CBus( const std::string& i2c_device, int fd ) : m_device( i2c_device ), m_fd( fd ) {}
+
+I2CBus::~I2CBus()
+{
+    if ( m_fd >= 0 )
+    {
+        close( m_fd );
+    }
+}
+
+std::shared_ptr< I2CBus > I2CBus::open( const char* i2c_device )
+{
+    std::lock_guard< std::mutex > lock( bus_mutex );
+
+    std::shared_ptr< I2CBus > bus = bus_registry[ i2c_device ].lock();
+    if ( bus )
+    {
+        return bus;
+    }
+
+    int fd = ::open( i2c_device, O_RDWR );
+    if ( fd < 0 )
+    {
+        perror( "Failed to open I2C device" );
+        return nullptr;
+    }
+
+    bus                        = std::shared_ptr< I2CBus >( new I2CBus( i2c_device, fd ) );
+    bus_registry[ i2c_device ] = bus;
+    return bus;
+}
+
+int I2CBus::fd() const
+{
+    return m_fd;
+}
+
+bool I2CBus::readRegisters( uint8_t addr, uint8_t reg, uint8_t* buffer, uint32_t len )
+{
+    I2CBusRead read = { addr, reg, buffer, static_cast< uint16_t >( len ) };
+    return readBatch( &read, 1 );
+}
+
+bool I2CBus::writeRegisters( uint8_t addr, uint8_t reg, const uint8_t* buffer, uint32_t len )
+{
+    // 寄存器地址与数据必须在同一条消息中发送
+    uint8_t                stack_buffer[ I2C_BUS_STACK_WRITE ];
+    std::vector< uint8_t > heap_buffer;
+    uint8_t*               tx_buffer = stack_buffer;
+    if ( len + 1 > I2C_BUS_STACK_WRITE )
+    {
+        heap_buffer.resize( len + 1 );
+        tx_buffer = heap_buffer.data();
+    }
+    tx_buffer[ 0 ] = reg;
+    if ( len > 0 )
+    {
+        memcpy( tx_buffer + 1, buffer, len );
+    }
+
+    struct i2c_msg msg;
+    msg.addr  = addr;
+    msg.flags = 0;
+    msg.len   = static_cast< uint16_t >( len + 1 );
+    msg.buf   = tx_buffer;
+    return transfer( &msg, 1 );
+}
+
+bool I2CBus::readBatch( const I2CBusRead* reads, int count )
+{
+    if ( reads == nullptr || count <= 0 || count > I2C_BUS_MAX_BATCH_READS )
+    {
+        return false;
+    }
+
+    // 每项读取为“写寄存器地址”与“读数据”两条消息，消息之间为重复起始条件
+    struct i2c_msg msgs[ I2C_BUS_MAX_BATCH_READS * 2 ];
+    uint8_t        regs[ I2C_BUS_MAX_BATCH_READS ];
+    for ( int i = 0; i < count; ++i )
+    {
+        regs[ i ]               = reads[ i ].reg;
+        msgs[ i * 2 ].addr      = reads[ i ].addr;
+        msgs[ i * 2 ].flags     = 0;
+        msgs[ i * 2 ].len       = 1;
+        msgs[ i * 2 ].buf       = &regs[ i ];
+        msgs[ i * 2 + 1 ].addr  = reads[ i ].addr;
+        msgs[ i * 2 + 1 ].flags = I2C_M_RD;
+        msgs[ i * 2 + 1 ].len   = reads[ i ].len;
+        msgs[ i * 2 + 1 ].buf   = reads[ i ].buffer;
+    }
+    return transfer( msgs, count * 2 );
+}
+
+bool I2CBus::transfer( struct i2c_msg* msgs, int count )
+{
+    struct i2c_rdwr_ioctl_data data;
+    data.msgs  = msgs;
+    data.nmsgs = static_cast< uint32_t >( count );
+
+    if ( ioctl( m_fd, I2C_RDWR, &data ) != count )
+    {
+        perror( "I2C transfer failed" );
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
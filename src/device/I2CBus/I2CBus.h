@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <linux/i2c.h>
+#include <memory>
+#include <string>
+
+// 单次I2C_RDWR可合并的最大寄存器读取数（每次读取占用两条消息，内核限制为42条）
+#define I2C_BUS_MAX_BATCH_READS 21
+
+// 批量读取中的一项：从addr设备的reg寄存器起连续读取len字节到buffer
+typedef struct _I2CBusRead
+{
+    uint8_t  addr;
+    uint8_t  reg;
+    uint8_t* buffer;
+    uint16_t len;
+} I2CBusRead;
+
+/*!
+ * @brief 共享的I2C总线传输层
+ *        同一总线设备只打开一次，挂在总线上的传感器共用文件描述符；寄存器读取通过ioctl(I2C_RDWR)
+ *        以重复起始条件合并“写寄存器地址+读数据”，一次系统调用、中间没有STOP，
+ *        多个寄存器区间的读取可合并为一次传输。I2C_RDWR的每条消息带从机地址，无需I2C_SLAVE切换
+ */
+class I2CBus
+{
+public:
+    ~I2CBus();
+
+    // 打开总线设备，同一路径返回同一实例，最后一个使用者释放时关闭
+    static std::shared_ptr< I2CBus > open( const char* i2c_device );
+
+    int  fd() const;
+    bool readRegisters( uint8_t addr, uint8_t reg, uint8_t* buffer, uint32_t len );
+    bool writeRegisters( uint8_t addr, uint8_t reg, const uint8_t* buffer, uint32_t len );
+    bool readBatch( const I2CBusRead* reads, int count );
+    bool transfer( struct i2c_msg* msgs, int count );
+private:
+    I2CBus( const std::string& i2c_device, int fd );
+
+    std::string m_device;
+    int         m_fd;
+};
\ No newline at end of file
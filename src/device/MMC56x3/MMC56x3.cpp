@@ -14,19 +14,13 @@ MMC56x3::MMC56x3( int32_t sensorID )
 
 bool MMC56x3::begin( uint8_t i2c_address, const char* i2c_device )
 {
-    _i2c_fd = open( i2c_device, O_RDWR );
-    if ( _i2c_fd < 0 )
+    _bus = I2CBus::open( i2c_device );
+    if ( ! _bus )
     {
         std::cerr << "Failed to open I2C device" << std::endl;
         return false;
     }
-
-    if ( ioctl( _i2c_fd, I2C_SLAVE, i2c_address ) < 0 )
-    {
-        std::cerr << "Failed to set I2C address" << std::endl;
-        close( _i2c_fd );
-        return false;
-    }
+    _i2c_addr = i2c_address;
 
     // Check connection
     uint8_t id = readRegister( MMC56X3_PRODUCT_ID );
@@ -34,7 +28,7 @@ bool MMC56x3::begin( uint8_t i2c_address, const char* i2c_device )
     {
         // No MMC56X3 detected ... return false
         std::cerr << "MMC56X3 not detected" << std::endl;
-        close( _i2c_fd );
+        _bus.reset();
         return false;
     }
 
@@ -104,28 +98,42 @@ bool MMC56x3::getEvent( float& x, float& y, float& z )
 {
     if ( ! isContinuousMode() )
     {
-        writeRegister( MMC56X3_CTRL0_REG, 0x01 );  // TM_M trigger
-
-        uint8_t status;
-        status = readRegister( MMC56X3_STATUS_REG );
-        if ( ! ( status & 0x40 ) )
+        // 触发测量与读取状态合并为一次传输
+        uint8_t        trigger[ 2 ] = { MMC56X3_CTRL0_REG, 0x01 };  // TM_M trigger
+        uint8_t        status_reg   = MMC56X3_STATUS_REG;
+        uint8_t        status       = 0;
+        struct i2c_msg msgs[ 3 ]    = { { _i2c_addr, 0, 2, trigger }, { _i2c_addr, 0, 1, &status_reg }, { _i2c_addr, I2C_M_RD, 1, &status } };
+        if ( ! _bus->transfer( msgs, 3 ) || ! ( status & 0x40 ) )
         {
             return false;
         }
     }
 
-    uint8_t buffer[ 9 ];
-    buffer[ 0 ] = MMC56X3_OUT_X_L;
-    if ( write( _i2c_fd, buffer, 1 ) != 1 )
+    // X/Y/Z高位与低位共9字节，一次重复起始传输读出
+    if ( ! _bus->readRegisters( _i2c_addr, MMC56X3_OUT_X_L, _out_buffer, sizeof( _out_buffer ) ) )
     {
-        std::cerr << "Failed to write to I2C device" << std::endl;
+        std::cerr << "Failed to read from I2C device" << std::endl;
         return false;
     }
-    if ( read( _i2c_fd, buffer, 9 ) != 9 )
+
+    decodeEvent( x, y, z );
+    return true;
+}
+
+bool MMC56x3::prepareEventRead( I2CBusRead& read )
+{
+    // 单次测量模式需要先触发并等待状态位，不能并入其他设备的批量读取
+    if ( ! _bus || ! isContinuousMode() )
     {
-        std::cerr << "Failed to read from I2C device" << std::endl;
         return false;
     }
+    read = { _i2c_addr, MMC56X3_OUT_X_L, _out_buffer, sizeof( _out_buffer ) };
+    return true;
+}
+
+void MMC56x3::decodeEvent( float& x, float& y, float& z )
+{
+    const uint8_t* buffer = _out_buffer;
 
     _x = ( uint32_t )buffer[ 0 ] << 12 | ( uint32_t )buffer[ 1 ] << 4 | ( uint32_t )buffer[ 6 ] >> 4;
     _y = ( uint32_t )buffer[ 2 ] << 12 | ( uint32_t )buffer[ 3 ] << 4 | ( uint32_t )buffer[ 7 ] >> 4;
@@ -138,8 +146,11 @@ bool MMC56x3::getEvent( float& x, float& y, float& z )
     x = ( float )_x * 0.00625;  // scale to uT by LSB in datasheet
     y = ( float )_y * 0.00625;
     z = ( float )_z * 0.00625;
+}
 
-    return true;
+const std::shared_ptr< I2CBus >& MMC56x3::bus() const
+{
+    return _bus;
 }
 
 void MMC56x3::setDataRate( uint16_t rate )
@@ -165,7 +176,7 @@ void MMC56x3::setDataRate( uint16_t rate )
 
 uint16_t MMC56x3::getDataRate( void )
 {
-    return _ctrl2_cache;
+    return _odr_cache;
 }
 
 void MMC56x3::getSensor( const char*& name, int& version, int& sensor_id, int& type, int& min_delay, float& max_value, float& min_value, float& resolution )
@@ -182,13 +193,8 @@ void MMC56x3::getSensor( const char*& name, int& version, int& sensor_id, int& t
 
 uint8_t MMC56x3::readRegister( uint8_t reg )
 {
-    if ( write( _i2c_fd, &reg, 1 ) != 1 )
-    {
-        std::cerr << "Failed to write register address" << std::endl;
-        return 0;
-    }
     uint8_t value;
-    if ( read( _i2c_fd, &value, 1 ) != 1 )
+    if ( ! _bus->readRegisters( _i2c_addr, reg, &value, 1 ) )
     {
         std::cerr << "Failed to read register value" << std::endl;
         return 0;
@@ -198,8 +204,7 @@ uint8_t MMC56x3::readRegister( uint8_t reg )
 
 void MMC56x3::writeRegister( uint8_t reg, uint8_t value )
 {
-    uint8_t buffer[ 2 ] = { reg, value };
-    if ( write( _i2c_fd, buffer, 2 ) != 2 )
+    if ( ! _bus->writeRegisters( _i2c_addr, reg, &value, 1 ) )
     {
         std::cerr << "Failed to write register" << std::endl;
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "I2CBus/I2CBus.h"
 #include <cmath>
 #include <fcntl.h>
 #include <iostream>
@@ -40,6 +41,9 @@ public:
     bool begin( uint8_t i2c_addr = MMC56X3_DEFAULT_ADDRESS, const char* i2c_device = "/dev/i2c-1" );
 
     bool getEvent( float& x, float& y, float& z );
+    bool prepareEventRead( I2CBusRead& read );
+    void decodeEvent( float& x, float& y, float& z );
+    const std::shared_ptr< I2CBus >& bus() const;
     void getSensor( const char*& name, int& version, int& sensor_id, int& type, int& min_delay, float& max_value, float& min_value, float& resolution );
 
     void reset( void );
@@ -53,7 +57,8 @@ public:
     uint16_t getDataRate();
     void     setDataRate( uint16_t rate );
 private:
-    int      _i2c_fd;
+    std::shared_ptr< I2CBus > _bus;                                  ///< 共享的I2C总线
+    uint8_t                   _i2c_addr = MMC56X3_DEFAULT_ADDRESS;  ///< 从机地址
     uint16_t _odr_cache   = 0;
     uint8_t  _ctrl2_cache = 0;
 
@@ -61,6 +66,8 @@ private:
     int32_t _y;  ///< y-axis raw data
     int32_t _z;  ///< z-axis raw data
 
+    uint8_t _out_buffer[ 9 ];  ///< X/Y/Z输出寄存器的原始数据
+
     int32_t _sensorID;
 
     uint8_t readRegister( uint8_t reg );
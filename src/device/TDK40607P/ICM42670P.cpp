@@ -33,6 +33,7 @@ static int  i2c_read( inv_imu_serif* serif, uint8_t reg, uint8_t* rbuffer, uint3
 static int  spi_write( inv_imu_serif* serif, uint8_t reg, const uint8_t* wbuffer, uint32_t wlen );
 static int  spi_read( inv_imu_serif* serif, uint8_t reg, uint8_t* rbuffer, uint32_t rlen );
 static void event_cb( inv_imu_sensor_event_t* event );
+static void fifo_batch_cb( inv_imu_sensor_event_t* event );
 
 static const char* APEX_ACTIVITY[ 3 ] = { "IDLE", "WALK", "RUN" };
 
@@ -49,6 +50,10 @@ static const char* APEX_ACTIVITY[ 3 ] = { "IDLE", "WALK", "RUN" };
 #define WOM_THRESHOLD 50 /* = 50 * 1000 / 256 = 195 mg */
 // This is used by the event callback (not object aware), declared static
 static inv_imu_sensor_event_t* event;
+// This is used by the FIFO batch callback, declared static
+static inv_imu_sensor_event_t* fifo_events;
+static int                     fifo_events_max;
+static int                     fifo_events_count;
 
 // I2C constructor
 ICM42670::ICM42670() {}
@@ -77,19 +82,14 @@ ICM42670::~ICM42670()
 
 bool ICM42670::open_i2c_device( const char* i2c_device, uint8_t address, uint32_t freq )
 {
+    // 与同一总线上的其他传感器共用传输层，读写通过I2C_RDWR携带从机地址
     i2c_address = address;
-    i2c_fd      = open( i2c_device, O_RDWR );
-    if ( i2c_fd < 0 )
+    i2c_bus     = I2CBus::open( i2c_device );
+    if ( ! i2c_bus )
     {
-        perror( "Failed to open I2C device" );
         return false;
     }
-    if ( ioctl( i2c_fd, I2C_SLAVE, address ) < 0 )
-    {
-        perror( "Failed to set I2C address" );
-        close( i2c_fd );
-        i2c_fd = -1;
-    }
+    i2c_fd  = i2c_bus->fd();
     use_spi = false;
 
     // 设置总线时钟频率不是所有平台都支持
@@ -109,7 +109,8 @@ void ICM42670::close_i2c_device()
 {
     if ( ! which_use )
     {
-        close( i2c_fd );
+        i2c_bus.reset();
+        i2c_fd = -1;
     }
 }
 
@@ -131,7 +132,7 @@ int ICM42670::begin( bool type, uint8_t i2c_addr, const char* i2c_device )
     which_use = type;
     if ( ! which_use )
     {
-        if ( false == open_i2c_device( "/dev/i2c-1", ICM42670_I2C_ADDRESS, -1 ) )
+        if ( false == open_i2c_device( i2c_device, i2c_addr, -1 ) )
         {
             return -4;
         }
@@ -216,6 +217,37 @@ int ICM42670::getDataFromRegisters( inv_imu_sensor_event_t& evt )
     return inv_imu_get_data_from_registers( &icm_driver );
 }
 
+int ICM42670::prepareDataReads( I2CBusRead* reads )
+{
+    if ( ! i2c_bus || use_spi )
+    {
+        return 0;
+    }
+    // 与inv_imu_get_data_from_registers读取相同的寄存器：数据就绪状态，以及地址连续的温度、加速度、陀螺仪数据
+    reads[ 0 ] = { i2c_address, ( uint8_t )INT_STATUS_DRDY, &data_status, 1 };
+    reads[ 1 ] = { i2c_address, ( uint8_t )TEMP_DATA1, data_regs, sizeof( data_regs ) };
+    return ICM42670_DATA_READS;
+}
+
+bool ICM42670::decodeDataReads( inv_imu_sensor_event_t& evt )
+{
+    // 数据未就绪时与getDataFromRegisters一样不更新evt
+    if ( ! ( data_status & INT_STATUS_DRDY_DATA_RDY_INT_MASK ) )
+    {
+        return false;
+    }
+    const uint8_t* accel = &data_regs[ 2 ];
+    const uint8_t* gyro  = &data_regs[ 2 + ACCEL_DATA_SIZE ];
+    format_s16_data( icm_driver.endianness_data, &data_regs[ 0 ], &evt.temperature );
+    format_s16_data( icm_driver.endianness_data, &accel[ 0 ], &evt.accel[ 0 ] );
+    format_s16_data( icm_driver.endianness_data, &accel[ 2 ], &evt.accel[ 1 ] );
+    format_s16_data( icm_driver.endianness_data, &accel[ 4 ], &evt.accel[ 2 ] );
+    format_s16_data( icm_driver.endianness_data, &gyro[ 0 ], &evt.gyro[ 0 ] );
+    format_s16_data( icm_driver.endianness_data, &gyro[ 2 ], &evt.gyro[ 1 ] );
+    format_s16_data( icm_driver.endianness_data, &gyro[ 4 ], &evt.gyro[ 2 ] );
+    return true;
+}
+
 void ICM42670::enableInterrupt( uint8_t intpin, ICM42670_irq_handler handler )
 {
 #if 0
@@ -319,6 +351,62 @@ int ICM42670::getDataFromFifo( ICM42670_sensor_event_cb event_cb )
     return inv_imu_get_data_from_fifo( &icm_driver );
 }
 
+int ICM42670::startFifo( uint8_t fifo_watermark )
+{
+    int     rc = 0;
+    uint8_t data;
+
+    if ( fifo_watermark == 0 )
+    {
+        return -1;
+    }
+    // 轮询模式不需要中断引脚，水位达到后INT_STATUS中的FIFO_THS置位
+    rc |= inv_imu_configure_fifo( &icm_driver, INV_IMU_FIFO_ENABLED );
+    rc |= inv_imu_write_reg( &icm_driver, FIFO_CONFIG2, 1, &fifo_watermark );
+    data = 0;
+    rc |= inv_imu_write_reg( &icm_driver, FIFO_CONFIG3, 1, &data );
+    // 16位帧时间戳按16us分辨率约1秒回绕，低采样率下相邻帧之间也不会回绕多次
+    rc |= inv_imu_set_timestamp_resolution( &icm_driver, TMST_CONFIG1_RESOL_16us );
+    fifo_timestamp_us = 16;
+    rc |= inv_imu_reset_fifo( &icm_driver );
+    return rc;
+}
+
+int ICM42670::routeDataReadyInt1( bool fifo_threshold )
+{
+    // INT1输出数据就绪或FIFO水位脉冲，由采集线程阻塞等待引脚边沿，不另起监听线程
+    int1_config.INV_UI_DRDY  = fifo_threshold ? INV_IMU_DISABLE : INV_IMU_ENABLE;
+    int1_config.INV_FIFO_THS = fifo_threshold ? INV_IMU_ENABLE : INV_IMU_DISABLE;
+    return inv_imu_set_config_int1( &icm_driver, &int1_config );
+}
+
+int ICM42670::resetFifo( void )
+{
+    return inv_imu_reset_fifo( &icm_driver );
+}
+
+int ICM42670::getBatchFromFifo( inv_imu_sensor_event_t* events, int max_events )
+{
+    int rc = 0;
+
+    if ( events == NULL || max_events <= 0 )
+    {
+        return -1;
+    }
+    // 一次突发读取FIFO中的全部帧，逐帧解码到events
+    fifo_events                = events;
+    fifo_events_max            = max_events;
+    fifo_events_count          = 0;
+    icm_driver.sensor_event_cb = fifo_batch_cb;
+    rc                         = inv_imu_get_data_from_fifo( &icm_driver );
+    icm_driver.sensor_event_cb = event_cb;
+    if ( rc < 0 )
+    {
+        return rc;
+    }
+    return fifo_events_count;
+}
+
 bool ICM42670::isAccelDataValid( inv_imu_sensor_event_t* evt )
 {
     return ( evt->sensor_mask & ( 1 << INV_SENSOR_ACCEL ) );
@@ -535,13 +623,9 @@ int ICM42670::startWakeOnMotion( uint8_t intpin, ICM42670_irq_handler handler )
 static int i2c_write( inv_imu_serif* serif, uint8_t reg, const uint8_t* wbuffer, uint32_t wlen )
 {
     ICM42670* obj = ( ICM42670* )serif->context;
-    uint8_t   buffer[ wlen + 1 ];
-    buffer[ 0 ] = reg;
-    memcpy( buffer + 1, wbuffer, wlen );
 
-    if ( write( obj->i2c_fd, buffer, wlen + 1 ) != ( ssize_t )( wlen + 1 ) )
+    if ( ! obj->i2c_bus->writeRegisters( obj->i2c_address, reg, wbuffer, wlen ) )
     {
-        perror( "I2C write failed" );
         return -1;
     }
     return 0;
@@ -551,16 +635,9 @@ static int i2c_read( inv_imu_serif* serif, uint8_t reg, uint8_t* rbuffer, uint32
 {
     ICM42670* obj = ( ICM42670* )serif->context;
 
-    if ( write( obj->i2c_fd, &reg, 1 ) != 1 )
+    // 寄存器地址与数据读取以重复起始条件合并为一次传输
+    if ( ! obj->i2c_bus->readRegisters( obj->i2c_address, reg, rbuffer, rlen ) )
     {
-        perror( "I2C reg select failed" );
-        return -1;
-    }
-
-    ssize_t bytesRead = read( obj->i2c_fd, rbuffer, rlen );
-    if ( bytesRead != ( ssize_t )rlen )
-    {
-        perror( "I2C read failed" );
         return -1;
     }
     return 0;
@@ -740,3 +817,12 @@ static void event_cb( inv_imu_sensor_event_t* evt )
 {
     memcpy( event, evt, sizeof( inv_imu_sensor_event_t ) );
 }
+
+static void fifo_batch_cb( inv_imu_sensor_event_t* evt )
+{
+    // FIFO镜像缓存最多ICM42670_FIFO_MAX_FRAMES帧，调用者按此容量提供缓存时不会丢帧
+    if ( fifo_events_count < fifo_events_max )
+    {
+        memcpy( &fifo_events[ fifo_events_count++ ], evt, sizeof( inv_imu_sensor_event_t ) );
+    }
+}
@@ -2,6 +2,7 @@
 #ifndef ICM42670_H
 #define ICM42670_H
 
+#include "I2CBus/I2CBus.h"
 #include <thread>
 extern "C" {
 #include "imu/inv_imu_driver.h"
@@ -10,6 +11,10 @@ extern "C" {
 }
 //
 #define ICM42670_I2C_ADDRESS 0x69
+// FIFO镜像缓存可容纳的最大帧数（16字节帧）
+#define ICM42670_FIFO_MAX_FRAMES ( FIFO_MIRRORING_SIZE / 16 )
+// 寄存器方式读取一次采样所需的批量读取项数（数据就绪状态、温度/加速度/陀螺仪数据）
+#define ICM42670_DATA_READS 2
 // This defines the handler called when retrieving a sample from the FIFO
 typedef void ( *ICM42670_sensor_event_cb )( inv_imu_sensor_event_t* event );
 // This defines the handler called when receiving an irq
@@ -25,8 +30,14 @@ public:
     int  startAccel( uint16_t odr, uint16_t fsr );
     int  startGyro( uint16_t odr, uint16_t fsr );
     int  getDataFromRegisters( inv_imu_sensor_event_t& evt );
+    int  prepareDataReads( I2CBusRead* reads );
+    bool decodeDataReads( inv_imu_sensor_event_t& evt );
     int  enableFifoInterrupt( uint8_t intpin, ICM42670_irq_handler handler, uint8_t fifo_watermark );
     int  getDataFromFifo( ICM42670_sensor_event_cb event_cb );
+    int  startFifo( uint8_t fifo_watermark );
+    int  resetFifo( void );
+    int  getBatchFromFifo( inv_imu_sensor_event_t* events, int max_events );
+    int  routeDataReadyInt1( bool fifo_threshold );
     bool isAccelDataValid( inv_imu_sensor_event_t* evt );
     bool isGyroDataValid( inv_imu_sensor_event_t* evt );
     int  startTiltDetection( uint8_t intpin = 2, ICM42670_irq_handler handler = NULL );
@@ -41,6 +52,8 @@ public:
     bool    which_use   = false;  // false:i2c，true:spi
     uint8_t i2c_address = 0;
     int     i2c_fd      = -1;
+    // 共享的I2C总线传输层
+    std::shared_ptr< I2CBus > i2c_bus;
     int     spi_fd      = -1;  // TODO:未实现
     // 设置总线时钟频率不是所有平台都支持，该变量预留，暂不实现
     uint32_t                              clk_freq    = 0;
@@ -49,6 +62,7 @@ public:
     uint8_t                               int_status3 = 0;
     std::thread                           monitor;
     std::chrono::steady_clock::time_point last_interrupt_time;
+    uint32_t                              fifo_timestamp_us = 16;  // FIFO帧时间戳分辨率（单位：微秒）
 protected:
     struct inv_imu_device         icm_driver;
     inv_imu_interrupt_parameter_t int1_config;
@@ -65,6 +79,8 @@ protected:
     uint32_t                      step_cnt_ovflw;
     bool                          apex_tilt_enable;
     bool                          apex_pedometer_enable;
+    uint8_t                       data_status;                                        // 批量读取的INT_STATUS_DRDY
+    uint8_t                       data_regs[ 2 + ACCEL_DATA_SIZE + GYRO_DATA_SIZE ];  // 批量读取的TEMP_DATA1起的数据寄存器
 };
 
 #endif  // ICM42670_H
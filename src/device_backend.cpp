@@ -0,0 +1,124 @@
+#include "device_backend.h"
+#include <cmath>
+
+// 采集缓存的窗口数，覆盖模式返回的数据在之后kRingSlots-1次读取期间保持有效
+constexpr int kRingSlots = 4;
+// 中断模式下等待边沿的超时为kDataReadyTimeoutPeriods个采样时刻间隔，不控制节拍时为1秒
+constexpr int     kDataReadyTimeoutPeriods = 4;
+constexpr int64_t kDataReadyTimeoutNs      = 1000000000LL;
+
+CFmDeviceBackend::CFmDeviceBackend( double pace_rate ) : m_ring( kRingSlots ), m_clock( &CFmClock::real() ), m_data_ready_ns( -1 ), m_pace_rate( pace_rate ), m_grid_step( 1 ), m_grid_started( false ), m_origin_ns( 0 ), m_sample_index( 0 ), m_missed_deadlines( 0 ) {}
+
+CFmDeviceBackend::~CFmDeviceBackend() {}
+
+bool CFmDeviceBackend::EnableFifo( int /*watermark*/ )
+{
+    return false;
+}
+
+bool CFmDeviceBackend::EnableDataReady( CFmDataReadyLine* line )
+{
+    m_data_ready.reset( line );
+    m_data_ready_ns = -1;
+    return line != nullptr;
+}
+
+double CFmDeviceBackend::GetClockSkewPpm() const
+{
+    return 0.0;
+}
+
+bool CFmDeviceBackend::HasDataReady() const
+{
+    return m_data_ready != nullptr;
+}
+
+int64_t CFmDeviceBackend::GetSampleTimeNs() const
+{
+    return m_data_ready && m_data_ready_ns >= 0 ? m_data_ready_ns : m_clock->now_ns();
+}
+
+void CFmDeviceBackend::SetClock( CFmClock& clock )
+{
+    m_clock = &clock;
+}
+
+CFmClock& CFmDeviceBackend::GetClock() const
+{
+    return *m_clock;
+}
+
+void CFmDeviceBackend::SetGridStep( int grid_step )
+{
+    m_grid_step = grid_step > 0 ? grid_step : 1;
+}
+
+int64_t CFmDeviceBackend::GetDeadline( int64_t index ) const
+{
+    return m_origin_ns + std::llround( static_cast< double >( index ) * m_grid_step * 1e9 / m_pace_rate );
+}
+
+void CFmDeviceBackend::WaitNextSample( bool is_first )
+{
+    if ( m_data_ready )
+    {
+        WaitDataReady( is_first );
+        return;
+    }
+    if ( m_pace_rate <= 0 )
+        return;
+
+    // 首次读取以当前时刻作为采样时间轴的起点
+    const int64_t now = m_clock->now_ns();
+    if ( is_first || ! m_grid_started )
+    {
+        m_origin_ns    = now;
+        m_sample_index = 0;
+        m_grid_started = true;
+    }
+
+    // 晚于再下一个采样时刻才到达时，跳过已错过的采样时刻并计数，时间轴保持不变，长期采样率不漂移
+    if ( now >= GetDeadline( m_sample_index + 1 ) )
+    {
+        const int64_t current = static_cast< int64_t >( static_cast< double >( now - m_origin_ns ) * m_pace_rate / ( 1e9 * m_grid_step ) );
+        if ( current > m_sample_index )
+        {
+            m_missed_deadlines += current - m_sample_index;
+            m_sample_index = current;
+        }
+    }
+
+    // 按绝对时刻睡眠
+    m_clock->sleep_until( GetDeadline( m_sample_index ) );
+
+    m_sample_index++;
+}
+
+void CFmDeviceBackend::WaitDataReady( bool is_first )
+{
+    // 阻塞等待数据就绪(或FIFO水位)边沿，超时时直接读取并计数，中断线异常时采集线程不会永久阻塞
+    const int64_t timeout = m_pace_rate > 0 ? std::llround( kDataReadyTimeoutPeriods * m_grid_step * 1e9 / m_pace_rate ) : kDataReadyTimeoutNs;
+    int64_t       timestamp;
+    const int     edges = m_data_ready->Wait( timeout, timestamp );
+    if ( edges <= 0 )
+    {
+        m_data_ready_ns = -1;
+        m_missed_deadlines++;
+        return;
+    }
+
+    // 积压多个边沿说明读取晚于下一个数据就绪时刻，寄存器模式下中间的采样点已被覆盖；首次读取前的积压不计
+    if ( ! is_first )
+        m_missed_deadlines += edges - 1;
+    m_data_ready_ns = timestamp >= 0 ? timestamp : m_clock->now_ns();
+}
+
+unsigned long long CFmDeviceBackend::GetMissedDeadlines() const
+{
+    return m_missed_deadlines;
+}
+
+PDRSensorData CFmDeviceBackend::NextWindow( unsigned long length )
+{
+    return m_ring.next_window( length );
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include "clock.h"
+#include "data_ready.h"
+#include "fm_device_wrapper.h"
+#include "sensor_ring.h"
+#include <cstdint>
+#include <memory>
+
+// 设备后端：fm_device_*接口背后的数据来源（I2C传感器、文件回放、合成数据），
+// 公共部分为采集缓存与按绝对时刻的采样节拍，派生类只负责产生采样点
+class CFmDeviceBackend
+{
+public:
+    // pace_rate为每秒读取的采样点数（实际时间），<=0表示不控制节拍
+    CFmDeviceBackend( double pace_rate );
+    virtual ~CFmDeviceBackend();
+
+    CFmDeviceBackend( const CFmDeviceBackend& )            = delete;
+    CFmDeviceBackend& operator=( const CFmDeviceBackend& ) = delete;
+
+    // 按节拍读取length个采样点写入sensor_data，返回实际读取的点数，回放数据读完时小于length
+    virtual unsigned long Read( PDRSensorData& sensor_data, unsigned long length, bool is_first ) = 0;
+    // 切换为FIFO突发读取，不支持的后端返回false
+    virtual bool EnableFifo( int watermark );
+    // 切换为中断驱动采集，之后每个采样时刻改为等待数据就绪边沿，取得line的所有权
+    virtual bool EnableDataReady( CFmDataReadyLine* line );
+    // 传感器时钟相对主机时钟的频率偏差（单位：ppm），没有独立传感器时钟的后端为0
+    virtual double GetClockSkewPpm() const;
+
+    // 取时与睡眠使用的时钟，默认为真实时钟
+    void      SetClock( CFmClock& clock );
+    CFmClock& GetClock() const;
+
+    PDRSensorData      NextWindow( unsigned long length );
+    void               WaitNextSample( bool is_first );
+    unsigned long long GetMissedDeadlines() const;
+protected:
+    // 每个采样时刻间隔的采样点数，FIFO模式下为水位帧数
+    void SetGridStep( int grid_step );
+    // 当前采样点的时刻（单位：纳秒），中断模式下为数据就绪边沿的时刻
+    int64_t GetSampleTimeNs() const;
+    bool    HasDataReady() const;
+private:
+    CFmSensorRing                       m_ring;           // 采集缓存，fm_device_read覆盖模式返回的数据指向其内部
+    CFmClock*                           m_clock;          // 取时与睡眠使用的时钟
+    std::unique_ptr< CFmDataReadyLine > m_data_ready;     // 数据就绪中断线，为空时按采样时刻睡眠
+    int64_t                             m_data_ready_ns;  // 最近一次边沿的时刻，-1表示超时未等到边沿
+
+    // 采样调度：第k个采样时刻为 起点 + k * 1e9 / 节拍（时钟的单调时间，单位：纳秒），睡眠误差与取整误差都不会累积
+    double             m_pace_rate;         // 节拍，<=0表示不控制节拍
+    int                m_grid_step;         // 每个采样时刻间隔的采样点数
+    bool               m_grid_started;      // 是否已确定时间轴起点
+    int64_t            m_origin_ns;         // 采样时间轴起点
+    int64_t            m_sample_index;      // 下一个采样时刻的序号
+    unsigned long long m_missed_deadlines;  // 错过而跳过的采样时刻数，FIFO模式下为轮询时刻数（帧仍缓存在FIFO中，不丢数据）；中断模式下为合并的边沿数与等待超时次数
+
+    int64_t GetDeadline( int64_t index ) const;
+    void    WaitDataReady( bool is_first );
+};
\ No newline at end of file
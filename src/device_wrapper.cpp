@@ -1,14 +1,15 @@
 #include "device_wrapper.h"
-#include <chrono>
 #include <cstdint>
-#include <thread>
 
 const std::string i2cDevice         = "/dev/i2c-1";
 uint8_t           deviceAddress_mmc = 0x30;
 uint8_t           deviceAddress_imu = 0x69;
 
-CFmDeviceWrapper::CFmDeviceWrapper( int sample_rate ) : m_start_time_ms( 0 )
+CFmDeviceWrapper::CFmDeviceWrapper( int sample_rate )
+    : CFmDeviceBackend( sample_rate ), m_start_time_ms( 0 ), m_warming_up( true ), m_fifo_enabled( false ), m_fifo_count( 0 ), m_fifo_offset( 0 ), m_fifo_timestamp_valid( false ), m_fifo_last_timestamp( 0 ), m_fifo_time_us( 0 ), m_fifo_mag_time( 0.0 ), m_fifo_last_time( 0.0 )
 {
+    m_fifo_mag[ 0 ] = m_fifo_mag[ 1 ] = m_fifo_mag[ 2 ] = 0.0;
+
     // Initializing the MMC56x3
     if ( ! m_sensor_mmc.begin( deviceAddress_mmc, i2cDevice.c_str() ) )
         throw std::invalid_argument( "Failed to initialize MMC56x3 sensor" );
@@ -24,20 +25,54 @@ CFmDeviceWrapper::CFmDeviceWrapper( int sample_rate ) : m_start_time_ms( 0 )
     m_sensor_imu.startAccel( sample_rate, 16 );
     // Gyro ODR = sample_rate(Hz) and Full Scale Range = 2000 dps
     m_sensor_imu.startGyro( sample_rate, 2000 );
-
-    // Wait IMU to start
-    std::this_thread::sleep_for( std::chrono::milliseconds( 1000 ) );
 }
 
 CFmDeviceWrapper::~CFmDeviceWrapper() {}
 
 int64_t CFmDeviceWrapper::GetMicrosecondTimestamp()
 {
-    auto now = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast< std::chrono::microseconds >( now.time_since_epoch() ).count();
+    return GetSampleTimeNs() / 1000;
+}
+
+unsigned long CFmDeviceWrapper::Read( PDRSensorData& sensor_data, unsigned long length, bool is_first )
+{
+    // 等待IMU启动稳定，放在首次读取时而不是构造时，初始化后设置的时钟同样生效
+    if ( m_warming_up )
+    {
+        GetClock().sleep_for( 1000000000LL );
+        m_warming_up = false;
+    }
+
+    if ( m_fifo_enabled )
+    {
+        // FIFO模式：缓存中的帧用完后等待一个水位的时长，再一次突发读出FIFO中的全部帧
+        unsigned long filled = 0;
+        while ( filled < length )
+        {
+            if ( is_first || ! HasFifoFrames() )
+                WaitNextSample( is_first );
+
+            filled += ReadFifoBatch( sensor_data, filled, length - filled, is_first );
+            sensor_data.length = filled;
+            is_first           = false;
+        }
+        return filled;
+    }
+
+    for ( unsigned long i = 0; i < length; ++i )
+    {
+        // 等待到下一个绝对采样时刻再读取
+        WaitNextSample( is_first );
+
+        int64_t timestamp = 0;
+        ReadData( sensor_data, i, is_first, timestamp );
+        sensor_data.length = i + 1;
+        is_first           = false;
+    }
+    return length;
 }
 
-bool CFmDeviceWrapper::ReadData( SensorData& sensor_data, unsigned long index, bool is_first, int64_t& timestamp )
+bool CFmDeviceWrapper::ReadData( PDRSensorData& sensor_data, unsigned long index, bool is_first, int64_t& timestamp )
 {
     timestamp = GetMicrosecondTimestamp();
     if ( is_first )
@@ -48,31 +83,197 @@ bool CFmDeviceWrapper::ReadData( SensorData& sensor_data, unsigned long index, b
     // TDK42607
     inv_imu_sensor_event_t imu_event;
     float                  x, y, z;
-    const double           gravity = 9.8035f;
 
-    m_sensor_imu.getDataFromRegisters( imu_event );
+    // 两个传感器在同一总线上且磁力计为连续测量模式时，IMU与磁力计的数据寄存器合并为一次I2C_RDWR传输
+    I2CBusRead reads[ ICM42670_DATA_READS + 1 ];
+    int64_t    mag_read_us = 0;
+    bool       mag_ok      = false;
+    if ( m_sensor_imu.i2c_bus && m_sensor_imu.i2c_bus == m_sensor_mmc.bus() && m_sensor_mmc.prepareEventRead( reads[ ICM42670_DATA_READS ] )
+         && ICM42670_DATA_READS == m_sensor_imu.prepareDataReads( reads ) )
+    {
+        mag_read_us = GetClock().now_ns() / 1000;
+        mag_ok      = m_sensor_imu.i2c_bus->readBatch( reads, ICM42670_DATA_READS + 1 );
+        if ( mag_ok )
+        {
+            m_sensor_imu.decodeDataReads( imu_event );
+            m_sensor_mmc.decodeEvent( x, y, z );
+        }
+        FillImuSample( sensor_data, index, duration, imu_event );
+    }
+    else
+    {
+        m_sensor_imu.getDataFromRegisters( imu_event );
+        FillImuSample( sensor_data, index, duration, imu_event );
 
-    sensor_data.sensor_data.acc_time[ index ] = duration;
-    sensor_data.sensor_data.acc_x[ index ]    = gravity * imu_event.accel[ 0 ] / 2048.0;
-    sensor_data.sensor_data.acc_y[ index ]    = gravity * imu_event.accel[ 1 ] / 2048.0;
-    sensor_data.sensor_data.acc_z[ index ]    = gravity * imu_event.accel[ 2 ] / 2048.0;
-    sensor_data.sensor_data.gyr_time[ index ] = duration;
-    sensor_data.sensor_data.gyr_x[ index ]    = imu_event.gyro[ 0 ] / 16.4;
-    sensor_data.sensor_data.gyr_y[ index ]    = imu_event.gyro[ 1 ] / 16.4;
-    sensor_data.sensor_data.gyr_z[ index ]    = imu_event.gyro[ 2 ] / 16.4;
-
-    // MMC56x3
-    if ( ! m_sensor_mmc.getEvent( x, y, z ) )
+        // MMC56x3，磁力计的采样时刻与IMU不同，单独换算
+        mag_read_us = GetClock().now_ns() / 1000;
+        mag_ok      = m_sensor_mmc.getEvent( x, y, z );
+    }
+    if ( ! mag_ok )
         return false;
 
-    sensor_data.sensor_data.mag_time[ index ] = duration;
-    sensor_data.sensor_data.mag_x[ index ]    = x;
-    sensor_data.sensor_data.mag_y[ index ]    = y;
-    sensor_data.sensor_data.mag_z[ index ]    = z;
+    sensor_data.mag_time[ index ] = GetMagnetometerTime( mag_read_us );
+    sensor_data.mag_x[ index ]    = x;
+    sensor_data.mag_y[ index ]    = y;
+    sensor_data.mag_z[ index ]    = z;
 
     // // 计算模长
     // double magnitude = std::sqrt(x * x + y * y + z * z);
     // std::cout << "Magnetometer (uT): X=" << x << " Y=" << y << " Z=" << z << " Magnitude=" << magnitude << std::endl;
 
     return true;
+}
+
+void CFmDeviceWrapper::FillImuSample( PDRSensorData& sensor_data, unsigned long index, double duration, const inv_imu_sensor_event_t& imu_event )
+{
+    const double gravity = 9.8035f;
+
+    sensor_data.acc_time[ index ] = duration;
+    sensor_data.acc_x[ index ]    = gravity * imu_event.accel[ 0 ] / 2048.0;
+    sensor_data.acc_y[ index ]    = gravity * imu_event.accel[ 1 ] / 2048.0;
+    sensor_data.acc_z[ index ]    = gravity * imu_event.accel[ 2 ] / 2048.0;
+    sensor_data.gyr_time[ index ] = duration;
+    sensor_data.gyr_x[ index ]    = imu_event.gyro[ 0 ] / 16.4;
+    sensor_data.gyr_y[ index ]    = imu_event.gyro[ 1 ] / 16.4;
+    sensor_data.gyr_z[ index ]    = imu_event.gyro[ 2 ] / 16.4;
+}
+
+bool CFmDeviceWrapper::EnableFifo( int watermark )
+{
+    // 水位寄存器按帧计数，取值范围1~255，且不能超过FIFO镜像缓存的容量
+    if ( watermark <= 0 || watermark > 255 || watermark > ICM42670_FIFO_MAX_FRAMES )
+        return false;
+
+    if ( 0 != m_sensor_imu.startFifo( static_cast< uint8_t >( watermark ) ) )
+        return false;
+
+    // 每个采样时刻对应一个水位，轮询间隔为水位帧数的采样周期
+    m_fifo_enabled = true;
+    m_fifo_count   = 0;
+    m_fifo_offset  = 0;
+    SetGridStep( watermark );
+
+    // 已是中断模式时改为在水位达到时触发
+    if ( HasDataReady() && 0 != m_sensor_imu.routeDataReadyInt1( true ) )
+        return false;
+    return true;
+}
+
+bool CFmDeviceWrapper::EnableDataReady( CFmDataReadyLine* line )
+{
+    // 逐点读取时INT1输出数据就绪，FIFO模式下输出水位中断
+    if ( ! line || 0 != m_sensor_imu.routeDataReadyInt1( m_fifo_enabled ) )
+    {
+        delete line;
+        return false;
+    }
+    return CFmDeviceBackend::EnableDataReady( line );
+}
+
+double CFmDeviceWrapper::GetMagnetometerTime( int64_t read_us )
+{
+    // 连续测量模式下读到的是最近一次完成的测量，平均早于读取时刻半个测量周期；触发模式下在读取时开始测量
+    double       age = 0.0;
+    const double odr = m_sensor_mmc.getDataRate();
+    if ( m_sensor_mmc.isContinuousMode() && odr > 0 )
+        age = 0.5 / odr;
+
+    const double time = static_cast< double >( read_us - m_start_time_ms ) / 1000000.0 - age;
+    return time > 0.0 ? time : 0.0;
+}
+
+double CFmDeviceWrapper::GetClockSkewPpm() const
+{
+    return m_timestamps.GetSkewPpm();
+}
+
+bool CFmDeviceWrapper::HasFifoFrames() const
+{
+    return m_fifo_offset < m_fifo_count;
+}
+
+int CFmDeviceWrapper::ReadFifoFrames()
+{
+    // 一次突发读出FIFO中的全部帧，未达到水位时返回0
+    const int count = m_sensor_imu.getBatchFromFifo( m_fifo_frames, ICM42670_FIFO_MAX_FRAMES );
+    if ( count <= 0 )
+        return 0;
+    const int64_t read_ns = GetClock().now_ns();
+
+    // 16位帧时间戳按相邻帧的差值展开回绕
+    for ( int i = 0; i < count; ++i )
+    {
+        const inv_imu_sensor_event_t& frame = m_fifo_frames[ i ];
+        if ( m_fifo_timestamp_valid )
+            m_fifo_time_us += static_cast< int64_t >( static_cast< uint16_t >( frame.timestamp_fsync - m_fifo_last_timestamp ) ) * m_sensor_imu.fifo_timestamp_us;
+        m_fifo_last_timestamp  = frame.timestamp_fsync;
+        m_fifo_timestamp_valid = true;
+        m_fifo_frame_us[ i ]   = m_fifo_time_us;
+    }
+
+    // 最新一帧在读取完成之前写入FIFO，以读取完成时刻作为它的主机时间观测，首批的首帧作为时间零点
+    const bool first_batch = ! m_timestamps.IsValid();
+    m_timestamps.Observe( m_fifo_frame_us[ count - 1 ], read_ns );
+    if ( first_batch )
+    {
+        m_start_time_ms  = m_timestamps.ToHost( m_fifo_frame_us[ 0 ] ) / 1000;
+        m_fifo_last_time = 0.0;
+    }
+
+    // 磁力计没有FIFO，每批读取一次，本批次的各帧共用，采样时间按磁力计自身的测量周期换算
+    float         x, y, z;
+    const int64_t mag_read_us = GetClock().now_ns() / 1000;
+    if ( m_sensor_mmc.getEvent( x, y, z ) )
+    {
+        m_fifo_mag[ 0 ] = x;
+        m_fifo_mag[ 1 ] = y;
+        m_fifo_mag[ 2 ] = z;
+        m_fifo_mag_time = GetMagnetometerTime( mag_read_us );
+    }
+
+    m_fifo_count  = count;
+    m_fifo_offset = 0;
+    return count;
+}
+
+unsigned long CFmDeviceWrapper::ReadFifoBatch( PDRSensorData& sensor_data, unsigned long index, unsigned long max_count, bool is_first )
+{
+    if ( is_first )
+    {
+        // 丢弃上次读取遗留的帧，时间从首帧开始计
+        m_sensor_imu.resetFifo();
+        m_fifo_count           = 0;
+        m_fifo_offset          = 0;
+        m_fifo_timestamp_valid = false;
+        m_fifo_time_us         = 0;
+        m_timestamps.Reset();
+    }
+
+    if ( ! HasFifoFrames() && ReadFifoFrames() <= 0 )
+        return 0;
+
+    unsigned long filled = 0;
+    while ( filled < max_count && HasFifoFrames() )
+    {
+        const int               k     = m_fifo_offset++;
+        inv_imu_sensor_event_t& frame = m_fifo_frames[ k ];
+        if ( ! m_sensor_imu.isAccelDataValid( &frame ) || ! m_sensor_imu.isGyroDataValid( &frame ) )
+            continue;
+
+        // 帧时间戳按估计的时钟映射换算为主机时间，映射更新时保持时间单调
+        double duration = static_cast< double >( m_timestamps.ToHost( m_fifo_frame_us[ k ] ) / 1000 - m_start_time_ms ) / 1000000.0;
+        if ( duration < m_fifo_last_time )
+            duration = m_fifo_last_time;
+        m_fifo_last_time = duration;
+
+        const unsigned long i = index + filled;
+        FillImuSample( sensor_data, i, duration, frame );
+        sensor_data.mag_time[ i ] = m_fifo_mag_time;
+        sensor_data.mag_x[ i ]    = m_fifo_mag[ 0 ];
+        sensor_data.mag_y[ i ]    = m_fifo_mag[ 1 ];
+        sensor_data.mag_z[ i ]    = m_fifo_mag[ 2 ];
+        filled++;
+    }
+
+    return filled;
 }
\ No newline at end of file
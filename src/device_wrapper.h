@@ -1,19 +1,47 @@
 #include "MMC56x3/MMC56x3.h"
 #include "TDK40607P/ICM42670P.h"
-#include "fm_device_wrapper.h"
+#include "device_backend.h"
+#include "timestamp_reconstructor.h"
 #include <cstddef>
 
-class CFmDeviceWrapper
+// I2C传感器后端：ICM42670(加速度计、陀螺仪)与MMC56x3(磁力计)
+class CFmDeviceWrapper : public CFmDeviceBackend
 {
 public:
     CFmDeviceWrapper( int sample_rate );
     ~CFmDeviceWrapper();
 
+    unsigned long Read( PDRSensorData& sensor_data, unsigned long length, bool is_first ) override;
+    bool          EnableFifo( int watermark ) override;
+    bool          EnableDataReady( CFmDataReadyLine* line ) override;
+    double        GetClockSkewPpm() const override;
+
     int64_t GetMicrosecondTimestamp();
-    bool    ReadData( SensorData& sensor_data, unsigned long index, bool is_first, int64_t& timestamp );
 private:
     MMC56x3  m_sensor_mmc;
     ICM42670 m_sensor_imu;
 
-    int64_t         m_start_time_ms;
+    int64_t m_start_time_ms;
+    bool    m_warming_up;  // 传感器启动后尚未等待稳定
+
+    // FIFO突发读取：每次达到水位后一次读出全部帧，帧时间取自传感器的FIFO时间戳
+    bool                      m_fifo_enabled;
+    inv_imu_sensor_event_t    m_fifo_frames[ ICM42670_FIFO_MAX_FRAMES ];     // 最近一次读出的帧
+    int64_t                   m_fifo_frame_us[ ICM42670_FIFO_MAX_FRAMES ];   // 各帧展开回绕后的传感器时间（单位：微秒）
+    int                       m_fifo_count;                                  // 最近一次读出的帧数
+    int                       m_fifo_offset;                                 // 下一个待输出的帧
+    bool                      m_fifo_timestamp_valid;                        // 是否已有上一帧的时间戳
+    uint16_t                  m_fifo_last_timestamp;                         // 上一帧的16位时间戳
+    int64_t                   m_fifo_time_us;                                // 展开回绕后相对首帧的时间（单位：微秒）
+    double                    m_fifo_mag[ 3 ];                               // 本批次读取的磁力计数据
+    double                    m_fifo_mag_time;                               // 本批次磁力计数据的采样时间
+    double                    m_fifo_last_time;                              // 上一帧输出的采样时间，保证时间单调
+    CFmTimestampReconstructor m_timestamps;                                  // FIFO帧时间戳到主机时间的映射
+
+    bool          ReadData( PDRSensorData& sensor_data, unsigned long index, bool is_first, int64_t& timestamp );
+    bool          HasFifoFrames() const;
+    int           ReadFifoFrames();
+    double        GetMagnetometerTime( int64_t read_us );
+    unsigned long ReadFifoBatch( PDRSensorData& sensor_data, unsigned long index, unsigned long max_count, bool is_first );
+    void          FillImuSample( PDRSensorData& sensor_data, unsigned long index, double duration, const inv_imu_sensor_event_t& imu_event );
 };
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "direction_predictor.h"
 #include "fm_pdr.h"
+#include "heading_kernel.h"
 #include <algorithm>
 
-CFmDirectionPredictor::CFmDirectionPredictor( const PDRConfig& config ) : m_config(config)
+CFmDirectionPredictor::CFmDirectionPredictor( const PDRConfig& config ) : m_config(config), m_stream_filter( 6, config.butter_wn, config.butter_lookahead )
 {
     // f.setup(sampling_rate, cutoff_freq);
     m_f.setupN( config.butter_wn );
@@ -11,7 +12,7 @@ CFmDirectionPredictor::CFmDirectionPredictor( const PDRConfig& config ) : m_conf
 CFmDirectionPredictor::~CFmDirectionPredictor() {}
 
 // 实现零相位滤波 (Eigen版本)
-Eigen::VectorXd CFmDirectionPredictor::filtfilt( Iir::Butterworth::LowPass< 2, Iir::DirectFormII >& filter, const Eigen::VectorXd& input )
+Eigen::VectorXd CFmDirectionPredictor::filtfilt( Iir::Butterworth::LowPass< 2, Iir::DirectFormII >& filter, const ConstVectorRef& input )
 {
     const int N = input.size();
     if ( N < 3 )
@@ -86,18 +87,46 @@ void CFmDirectionPredictor::butterworth_filter( const CFmDataManager& data, Matr
     grv.col( 2 ) = g_z;
 }
 
+void CFmDirectionPredictor::stream_filter( const CFmDataManager& data, bool is_last, MatrixXd& mag, MatrixXd& grv )
+{
+    // 通道0~2为磁力计，3~5为重力；各通道输入点数相同，输出点数也相同
+    const PDRDataField fields[ 6 ] = { PDR_DATA_FIELD_MAG_X, PDR_DATA_FIELD_MAG_Y, PDR_DATA_FIELD_MAG_Z, PDR_DATA_FIELD_GRV_X, PDR_DATA_FIELD_GRV_Y, PDR_DATA_FIELD_GRV_Z };
+    VectorXd           output[ 6 ];
+    for ( int channel = 0; channel < 6; ++channel )
+    {
+        output[ channel ] = m_stream_filter.process( channel, data.get_pdr_data( fields[ channel ] ) );
+
+        // 最后一批数据输出所有等待前视的点
+        if ( is_last )
+        {
+            VectorXd rest = m_stream_filter.flush( channel );
+            VectorXd all( output[ channel ].size() + rest.size() );
+            all << output[ channel ], rest;
+            output[ channel ].swap( all );
+        }
+    }
+
+    const Eigen::Index rows = output[ 0 ].size();
+    mag.resize( rows, 3 );
+    grv.resize( rows, 3 );
+    for ( int k = 0; k < 3; ++k )
+    {
+        mag.col( k ) = output[ k ];
+        grv.col( k ) = output[ k + 3 ];
+    }
+}
+
 Eigen::MatrixXd CFmDirectionPredictor::calc_east_vector( const MatrixXd& mag, const MatrixXd& grv, const int& rows )
 {
     const int       k_cols = 3;
     Eigen::MatrixXd e( rows, k_cols );
 
-    for ( int i = 0; i < rows; ++i )
-    {
-        Eigen::Vector3d m_vec = mag.row( i );                      // 提取磁场向量
-        Eigen::Vector3d g_vec = grv.row( i );                      // 提取重力向量
-        e.row( i )            = g_vec.cross( m_vec ).transpose();  // 叉乘得到东向量
-        // cout << "m_vec: [" << m_vec[ 0 ] << "," << m_vec[ 1 ]  << "," << m_vec[ 2 ] << "], g_vec: [" << g_vec[ 0 ]  << "," << g_vec[ 1 ] << "," << g_vec[ 2 ] << "], e: [" << e.row( i )[0] << "," << e.row( i )[1] << "," << e.row( i )[2] << "]" << endl;
-    }
+    // 按列叉乘得到东向量 e = g × m（各列连续存放，逐行取向量会跨列跳跃访问）
+    auto m = mag.topRows( rows ).array();
+    auto g = grv.topRows( rows ).array();
+    e.col( 0 ) = ( g.col( 1 ) * m.col( 2 ) - g.col( 2 ) * m.col( 1 ) ).matrix();
+    e.col( 1 ) = ( g.col( 2 ) * m.col( 0 ) - g.col( 0 ) * m.col( 2 ) ).matrix();
+    e.col( 2 ) = ( g.col( 0 ) * m.col( 1 ) - g.col( 1 ) * m.col( 0 ) ).matrix();
 
     return e;
 }
@@ -116,6 +145,9 @@ StartInfo CFmDirectionPredictor::start( const CFmDataManager& start_data, const
     MatrixXd     grv( data_rows, k_cols );
     butterworth_filter( start_data, mag, grv );
 
+    // 重新开始推算，流式滤波从下一批数据的首个点重新建立稳态
+    m_stream_filter.reset();
+
     // 计算前m_config.default_east_point行东向量
     int             number_of_point = std::min( k_rows, ( int )data_rows );
     Eigen::MatrixXd e               = calc_east_vector( mag, grv, number_of_point );
@@ -125,9 +157,9 @@ StartInfo CFmDirectionPredictor::start( const CFmDataManager& start_data, const
 
     // 计算前least_point个点平均方向作为计算初始direction
     // 计算与北方向的角度（0°=北，90°=东），角度规范化到 [0, 360) 范围
-    const int       sample_count        = std::min( least_point, ( int )data_rows ) - 1;  // 取前least_point段位移
-    const VectorXd& magnetometer_data_x = start_data.get_pdr_data( PDR_DATA_FIELD_MAG_X );
-    const VectorXd& magnetometer_data_y = start_data.get_pdr_data( PDR_DATA_FIELD_MAG_Y );
+    const int      sample_count        = std::min( least_point, ( int )data_rows ) - 1;  // 取前least_point段位移
+    ConstVectorRef magnetometer_data_x = start_data.get_pdr_data( PDR_DATA_FIELD_MAG_X );
+    ConstVectorRef magnetometer_data_y = start_data.get_pdr_data( PDR_DATA_FIELD_MAG_Y );
 
     Eigen::Vector2d avg_delta( 0, 0 );
 
@@ -147,60 +179,30 @@ StartInfo CFmDirectionPredictor::start( const CFmDataManager& start_data, const
     return { no_opt_e0.x(), no_opt_e0.y(), no_opt_e0.z(), no_opt_direction0 };
 }
 
-Eigen::VectorXd CFmDirectionPredictor::predict_direction( const StartInfo& start_info, const CFmDataManager& process_data )
+Eigen::VectorXd CFmDirectionPredictor::predict_direction( const StartInfo& start_info, const CFmDataManager& process_data, bool is_last )
 {
     // 必须有两个及以上点才能计算方向
     const size_t mag_rows = process_data.get_pdr_data_size();
     if ( mag_rows <= 0 )
         throw std::invalid_argument( "Input data length must be greater than 0" );
 
-    const int    k_cols = 3;
-    Eigen::Index rows   = mag_rows;
-    MatrixXd     mag( rows, k_cols );
-    MatrixXd     grv( rows, k_cols );
-    butterworth_filter( process_data, mag, grv );  // TODO: 第一次送过来的数据进行了2次巴特沃斯滤波
-
-    // 计算所有行东向量
-    Eigen::MatrixXd e = calc_east_vector( mag, grv, rows );
+    // 流式滤波输出的点比输入滞后，行数为本批可输出的点数
+    MatrixXd mag;
+    MatrixXd grv;
+    stream_filter( process_data, is_last, mag, grv );
+    const Eigen::Index rows = mag.rows();
 
-    // 求出所有东向量和初始东向量的角度
-    Vector3d no_opt_e0( start_info.e0_x, start_info.e0_y, start_info.e0_z );
-    double   norm_e0 = no_opt_e0.norm();
-    VectorXd no_opt_angles( rows );
-    VectorXd no_opt_signs( rows );
-
-    for ( int i = 0; i < rows; ++i )
-    {
-        // 显式创建固定大小向量
-        Vector3d current_e( e.row( i )[ 0 ], e.row( i )[ 1 ], e.row( i )[ 2 ] );
-        Vector3d current_g( grv.row( i )[ 0 ], grv.row( i )[ 1 ], grv.row( i )[ 2 ] );
-
-        // 角度计算
-        double dot_val     = current_e.dot( no_opt_e0 );
-        double norm_ei     = current_e.norm();
-        double cos_angle   = dot_val / ( norm_ei * norm_e0 );
-        cos_angle          = std::max( -1.0, std::min( 1.0, cos_angle ) );
-        no_opt_angles[ i ] = std::acos( cos_angle ) * 180.0 / M_PI;
-
-        // 叉积和点积计算
-        Vector3d cross_vec = current_e.cross( no_opt_e0 );
-        double   dot_cg    = cross_vec.dot( current_g );
-
-        no_opt_signs[ i ] = ( ( dot_cg > 0 ) ? -1.0 : ( dot_cg < 0 ) ? 1.0 : 0.0 );
-
-        // cout << "no_opt_angles: " << no_opt_angles[ i ] << ", no_opt_signs: " << no_opt_signs[ i ] << endl;
-    }
-
-    // 计算预测方向并取模
-    VectorXd no_opt_direction_pred = no_opt_signs.cwiseProduct( no_opt_angles ).array() + start_info.direction0;
-
-    // 取模360并处理负值
-    no_opt_direction_pred = no_opt_direction_pred.unaryExpr(
-        []( double x )
-        {
-            x = std::fmod( x, 360.0 );
-            return ( x < 0 ) ? x + 360.0 : x;
-        } );
+    // 一次遍历计算所有行东向量、与初始东向量的角度及预测方向
+    const double  e0[ 3 ] = { start_info.e0_x, start_info.e0_y, start_info.e0_z };
+    const double* m[ 3 ]  = { mag.col( 0 ).data(), mag.col( 1 ).data(), mag.col( 2 ).data() };
+    const double* g[ 3 ]  = { grv.col( 0 ).data(), grv.col( 1 ).data(), grv.col( 2 ).data() };
+    VectorXd      no_opt_direction_pred( rows );
+    calc_heading_directions( m, g, rows, e0, start_info.direction0, no_opt_direction_pred.data() );
 
     return no_opt_direction_pred;
+}
+
+double CFmDirectionPredictor::calc_direction( const Eigen::Vector3d& e, const Eigen::Vector3d& g, const Eigen::Vector3d& e0, double direction0 )
+{
+    return calc_heading_direction( e.data(), g.data(), e0.data(), direction0 );
 }
\ No newline at end of file
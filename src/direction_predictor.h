@@ -1,6 +1,8 @@
+#pragma once
 #include "data_file_loader.h"
 #include "fm_pdr.h"
 #include "Iir.h"
+#include "stream_lowpass.h"
 
 typedef struct _StartInfo
 {
@@ -21,12 +23,18 @@ public:
     ~CFmDirectionPredictor();
 
     StartInfo       start( const CFmDataManager& start_data, const int least_point );
-    Eigen::VectorXd predict_direction( const StartInfo& start_info, const CFmDataManager& process_data );
+    // 返回流式滤波已输出的点的方向：接在上一批返回的点之后，比输入滞后；is_last为true时返回剩余的全部点
+    Eigen::VectorXd predict_direction( const StartInfo& start_info, const CFmDataManager& process_data, bool is_last = true );
+
+    // 根据单点东向量、重力向量与初始东向量计算行进方向（单位：度，范围[0, 360)）
+    static double calc_direction( const Eigen::Vector3d& e, const Eigen::Vector3d& g, const Eigen::Vector3d& e0, double direction0 );
 private:
     const PDRConfig& m_config;
     Iir::Butterworth::LowPass< 2, Iir::DirectFormII > m_f;
+    CFmStreamLowPass                                  m_stream_filter;  // 推算阶段使用的流式滤波，状态在各窗口之间保持
 
-    VectorXd        filtfilt( Iir::Butterworth::LowPass< 2, Iir::DirectFormII >& filter, const VectorXd& input );
+    VectorXd        filtfilt( Iir::Butterworth::LowPass< 2, Iir::DirectFormII >& filter, const ConstVectorRef& input );
     void            butterworth_filter( const CFmDataManager& data, MatrixXd& mag, MatrixXd& grv );
+    void            stream_filter( const CFmDataManager& data, bool is_last, MatrixXd& mag, MatrixXd& grv );
     Eigen::MatrixXd calc_east_vector( const MatrixXd& mag, const MatrixXd& grv, const int& rows );
 };
\ No newline at end of file
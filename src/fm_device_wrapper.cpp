@@ -1,10 +1,10 @@
 #include "fm_device_wrapper.h"
 #include "device_wrapper.h"
+#include "replay_device.h"
+#include "synthetic_device.h"
 #include <cstdint>
 #include <memory.h>
 #include <stdexcept>
-#include <chrono>
-#include <thread>
 
 int fm_device_init( int sample_rate, fm_device_handle_t* device_handle )
 {
@@ -23,68 +23,126 @@ int fm_device_init( int sample_rate, fm_device_handle_t* device_handle )
     }
 }
 
+int fm_device_init_replay( const char* data_path, int sample_rate, double speed, int loop, fm_device_handle_t* device_handle )
+{
+    if ( ! device_handle || ! data_path )
+        return -1;
+
+    try
+    {
+        device_handle->handler     = new CFmReplayDevice( data_path, sample_rate, speed, loop != 0 );
+        device_handle->sample_rate = sample_rate;
+        return 0;
+    }
+    catch ( const std::exception& e )
+    {
+        return -1;
+    }
+}
+
+int fm_device_init_synthetic( int sample_rate, double speed, fm_device_handle_t* device_handle )
+{
+    if ( ! device_handle )
+        return -1;
+
+    try
+    {
+        device_handle->handler     = new CFmSyntheticDevice( sample_rate, speed );
+        device_handle->sample_rate = sample_rate;
+        return 0;
+    }
+    catch ( const std::exception& e )
+    {
+        return -1;
+    }
+}
+
 int fm_device_read( fm_device_handle_t device_handle, int is_first, int count, int rewrite, SensorData* data )
 {
     if ( ! device_handle.handler || ! data )
         return -1;
 
-    memset( data, 0x00, sizeof( SensorData ) );
+    CFmDeviceBackend*   device = static_cast< CFmDeviceBackend* >( device_handle.handler );
+    const unsigned long length = static_cast< unsigned long >( count > 0 ? count : 1 );
 
     if ( rewrite )
-        fm_device_free_sensor_data( *data );
-
-    data->real_length = static_cast< unsigned long >( count > 0 ? count : 1 );
-    if ( ! data->sensor_data.acc_time )
-        data->sensor_data.acc_time = new double[ data->real_length ]();
-    if ( ! data->sensor_data.acc_x )
-        data->sensor_data.acc_x = new double[ data->real_length ]();
-    if ( ! data->sensor_data.acc_y )
-        data->sensor_data.acc_y = new double[ data->real_length ]();
-    if ( ! data->sensor_data.acc_z )
-        data->sensor_data.acc_z = new double[ data->real_length ]();
-    if ( ! data->sensor_data.lacc_time )
-        data->sensor_data.lacc_time = new double[ data->real_length ]();
-    if ( ! data->sensor_data.lacc_x )
-        data->sensor_data.lacc_x = new double[ data->real_length ]();
-    if ( ! data->sensor_data.lacc_y )
-        data->sensor_data.lacc_y = new double[ data->real_length ]();
-    if ( ! data->sensor_data.lacc_z )
-        data->sensor_data.lacc_z = new double[ data->real_length ]();
-    if ( ! data->sensor_data.gyr_time )
-        data->sensor_data.gyr_time = new double[ data->real_length ]();
-    if ( ! data->sensor_data.gyr_x )
-        data->sensor_data.gyr_x = new double[ data->real_length ]();
-    if ( ! data->sensor_data.gyr_y )
-        data->sensor_data.gyr_y = new double[ data->real_length ]();
-    if ( ! data->sensor_data.gyr_z )
-        data->sensor_data.gyr_z = new double[ data->real_length ]();
-    if ( ! data->sensor_data.mag_time )
-        data->sensor_data.mag_time = new double[ data->real_length ]();
-    if ( ! data->sensor_data.mag_x )
-        data->sensor_data.mag_x = new double[ data->real_length ]();
-    if ( ! data->sensor_data.mag_y )
-        data->sensor_data.mag_y = new double[ data->real_length ]();
-    if ( ! data->sensor_data.mag_z )
-        data->sensor_data.mag_z = new double[ data->real_length ]();
-
-    CFmDeviceWrapper* wrapper = static_cast< CFmDeviceWrapper* >( device_handle.handler );
-    for (unsigned long i = 0; i < data->real_length; ++i)
-    {
-        int64_t timestamp = 0;
-        wrapper->ReadData( *data, i, (bool)is_first, timestamp );
-        data->sensor_data.length = i + 1;
-        is_first = 0;
-        
-        int64_t time_consuming = wrapper->GetMicrosecondTimestamp() - timestamp;
-        int64_t target_time = 1000000 / device_handle.sample_rate;
-        std::this_thread::sleep_for(std::chrono::microseconds(device_handle.sample_rate > 0 ? (target_time - time_consuming) : 0));
+    {
+        // 覆盖模式：直接写入设备句柄持有的环形缓存，稳态运行时不分配内存
+        data->sensor_data = device->NextWindow( length );
+        data->real_length = 0;
     }
+    else
+    {
+        // 重新创建内存，由调用者通过fm_device_free_sensor_data释放
+        memset( data, 0x00, sizeof( SensorData ) );
+        data->real_length = length;
 
-    return 0;
+        double** fields[ CFmSensorRing::kColumns ] = { &data->sensor_data.acc_time, &data->sensor_data.acc_x, &data->sensor_data.acc_y, &data->sensor_data.acc_z, &data->sensor_data.lacc_time, &data->sensor_data.lacc_x, &data->sensor_data.lacc_y, &data->sensor_data.lacc_z,
+                                                       &data->sensor_data.gyr_time, &data->sensor_data.gyr_x, &data->sensor_data.gyr_y, &data->sensor_data.gyr_z, &data->sensor_data.mag_time, &data->sensor_data.mag_x, &data->sensor_data.mag_y, &data->sensor_data.mag_z };
+        for ( int k = 0; k < CFmSensorRing::kColumns; ++k )
+            *fields[ k ] = new double[ length ]();
+    }
+
+    // 按节拍读取，回放数据读完时返回读到的部分
+    data->sensor_data.length = device->Read( data->sensor_data, length, ( bool )is_first );
+    return data->sensor_data.length == length ? 0 : FM_DEVICE_END_OF_DATA;
+}
+
+int fm_device_enable_fifo( fm_device_handle_t device_handle, int watermark )
+{
+    if ( ! device_handle.handler )
+        return -1;
+
+    return static_cast< CFmDeviceBackend* >( device_handle.handler )->EnableFifo( watermark ) ? 0 : -1;
+}
+
+int fm_device_enable_data_ready( fm_device_handle_t device_handle, const char* chip_path, unsigned int line_offset )
+{
+    if ( ! device_handle.handler || ! chip_path )
+        return -1;
+
+#ifdef FM_PDR_GPIOD
+    try
+    {
+        return static_cast< CFmDeviceBackend* >( device_handle.handler )->EnableDataReady( new CFmGpioDataReadyLine( chip_path, line_offset ) ) ? 0 : -1;
+    }
+    catch ( const std::exception& e )
+    {
+        return -1;
+    }
+#else
+    // 未以libgpiod构建，不支持GPIO中断线
+    ( void )line_offset;
+    return -1;
+#endif
+}
+
+int fm_device_enable_data_ready_eventfd( fm_device_handle_t device_handle, int* event_fd )
+{
+    if ( ! device_handle.handler || ! event_fd )
+        return -1;
+
+    try
+    {
+        CFmEventFdDataReadyLine* line = new CFmEventFdDataReadyLine();
+        const int                fd   = line->fd();
+        if ( ! static_cast< CFmDeviceBackend* >( device_handle.handler )->EnableDataReady( line ) )
+            return -1;
+        *event_fd = fd;
+        return 0;
+    }
+    catch ( const std::exception& e )
+    {
+        return -1;
+    }
 }
 
 void fm_device_free_sensor_data( SensorData data )
 {
+    // 覆盖模式读取的数据指向设备句柄内部的缓存，随设备反初始化释放
+    if ( data.real_length == 0 )
+        return;
+
     if (data.sensor_data.acc_time)
     {
         delete[] data.sensor_data.acc_time;
@@ -168,11 +226,58 @@ void fm_device_free_sensor_data( SensorData data )
     data.real_length = 0;
 }
 
+unsigned long long fm_device_get_missed_deadlines( fm_device_handle_t device_handle )
+{
+    if ( ! device_handle.handler )
+        return 0;
+
+    return static_cast< CFmDeviceBackend* >( device_handle.handler )->GetMissedDeadlines();
+}
+
+double fm_device_get_clock_skew_ppm( fm_device_handle_t device_handle )
+{
+    if ( ! device_handle.handler )
+        return 0.0;
+
+    return static_cast< CFmDeviceBackend* >( device_handle.handler )->GetClockSkewPpm();
+}
+
+fm_clock_handle_t fm_clock_create_simulated( long long start_ns )
+{
+    return new CFmSimulatedClock( start_ns );
+}
+
+void fm_clock_destroy( fm_clock_handle_t clock )
+{
+    delete static_cast< CFmSimulatedClock* >( clock );
+}
+
+long long fm_clock_now( fm_clock_handle_t clock )
+{
+    return clock ? static_cast< CFmSimulatedClock* >( clock )->now_ns() : CFmClock::real().now_ns();
+}
+
+void fm_clock_advance( fm_clock_handle_t clock, long long duration_ns )
+{
+    if ( clock )
+        static_cast< CFmSimulatedClock* >( clock )->advance( duration_ns );
+}
+
+int fm_device_set_clock( fm_device_handle_t device_handle, fm_clock_handle_t clock )
+{
+    if ( ! device_handle.handler )
+        return -1;
+
+    CFmDeviceBackend* device = static_cast< CFmDeviceBackend* >( device_handle.handler );
+    device->SetClock( clock ? *static_cast< CFmSimulatedClock* >( clock ) : CFmClock::real() );
+    return 0;
+}
+
 void fm_device_uninit( fm_device_handle_t device_handle )
 {
     if ( device_handle.handler )
     {
-        delete static_cast< CFmDeviceWrapper* >( device_handle.handler );
+        delete static_cast< CFmDeviceBackend* >( device_handle.handler );
         device_handle.handler = nullptr;
     }
 }
\ No newline at end of file
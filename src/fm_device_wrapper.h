@@ -10,12 +10,18 @@ extern "C" {
 
 #include "fm_pdr.h"
 
+/// 回放数据已读完（非循环回放时fm_device_read返回）
+#define FM_DEVICE_END_OF_DATA -2
+
 typedef struct _SensorData
 {
     PDRSensorData sensor_data;  ///< 传感器数据
-    unsigned long real_length;  ///< 表示实际缓存大小
+    unsigned long real_length;  ///< 表示实际缓存大小，为0时表示数据指向设备句柄内部的缓存，无需释放
 } SensorData;
 
+/// 时钟句柄，NULL表示真实时钟(CLOCK_MONOTONIC)
+typedef void* fm_clock_handle_t;
+
 typedef struct _fm_device_handle_t
 {
     void* handler;      ///< 设备句柄
@@ -23,30 +29,131 @@ typedef struct _fm_device_handle_t
 } fm_device_handle_t;
 
 /// @fn int fm_device_init( int sample_rate, fm_device_handle_t *device_handle )
-/// @brief 初始化设备
+/// @brief 初始化I2C传感器设备(ICM42670、MMC56x3)
 /// @param sample_rate [in] 传感器采样率
 /// @param device_handle [out] 设备句柄
 /// @return 0: 初始化成功
 ///         <0: 错误码
 int fm_device_init( int sample_rate, fm_device_handle_t* device_handle );
 
+/// @fn int fm_device_init_replay( const char* data_path, int sample_rate, double speed, int loop, fm_device_handle_t* device_handle )
+/// @brief 初始化回放设备，读取采集目录中的Accelerometer.csv、Gyroscope.csv、Magnetometer.csv(及可选的Linear Accelerometer.csv)，
+///        按采样率重采样后通过fm_device_read输出，无需传感器硬件即可运行实时推算流程
+/// @param data_path [in] 采集数据目录，如example/test_data/sensor_data
+/// @param sample_rate [in] 采样率
+/// @param speed [in] 回放倍速，1为实时，N为N倍速，<=0表示不控制节拍（尽快输出）
+/// @param loop [in] !=0表示读完后从头循环（时间戳继续递增），0表示读完后fm_device_read返回FM_DEVICE_END_OF_DATA
+/// @param device_handle [out] 设备句柄
+/// @return 0: 初始化成功
+///         <0: 错误码
+int fm_device_init_replay( const char* data_path, int sample_rate, double speed, int loop, fm_device_handle_t* device_handle );
+
+/// @fn int fm_device_init_synthetic( int sample_rate, double speed, fm_device_handle_t* device_handle )
+/// @brief 初始化合成数据设备，生成可复现的行走数据（固定步频，方向缓慢往复转动），用于压力测试
+/// @param sample_rate [in] 采样率
+/// @param speed [in] 输出倍速，1为实时，N为N倍速，<=0表示不控制节拍（尽快输出）
+/// @param device_handle [out] 设备句柄
+/// @return 0: 初始化成功
+///         <0: 错误码
+int fm_device_init_synthetic( int sample_rate, double speed, fm_device_handle_t* device_handle );
+
+/// @fn int fm_device_enable_fifo( fm_device_handle_t device_handle, int watermark )
+/// @brief 切换为FIFO突发读取模式，之后的fm_device_read每达到水位一次读出全部加速度计、陀螺仪帧，
+///        时间戳取自传感器FIFO帧时间戳，磁力计每批读取一次，总线与CPU开销按批计算而非按采样点计算，仅I2C设备支持
+/// @param device_handle [in] 设备句柄
+/// @param watermark [in] FIFO水位(帧数)，取值范围1~255
+/// @return 0: 设置成功
+///         <0: 错误码
+int fm_device_enable_fifo( fm_device_handle_t device_handle, int watermark );
+
+/// @fn int fm_device_enable_data_ready( fm_device_handle_t device_handle, const char* chip_path, unsigned int line_offset )
+/// @brief 切换为中断驱动采集：IMU的INT1接到GPIO，逐点读取时输出数据就绪、FIFO模式下输出水位中断，
+///        fm_device_read阻塞等待该引脚的上升沿(libgpiod)后读取，不再按采样时刻睡眠轮询，采样时间戳取自内核记录的边沿时刻；
+///        可使用gpio-sim模拟的中断线，须在fm_device_enable_fifo之后、首次读取之前调用；
+///        构建时未找到libgpiod v2(或FM_PDR_WITH_GPIOD=OFF)时不支持，返回错误
+/// @param device_handle [in] 设备句柄
+/// @param chip_path [in] GPIO芯片设备，如/dev/gpiochip0
+/// @param line_offset [in] 中断线在芯片内的编号
+/// @return 0: 设置成功
+///         <0: 错误码
+int fm_device_enable_data_ready( fm_device_handle_t device_handle, const char* chip_path, unsigned int line_offset );
+
+/// @fn int fm_device_enable_data_ready_eventfd( fm_device_handle_t device_handle, int* event_fd )
+/// @brief 以eventfd代替GPIO中断线切换为中断驱动采集，向event_fd写入8字节计数即模拟一次(或多次)数据就绪边沿，
+///        用于无硬件时(回放、合成数据)测试中断驱动的采集流程
+/// @param device_handle [in] 设备句柄
+/// @param event_fd [out] eventfd文件描述符，随设备反初始化关闭
+/// @return 0: 设置成功
+///         <0: 错误码
+int fm_device_enable_data_ready_eventfd( fm_device_handle_t device_handle, int* event_fd );
+
 /// @fn int fm_device_read(void *device_handle, int is_first, int count, int rewrite, SensorData data);
-/// @brief 读取传感器数据
+/// @brief 读取传感器数据，按采样率在绝对采样时刻(CLOCK_MONOTONIC)读取，睡眠误差不累积
 /// @param device_handle [in] 设备句柄
 /// @param is_first [in] 是否为首次读取，!=0表示是首次读取，0表示非首次读取
 /// @param count [in] 传感器采样时长(微秒)，大于0时表示采集数据个数，小于等于0时表示采集一次数据
 /// @param rewrite [in] 是否覆盖读取数据，!=0表示覆盖，0表示重新创建内存
-/// @param data [in] 读取的传感器数据
+///                    覆盖时数据写入设备句柄持有的环形缓存，data中的指针指向缓存内部，不分配内存，
+///                    数据在之后的3次覆盖读取期间保持有效，读取长度增大时之前的数据失效
+/// @param data [out] 读取的传感器数据
 /// @return 0: 读取成功
+///         FM_DEVICE_END_OF_DATA: 回放数据已读完，data中为读到的部分
 ///         <0: 错误码
 int fm_device_read( fm_device_handle_t device_handle, int is_first, int count, int rewrite, SensorData* data );
 
 /// @fn int fm_device_free_sensor_data(void *device_handle, SensorData data);
-/// @brief 释放传感器数据内存
+/// @brief 释放传感器数据内存，覆盖模式读取的数据无需释放（调用亦无影响）
 /// @param data [in] 读取的传感器数据
 /// @return 无
 void fm_device_free_sensor_data( SensorData data );
 
+/// @fn unsigned long long fm_device_get_missed_deadlines( fm_device_handle_t device_handle )
+/// @brief 取得错过的采样时刻数量，读取按绝对采样时刻调度，晚于下一个采样时刻才开始读取时跳过错过的采样时刻；
+///        中断驱动采集时为合并的边沿数与等待边沿超时的次数
+/// @param device_handle [in] 设备句柄
+/// @return 自首次读取以来跳过的采样点数
+unsigned long long fm_device_get_missed_deadlines( fm_device_handle_t device_handle );
+
+/// @fn double fm_device_get_clock_skew_ppm( fm_device_handle_t device_handle )
+/// @brief 取得估计的传感器时钟相对主机时钟(CLOCK_MONOTONIC)的频率偏差，FIFO模式下由帧时间戳与读取时刻估计，
+///        采样时间按该估计由帧时间戳换算，不受读取时刻调度抖动的影响
+/// @param device_handle [in] 设备句柄
+/// @return 频率偏差（单位：ppm），正值表示传感器时钟偏慢，未使用FIFO或尚无足够观测时为0
+double fm_device_get_clock_skew_ppm( fm_device_handle_t device_handle );
+
+/// @fn fm_clock_handle_t fm_clock_create_simulated( long long start_ns )
+/// @brief 创建模拟时钟：登记的线程都在睡眠时时间直接跳到最早的唤醒时刻，可在数秒内模拟数小时的实时运行，结果可复现
+/// @param start_ns [in] 起始时间（单位：纳秒）
+/// @return 时钟句柄
+fm_clock_handle_t fm_clock_create_simulated( long long start_ns );
+
+/// @fn void fm_clock_destroy( fm_clock_handle_t clock )
+/// @brief 销毁模拟时钟，须在使用它的设备反初始化之后调用
+/// @param clock [in] 时钟句柄
+/// @return 无
+void fm_clock_destroy( fm_clock_handle_t clock );
+
+/// @fn long long fm_clock_now( fm_clock_handle_t clock )
+/// @brief 取得时钟的当前时间
+/// @param clock [in] 时钟句柄，NULL表示真实时钟
+/// @return 当前时间（单位：纳秒）
+long long fm_clock_now( fm_clock_handle_t clock );
+
+/// @fn void fm_clock_advance( fm_clock_handle_t clock, long long duration_ns )
+/// @brief 模拟时钟前进指定时长，用于模拟计算耗时、调度延迟（如制造错过的采样时刻）；对真实时钟无效
+/// @param clock [in] 时钟句柄
+/// @param duration_ns [in] 前进的时长（单位：纳秒）
+/// @return 无
+void fm_clock_advance( fm_clock_handle_t clock, long long duration_ns );
+
+/// @fn int fm_device_set_clock( fm_device_handle_t device_handle, fm_clock_handle_t clock )
+/// @brief 设置设备取时、按采样时刻睡眠及启动等待使用的时钟，须在首次读取之前设置
+/// @param device_handle [in] 设备句柄
+/// @param clock [in] 时钟句柄，NULL表示真实时钟
+/// @return 0: 设置成功
+///         <0: 错误码
+int fm_device_set_clock( fm_device_handle_t device_handle, fm_clock_handle_t clock );
+
 /// @fn void fm_device_uninit( fm_device_handle_t device_handle )
 /// @brief 反初始化设备
 /// @param device_handle [in] 设备句柄
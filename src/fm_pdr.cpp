@@ -1,20 +1,32 @@
 #include "fm_pdr.h"
+#include "async_writer.h"
 #include "data_buffer_loader.h"
 #include "data_file_loader.h"
 #include "data_manager.h"
 #include "exception.h"
 #include "fm_device_wrapper.h"
+#include "gravity_estimator.h"
 #include "json_operator.h"
 // #include "magnetometer-calibration.h"
 #include "SixParametersCorrector.h"
 #include "SensorData.h"
+#include "clock.h"
+#include "csv_reader.h"
+#include "sensor_log.h"
+#include "sensor_record.h"
 #include "pdr.h"
+#include "spsc_queue.h"
+#include "stream_pdr.h"
 #include <Eigen/src/Core/Matrix.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <moodycamel/concurrentqueue.h>
 #include <sstream>
 #include <string>
@@ -30,27 +42,55 @@ typedef enum _FmPDRStatus
     PDR_RUNNING
 } FmPDRStatus;
 
+// 最近一次启动的推算模式，停止后保持不变，fm_pdr_predict据此取得剩余的位置点
+typedef enum _FmPDRMode
+{
+    PDR_MODE_NONE,    // 尚未启动或启动失败
+    PDR_MODE_FILE,    // fm_pdr_start_with_file
+    PDR_MODE_DEVICE,  // fm_pdr_start
+    PDR_MODE_PUSH,    // fm_pdr_start_with_push
+} FmPDRMode;
+
 typedef struct _FmPDRHandler
 {
-    std::string        m_config_dir;        // 配置文件目录
-    PDRConfig          m_config;            // 配置
-    CFmPDR             m_pdr;               // PDR句柄
-    StartInfo          m_si;                // 起点信息
-    CFmDataManager*    m_data_loader;       // 数据加载器
-    char*              m_sensor_data_path;  // PDR数据文件路径
-    fm_device_handle_t m_device_handle;     // 设备操作句柄
+    std::string         m_config_dir;         // 配置文件目录
+    PDRConfig           m_config;             // 配置
+    CFmPDR              m_pdr;                // PDR句柄
+    CFmGravityEstimator m_gravity_estimator;  // 重力估计器，实时模式下跨窗口保持姿态状态
+    StartInfo           m_si;                 // 起点信息
+    CFmDataManager*     m_data_loader;        // 数据加载器
+    char*               m_sensor_data_path;   // PDR数据文件路径
+    fm_device_handle_t  m_device_handle;      // 设备操作句柄
     // CFmMagnetometerCalibration*                  m_mag_calibration;   // 磁力计校准句柄
     SixParametersCorrector*                         m_loaded_corrector;  // 矫正器句柄
+    CFmStreamPDR*                                   m_stream;            // 推送模式推算引擎
     int                                             m_status;            // 0:停止,1:启动
+    FmPDRMode                                       m_mode;              // 推算模式
     std::thread                                     m_worker;            // 子线程句柄
+    std::thread                                     m_acquirer;          // 采集线程句柄
+    CFmClock*                                       m_clock;             // 实时流程取时与睡眠使用的时钟
+    CFmSimulatedClock*                              m_simulated_clock;   // 配置为模拟时钟时由句柄持有
+    CFmAsyncWriter*                                 m_writer;            // 异步输出（传感器数据、航迹数据），每次fm_pdr_start时重新创建
+    int                                             m_raw_sinks[ 3 ];    // 加速度计、陀螺仪、磁力计数据的输出编号，-1表示不保存
+    CFmSpscQueue< StreamSample >*                   m_samples;           // 采集线程到推算线程的采样点队列
+    std::atomic< bool >                             m_acquiring;         // 采集线程运行中，为false时采集的采样点都已写入队列
     moodycamel::ConcurrentQueue< Eigen::MatrixXd* > queue;               // 轨迹队列
 
+    // 采集统计
+    std::atomic< unsigned long long > m_acquired;
+    std::atomic< unsigned long long > m_consumed;
+    std::atomic< unsigned long long > m_overruns;
+    std::atomic< unsigned long long > m_read_errors;
+    std::atomic< unsigned long long > m_missed_deadlines;
+    std::atomic< double >             m_clock_skew_ppm;
+    std::atomic< unsigned long >      m_max_queue_depth;
+
     // 注意：创建PDR对象时，不能使用传入参数config，需要全局生命周期的m_config
-    _FmPDRHandler( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_config( config ), m_pdr( m_config, train_data, train_position ), m_data_loader( nullptr ), m_sensor_data_path( nullptr ), m_status( PDR_STOPPED )
+    _FmPDRHandler( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_config( config ), m_pdr( m_config, train_data, train_position ), m_gravity_estimator( m_config ), m_data_loader( nullptr ), m_sensor_data_path( nullptr ), m_loaded_corrector( nullptr ), m_stream( nullptr ), m_status( PDR_STOPPED ), m_mode( PDR_MODE_NONE ), m_clock( &CFmClock::real() ), m_simulated_clock( nullptr ), m_writer( nullptr ), m_raw_sinks{ -1, -1, -1 }, m_samples( nullptr ), m_acquiring( false ), m_acquired( 0 ), m_consumed( 0 ), m_overruns( 0 ), m_read_errors( 0 ), m_missed_deadlines( 0 ), m_clock_skew_ppm( 0.0 ), m_max_queue_depth( 0 )
     {
         memset( &m_device_handle, 0x00, sizeof( m_device_handle ) );
     }
-    _FmPDRHandler( const PDRConfig& config ) : m_config( config ), m_pdr( m_config ), m_data_loader( nullptr ), m_sensor_data_path( nullptr ), m_status( PDR_STOPPED )
+    _FmPDRHandler( const PDRConfig& config ) : m_config( config ), m_pdr( m_config ), m_gravity_estimator( m_config ), m_data_loader( nullptr ), m_sensor_data_path( nullptr ), m_loaded_corrector( nullptr ), m_stream( nullptr ), m_status( PDR_STOPPED ), m_mode( PDR_MODE_NONE ), m_clock( &CFmClock::real() ), m_simulated_clock( nullptr ), m_writer( nullptr ), m_raw_sinks{ -1, -1, -1 }, m_samples( nullptr ), m_acquiring( false ), m_acquired( 0 ), m_consumed( 0 ), m_overruns( 0 ), m_read_errors( 0 ), m_missed_deadlines( 0 ), m_clock_skew_ppm( 0.0 ), m_max_queue_depth( 0 )
     {
         memset( &m_device_handle, 0x00, sizeof( m_device_handle ) );
     }
@@ -115,63 +155,6 @@ bool file_exists( const std::string& file_path )
     return ( stat( file_path.c_str(), &buffer ) == 0 );
 }
 
-std::vector< std::vector< double > > read_csv_file( const std::string& file_path )
-{
-    std::vector< std::vector< double > > data;
-    std::ifstream                        file( file_path );
-
-    if ( ! file.is_open() )
-        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
-
-    std::string line;
-    bool        first_line = true;
-
-    while ( std::getline( file, line ) )
-    {
-        // 跳过空行和标题行
-        if ( line.empty() || first_line )
-        {
-            first_line = false;
-            continue;
-        }
-
-        std::vector< double > row;
-        std::stringstream     ss( line );
-        std::string           cell;
-
-        while ( std::getline( ss, cell, ',' ) )
-        {
-            try
-            {
-                row.push_back( std::stod( cell ) );
-            }
-            catch ( const std::exception& )
-            {
-                // 转换失败，跳过该单元格
-                continue;
-            }
-        }
-
-        if ( ! row.empty() )
-        {
-            if ( data.empty() )
-            {
-                // 初始化列向量
-                data.resize( row.size() );
-            }
-
-            // 将数据添加到对应的列
-            for ( size_t i = 0; i < row.size() && i < data.size(); ++i )
-            {
-                data[ i ].push_back( row[ i ] );
-            }
-        }
-    }
-
-    file.close();
-    return data;
-}
-
 void allocate_sensor_arrays( PDRSensorData* sensor_data, int length )
 {
     if ( length <= 0 )
@@ -353,114 +336,268 @@ static void append_to_csv( const std::string& full_path, const std::vector< std:
     outfile.unsetf( std::ios_base::fixed );
 }
 
-static void do_pdr( FmPDRHandler* hdl )
+// 追加一个窗口的二进制记录，各列由writev直接从窗口数组写出
+static int save_pdr_record( CFmSensorRecorder* recorder, PDRData* pdr_data )
+{
+    int ret = PDR_RESULT_SUCCESS;
+
+    try
+    {
+        recorder->append( *pdr_data );
+    }
+    catch ( const PDRException& e )
+    {
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+
+    return ret;
+}
+
+// 按配置打开实时推算的数据来源，回放数据循环使用，便于长时间压力测试
+static int init_device( const PDRConfig& config, fm_device_handle_t* device_handle )
+{
+    const char* backend = config.device_backend ? config.device_backend : "i2c";
+
+    if ( strcmp( backend, "i2c" ) == 0 )
+        return fm_device_init( config.sample_rate, device_handle );
+    if ( strcmp( backend, "replay" ) == 0 && config.device_replay_path )
+        return fm_device_init_replay( config.device_replay_path, config.sample_rate, config.device_speed, 1, device_handle );
+    if ( strcmp( backend, "synthetic" ) == 0 )
+        return fm_device_init_synthetic( config.sample_rate, config.device_speed, device_handle );
+
+    return -1;
+}
+
+// 数据来源是否按采样率控制节拍：传感器总是按采样率产生数据，回放与合成数据的倍速<=0时尽快读取
+static bool device_is_paced( const PDRConfig& config )
+{
+    const char* backend = config.device_backend ? config.device_backend : "i2c";
+    return strcmp( backend, "i2c" ) == 0 || config.device_speed > 0;
+}
+
+static void do_acquire( FmPDRHandler* hdl )
 {
-    PDRData    pdr_data;
     SensorData sensor_data;
     bool       is_first = true;
-    const int  count    = hdl->m_config.sample_rate * hdl->m_config.pdr_duration;
-    int        ret;
+    const bool paced    = device_is_paced( hdl->m_config );
 
-    memset( &pdr_data, 0x00, sizeof( pdr_data ) );
     memset( &sensor_data, 0x00, sizeof( sensor_data ) );
 
     while ( hdl->m_status == PDR_RUNNING )
     {
-        // 使用固定缓存模式读取传感器数据
-        ret = fm_device_read( hdl->m_device_handle, is_first, count, 1, &sensor_data );
+        // 每次读取一个采样点，读取函数内部按采样率控制节拍，数据写入设备句柄内部的缓存；FIFO模式下每个水位突发读取一次，其余点直接取自缓存的帧
+        const int ret = fm_device_read( hdl->m_device_handle, is_first, 1, 1, &sensor_data );
+        if ( ret == FM_DEVICE_END_OF_DATA )
+            break;
         if ( ret != 0 )
         {
-            std::cerr << "Sensor data reading failed." << std::endl;
+            hdl->m_read_errors++;
             continue;
         }
+        is_first                = false;
+        hdl->m_missed_deadlines = fm_device_get_missed_deadlines( hdl->m_device_handle );
+        hdl->m_clock_skew_ppm   = fm_device_get_clock_skew_ppm( hdl->m_device_handle );
+
+        const PDRSensorData& data = sensor_data.sensor_data;
+        StreamSample         sample;
+        sample.time      = data.acc_time[ 0 ];
+        sample.mag_time  = data.mag_time[ 0 ];
+        sample.acc[ 0 ]  = data.acc_x[ 0 ];
+        sample.acc[ 1 ]  = data.acc_y[ 0 ];
+        sample.acc[ 2 ]  = data.acc_z[ 0 ];
+        sample.lacc[ 0 ] = 0.0;
+        sample.lacc[ 1 ] = 0.0;
+        sample.lacc[ 2 ] = 0.0;
+        sample.gyr[ 0 ]  = data.gyr_x[ 0 ];
+        sample.gyr[ 1 ]  = data.gyr_y[ 0 ];
+        sample.gyr[ 2 ]  = data.gyr_z[ 0 ];
+        sample.mag[ 0 ]  = data.mag_x[ 0 ];
+        sample.mag[ 1 ]  = data.mag_y[ 0 ];
+        sample.mag[ 2 ]  = data.mag_z[ 0 ];
+
+        // 按节拍采集时，推算线程来不及处理则丢弃新的采样点并计数，采集节拍不受推算耗时影响；
+        // 不控制节拍时数据来源可以等待，队列满则等待推算线程取走数据，不丢弃采样点
+        bool pushed = hdl->m_samples->try_push( sample );
+        while ( ! pushed && ! paced && hdl->m_status == PDR_RUNNING )
+        {
+            hdl->m_clock->sleep_for( 500000000LL / hdl->m_config.sample_rate );
+            pushed = hdl->m_samples->try_push( sample );
+        }
+        if ( ! pushed )
+        {
+            hdl->m_overruns++;
+            continue;
+        }
+        hdl->m_acquired++;
 
-        // 标记不是第一次读取数据，即不需要再次创建缓存
-        is_first = false;
+        const unsigned long depth = hdl->m_samples->size();
+        if ( depth > hdl->m_max_queue_depth.load( std::memory_order_relaxed ) )
+            hdl->m_max_queue_depth.store( depth, std::memory_order_relaxed );
+    }
 
-        // 校准磁力计数据
-        for ( int i = 0; i < count; ++i )
-        {
-            const double& timestamp = sensor_data.sensor_data.acc_time[i];
-            const double& mag_x = sensor_data.sensor_data.mag_x[ i ];
-            const double& mag_y = sensor_data.sensor_data.mag_y[ i ];
-            const double& mag_z = sensor_data.sensor_data.mag_z[ i ];
-            MagnetometerData raw_data(timestamp, mag_x, mag_y, mag_z);
-            Vector3f raw_vec(raw_data.magneticFieldX, raw_data.magneticFieldY, raw_data.magneticFieldZ);
+    // 释放设备读取缓存
+    fm_device_free_sensor_data( sensor_data );
+    hdl->m_acquiring = false;
+    hdl->m_clock->detach();
+}
 
-            // 计算模长
-            // double magnitude_before = std::sqrt(mag_x * mag_x + mag_y * mag_y + mag_z * mag_z);
-            // std::cout << "校准前数据：(" << mag_x << "," << mag_y << "," << mag_z << "," << magnitude_before << ")" << std::endl;
+// 推算一个窗口(pdr_data.sensor_data的前length个采样点)，结果写入轨迹队列；is_last为true时输出等待方向确定的最后一步
+static void process_window( FmPDRHandler* hdl, PDRData& pdr_data, bool& started, bool is_last )
+{
+    PDRSensorData& window = pdr_data.sensor_data;
 
-            // hdl->m_mag_calibration->Calibration( mag_x, mag_y, mag_z );
+    // 校准磁力计数据
+    for ( unsigned long i = 0; i < window.length; ++i )
+    {
+        const double& timestamp = window.acc_time[i];
+        const double& mag_x = window.mag_x[ i ];
+        const double& mag_y = window.mag_y[ i ];
+        const double& mag_z = window.mag_z[ i ];
+        MagnetometerData raw_data(timestamp, mag_x, mag_y, mag_z);
+        Vector3f raw_vec(raw_data.magneticFieldX, raw_data.magneticFieldY, raw_data.magneticFieldZ);
 
-            // double magnitude_after = std::sqrt(mag_x * mag_x + mag_y * mag_y + mag_z * mag_z);
-            // std::cout << "校准后数据：(" << mag_x << "," << mag_y << "," << mag_z << "," << magnitude_after << ")" << std::endl;
+        // 计算模长
+        // double magnitude_before = std::sqrt(mag_x * mag_x + mag_y * mag_y + mag_z * mag_z);
+        // std::cout << "校准前数据：(" << mag_x << "," << mag_y << "," << mag_z << "," << magnitude_before << ")" << std::endl;
 
-            // mag_x *= sensor_data.sensor_data.mag_x[ i ];
-            // mag_y *= sensor_data.sensor_data.mag_y[ i ];
-            // mag_z *= sensor_data.sensor_data.mag_z[ i ];
+        // hdl->m_mag_calibration->Calibration( mag_x, mag_y, mag_z );
 
-            // 调用校正方法（公式：校正后 = (原始数据 - 偏移) × 增益）
-            Vector3f corrected_vec = hdl->m_loaded_corrector->correct(raw_vec);
+        // double magnitude_after = std::sqrt(mag_x * mag_x + mag_y * mag_y + mag_z * mag_z);
+        // std::cout << "校准后数据：(" << mag_x << "," << mag_y << "," << mag_z << "," << magnitude_after << ")" << std::endl;
 
-            // 输出校正结果
-            std::cout << "\n=== 数据校正示例 ===" << std::endl;
-            std::cout << "原始数据: " << raw_vec.transpose() << " μT" << std::endl;
-            std::cout << "校正后数据: " << corrected_vec.transpose() << ", " << corrected_vec.norm() << " μT" << std::endl;
+        // mag_x *= window.mag_x[ i ];
+        // mag_y *= window.mag_y[ i ];
+        // mag_z *= window.mag_z[ i ];
 
-            sensor_data.sensor_data.mag_x[ i ] = corrected_vec[0];
-            sensor_data.sensor_data.mag_y[ i ] = corrected_vec[1];
-            sensor_data.sensor_data.mag_z[ i ] = corrected_vec[2];
-        }
+        // 调用校正方法（公式：校正后 = (原始数据 - 偏移) × 增益）
+        Vector3f corrected_vec = hdl->m_loaded_corrector->correct(raw_vec);
 
-        // 转换为PDRData结构
-        pdr_data.sensor_data = sensor_data.sensor_data;
+        // 输出校正结果
+        std::cout << "\n=== 数据校正示例 ===" << std::endl;
+        std::cout << "原始数据: " << raw_vec.transpose() << " μT" << std::endl;
+        std::cout << "校正后数据: " << corrected_vec.transpose() << ", " << corrected_vec.norm() << " μT" << std::endl;
 
-        // 将sensor_data数据追加的形式保存到csv文件中，方便调试和验证
-        if ( hdl->m_sensor_data_path )
-        {
-            int result = fm_pdr_save_pdr_data( ( char* )hdl->m_sensor_data_path, &pdr_data );
-            if ( result != 0 )
-            {
-                std::cerr << "Failed to save data." << std::endl;
-                continue;
-            }
-        }
+        window.mag_x[ i ] = corrected_vec[0];
+        window.mag_y[ i ] = corrected_vec[1];
+        window.mag_z[ i ] = corrected_vec[2];
+    }
 
-        Eigen::MatrixXd* t = nullptr;
-        try
-        {
-            // 启动导航
-            CFmDataBufferLoader data_loader( hdl->m_config, 0, pdr_data );
-            hdl->m_si = hdl->m_pdr.start( hdl->m_si.x0, hdl->m_si.y0, data_loader );
-            t         = new Eigen::MatrixXd( hdl->m_pdr.pdr( hdl->m_si, data_loader ) );
+    // 将sensor_data数据放入输出队列，由输出线程追加到csv文件或二进制记录中，方便调试和验证；
+    // 存储跟不上时丢弃并计数(fm_pdr_get_output_stats)，不阻塞推算
+    if ( hdl->m_writer && hdl->m_raw_sinks[ 0 ] >= 0 )
+    {
+        const double* const acc[ 4 ] = { window.acc_time, window.acc_x, window.acc_y, window.acc_z };
+        const double* const gyr[ 4 ] = { window.gyr_time, window.gyr_x, window.gyr_y, window.gyr_z };
+        const double* const mag[ 4 ] = { window.mag_time, window.mag_x, window.mag_y, window.mag_z };
+        hdl->m_writer->push_columns( hdl->m_raw_sinks[ 0 ], acc, window.length );
+        hdl->m_writer->push_columns( hdl->m_raw_sinks[ 1 ], gyr, window.length );
+        hdl->m_writer->push_columns( hdl->m_raw_sinks[ 2 ], mag, window.length );
+    }
 
-            // 导航结果写入无锁队列
-            if ( t->rows() > 0 )
-                hdl->queue.enqueue( t );
-        }
-        catch ( const PDRException& e )
+    Eigen::MatrixXd* t = nullptr;
+    try
+    {
+        // 重力估计延续上一窗口的姿态，只处理本窗口新增的采样点
+        CFmDataBufferLoader data_loader( hdl->m_config, 0, pdr_data, &hdl->m_gravity_estimator );
+
+        // 只在首个窗口启动导航，之后的窗口延续起点信息与流式滤波状态
+        if ( ! started )
         {
-            delete t;
-            std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
-            continue;
+            hdl->m_si = hdl->m_pdr.start( hdl->m_si.x0, hdl->m_si.y0, data_loader );
+            started   = true;
         }
-        catch ( const std::exception& e )
+        t = new Eigen::MatrixXd( hdl->m_pdr.pdr( hdl->m_si, data_loader, is_last ) );
+
+        // 导航结果写入无锁队列
+        if ( t->rows() > 0 )
+            hdl->queue.enqueue( t );
+    }
+    catch ( const PDRException& e )
+    {
+        delete t;
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+    }
+    catch ( const std::exception& e )
+    {
+        delete t;
+        std::cerr << "[StdError] " << e.what() << std::endl;
+    }
+    catch ( ... )
+    {
+        delete t;
+        std::cerr << "[Unknown Error]" << std::endl;
+    }
+}
+
+static void do_pdr( FmPDRHandler* hdl )
+{
+    PDRData        pdr_data;
+    PDRSensorData& window  = pdr_data.sensor_data;
+    bool           started = false;
+    const int      count   = hdl->m_config.sample_rate * hdl->m_config.pdr_duration;
+    int            filled  = 0;
+
+    // 窗口缓存只分配一次，设备不提供线性加速度计数据，使用AHRS估计重力
+    memset( &pdr_data, 0x00, sizeof( pdr_data ) );
+    allocate_sensor_arrays( &window, count );
+
+    while ( true )
+    {
+        // 停止后继续取出采集线程退出前写入的采样点，队列取空后结束；先读停止标志再取队列，不会漏掉最后写入的点
+        const bool stopped = hdl->m_status != PDR_RUNNING && ! hdl->m_acquiring;
+
+        // 从采集队列取出采样点，凑满一个窗口后再推算
+        StreamSample sample;
+        if ( ! hdl->m_samples->try_pop( sample ) )
         {
-            delete t;
-            std::cerr << "[StdError] " << e.what() << std::endl;
+            if ( stopped )
+                break;
+            hdl->m_clock->sleep_for( 500000000LL / hdl->m_config.sample_rate );
             continue;
         }
-        catch ( ... )
-        {
-            delete t;
-            std::cerr << "[Unknown Error]" << std::endl;
+        hdl->m_consumed++;
+
+        window.acc_time[ filled ] = sample.time;
+        window.acc_x[ filled ]    = sample.acc[ 0 ];
+        window.acc_y[ filled ]    = sample.acc[ 1 ];
+        window.acc_z[ filled ]    = sample.acc[ 2 ];
+        window.gyr_time[ filled ] = sample.time;
+        window.gyr_x[ filled ]    = sample.gyr[ 0 ];
+        window.gyr_y[ filled ]    = sample.gyr[ 1 ];
+        window.gyr_z[ filled ]    = sample.gyr[ 2 ];
+        window.mag_time[ filled ] = sample.mag_time;
+        window.mag_x[ filled ]    = sample.mag[ 0 ];
+        window.mag_y[ filled ]    = sample.mag[ 1 ];
+        window.mag_z[ filled ]    = sample.mag[ 2 ];
+        if ( ++filled < count )
             continue;
-        }
+        filled        = 0;
+        window.length = count;
+        process_window( hdl, pdr_data, started, false );
     }
 
-    // 释放设备读取缓存
-    fm_device_free_sensor_data( sensor_data );
+    // 停止时推算不足一个窗口的剩余采样点，并输出等待方向确定的最后一步；
+    // 剩余点为0时没有可插值的时刻，尚未启动导航时需要least_start_point以上的点数确定起点
+    if ( filled > 0 && ( started || filled > hdl->m_config.least_start_point ) )
+    {
+        window.length = filled;
+        process_window( hdl, pdr_data, started, true );
+    }
+
+    // 释放窗口缓存
+    cleanup_pdr_data( &pdr_data );
+    hdl->m_clock->detach();
 }
 
 int fm_pdr_init_with_file( char* config_dir, char* train_file_path, PDRHandler* handler, PDRTrajectoryArray* trajectories_array )
@@ -554,6 +691,66 @@ int fm_pdr_get_config( PDRHandler handler, PDRConfig* config )
     return PDR_RESULT_SUCCESS;
 }
 
+// 按配置创建异步输出，未配置时队列可缓存65536行、不调用fsync
+static CFmAsyncWriter* new_output_writer( const PDRConfig& config )
+{
+    const size_t capacity = config.output_queue_size > 0 ? static_cast< size_t >( config.output_queue_size ) : 65536;
+    return new CFmAsyncWriter( capacity, config.output_fsync_interval );
+}
+
+int fm_pdr_get_output_stats( PDRHandler handler, PDROutputStats* stats )
+{
+    if ( ! handler || ! stats )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    FmPDRHandler* hdl = reinterpret_cast< FmPDRHandler* >( handler );
+    memset( stats, 0x00, sizeof( *stats ) );
+    if ( ! hdl->m_writer )
+        return PDR_RESULT_SUCCESS;
+
+    const FmOutputStats s = hdl->m_writer->stats();
+    stats->queued         = s.queued;
+    stats->written        = s.written;
+    stats->dropped        = s.dropped;
+    stats->write_errors   = s.write_errors;
+    stats->queue_depth    = s.depth;
+    stats->max_depth      = s.max_depth;
+    stats->capacity       = s.capacity;
+
+    return PDR_RESULT_SUCCESS;
+}
+
+int fm_pdr_get_acquisition_stats( PDRHandler handler, PDRAcquisitionStats* stats )
+{
+    if ( ! handler || ! stats )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    FmPDRHandler* hdl       = reinterpret_cast< FmPDRHandler* >( handler );
+    stats->acquired         = hdl->m_acquired;
+    stats->consumed         = hdl->m_consumed;
+    stats->overruns         = hdl->m_overruns;
+    stats->read_errors      = hdl->m_read_errors;
+    stats->missed_deadlines = hdl->m_missed_deadlines;
+    stats->queue_capacity   = hdl->m_samples ? hdl->m_samples->capacity() : 0;
+    stats->max_queue_depth  = hdl->m_max_queue_depth;
+    stats->clock_skew_ppm   = hdl->m_clock_skew_ppm;
+
+    return PDR_RESULT_SUCCESS;
+}
+
+// fm_pdr_start失败时撤销已完成的部分：释放设备与磁力计校正并清空句柄，恢复为停止状态，之后可再次调用fm_pdr_start
+static void abort_start( FmPDRHandler* hdl )
+{
+    delete hdl->m_loaded_corrector;
+    hdl->m_loaded_corrector = nullptr;
+    fm_device_uninit( hdl->m_device_handle );
+    hdl->m_device_handle.handler = nullptr;
+    free( hdl->m_sensor_data_path );
+    hdl->m_sensor_data_path = nullptr;
+    hdl->m_status           = PDR_STOPPED;
+    hdl->m_mode             = PDR_MODE_NONE;
+}
+
 int fm_pdr_start( PDRHandler handler, PDRPoint* start_point, char* raw_data_path )
 {
     if ( ! handler || ! start_point )
@@ -572,11 +769,74 @@ int fm_pdr_start( PDRHandler handler, PDRPoint* start_point, char* raw_data_path
         hdl->m_si.y0            = start_point->y;
         hdl->m_sensor_data_path = strdup( raw_data_path );
         hdl->m_status           = PDR_RUNNING;
+        hdl->m_mode             = PDR_MODE_DEVICE;
+        hdl->m_gravity_estimator.reset();
 
-        // 集成驱动
-        ret = fm_device_init( hdl->m_config.sample_rate, &hdl->m_device_handle );
+        // 集成驱动（I2C传感器、回放或合成数据），先清空句柄，失败时abort_start只释放本次创建的设备
+        hdl->m_device_handle.handler = nullptr;
+        ret                          = init_device( hdl->m_config, &hdl->m_device_handle );
         if ( ret != 0 )
+        {
+            abort_start( hdl );
             return PDR_RESULT_DEVICE_INIT_ERROR;
+        }
+
+        // 配置了水位时按批读取IMU的FIFO
+        if ( hdl->m_config.fifo_watermark > 0 && fm_device_enable_fifo( hdl->m_device_handle, hdl->m_config.fifo_watermark ) != 0 )
+        {
+            abort_start( hdl );
+            return PDR_RESULT_DEVICE_INIT_ERROR;
+        }
+
+        // 配置了中断线时由数据就绪边沿唤醒采集线程
+        if ( hdl->m_config.device_irq_line >= 0 )
+        {
+            const char* chip = hdl->m_config.device_irq_chip ? hdl->m_config.device_irq_chip : "/dev/gpiochip0";
+            if ( fm_device_enable_data_ready( hdl->m_device_handle, chip, static_cast< unsigned int >( hdl->m_config.device_irq_line ) ) != 0 )
+            {
+                abort_start( hdl );
+                return PDR_RESULT_DEVICE_INIT_ERROR;
+            }
+        }
+
+        // 模拟时钟下采集与推算线程都参与模拟，设备的节拍与时间戳同样取自模拟时钟
+        hdl->m_clock = &CFmClock::real();
+        if ( hdl->m_config.device_clock && strcmp( hdl->m_config.device_clock, "simulated" ) == 0 )
+        {
+            delete hdl->m_simulated_clock;
+            hdl->m_simulated_clock = new CFmSimulatedClock();
+            hdl->m_clock           = hdl->m_simulated_clock;
+            fm_device_set_clock( hdl->m_device_handle, hdl->m_simulated_clock );
+        }
+
+        // 传感器数据与航迹数据由输出线程异步写入，输出文件在推算期间保持打开；删除上次的输出时写完其中剩余的数据
+        delete hdl->m_writer;
+        hdl->m_writer = new_output_writer( hdl->m_config );
+        for ( int& sink : hdl->m_raw_sinks )
+            sink = -1;
+        if ( hdl->m_sensor_data_path )
+        {
+            if ( mkdir( hdl->m_sensor_data_path, 0755 ) != 0 && errno != EEXIST )
+                throw FileException( FileException::CREATE_FAILED, hdl->m_sensor_data_path );
+
+            const char*    record_format = hdl->m_config.record_format ? hdl->m_config.record_format : "csv";
+            FmOutputFormat format        = FM_OUTPUT_CSV;
+            std::string    extension     = ".csv";
+            if ( strcmp( record_format, "binary" ) == 0 )
+            {
+                format    = FM_OUTPUT_RECORD;
+                extension = kRecordExtension;
+            }
+            else if ( strcmp( record_format, "compressed" ) == 0 )
+            {
+                format    = FM_OUTPUT_LOG;
+                extension = kLogExtension;
+            }
+            const std::string dir( hdl->m_sensor_data_path );
+            hdl->m_raw_sinks[ 0 ] = hdl->m_writer->add_sink( dir + "/Accelerometer" + extension, kAccelerometerHeader, format );
+            hdl->m_raw_sinks[ 1 ] = hdl->m_writer->add_sink( dir + "/Gyroscope" + extension, kGyroscopeHeader, format );
+            hdl->m_raw_sinks[ 2 ] = hdl->m_writer->add_sink( dir + "/Magnetometer" + extension, kMagnetometerHeader, format );
+        }
 
         // const string& mag_calib_path = hdl->m_config_dir + "//" + "mag_calibration.json";
         // hdl->m_mag_calibration = new CFmMagnetometerCalibration( mag_calib_path );
@@ -584,38 +844,43 @@ int fm_pdr_start( PDRHandler handler, PDRPoint* start_point, char* raw_data_path
         hdl->m_loaded_corrector      = new SixParametersCorrector();
         if ( ! hdl->m_loaded_corrector->fromFile( mag_calib_path ) )
             throw FileException( FileException::DIR_NOT_EXIST, mag_calib_path.c_str() );
-        hdl->m_worker = std::thread( do_pdr, hdl );
+
+        // 采集与推算分离：采集线程按采样率写入队列，推算线程凑满窗口后推算，队列可缓存4个窗口
+        const int count = hdl->m_config.sample_rate * hdl->m_config.pdr_duration;
+        delete hdl->m_samples;
+        hdl->m_samples          = new CFmSpscQueue< StreamSample >( 4 * count );
+        hdl->m_acquired         = 0;
+        hdl->m_consumed         = 0;
+        hdl->m_overruns         = 0;
+        hdl->m_read_errors      = 0;
+        hdl->m_missed_deadlines = 0;
+        hdl->m_clock_skew_ppm   = 0.0;
+        hdl->m_max_queue_depth  = 0;
+
+        hdl->m_acquiring = true;
+        hdl->m_clock->attach();
+        hdl->m_clock->attach();
+        hdl->m_worker   = std::thread( do_pdr, hdl );
+        hdl->m_acquirer = std::thread( do_acquire, hdl );
     }
     catch ( const PDRException& e )
     {
         if ( hdl )
-        {
-            delete hdl->m_loaded_corrector;
-            hdl->m_loaded_corrector = nullptr;
-            fm_device_uninit( hdl->m_device_handle );
-        }
+            abort_start( hdl );
         std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
         ret = e.code();
     }
     catch ( const std::exception& e )
     {
         if ( hdl )
-        {
-            delete hdl->m_loaded_corrector;
-            hdl->m_loaded_corrector = nullptr;
-            fm_device_uninit( hdl->m_device_handle );
-        }
+            abort_start( hdl );
         std::cerr << "[StdError] " << e.what() << std::endl;
         ret = PDR_RESULT_GENERAL_ERROR;
     }
     catch ( ... )
     {
         if ( hdl )
-        {
-            delete hdl->m_loaded_corrector;
-            hdl->m_loaded_corrector = nullptr;
-            fm_device_uninit( hdl->m_device_handle );
-        }
+            abort_start( hdl );
         std::cerr << "[Unknown Error]" << std::endl;
         ret = PDR_RESULT_UNKNOWN;
     }
@@ -633,6 +898,7 @@ int fm_pdr_start_with_file( PDRHandler handler, char* sensor_file_path )
     try
     {
         hdl                = reinterpret_cast< FmPDRHandler* >( handler );
+        hdl->m_mode        = PDR_MODE_NONE;
         hdl->m_data_loader = new CFmDataFileLoader( hdl->m_config, 0, sensor_file_path );
         // VectorXd pos_x          = hdl->m_data_loader->get_true_data( TRUE_DATA_FIELD_LATITUDE );
         // VectorXd pos_y          = hdl->m_data_loader->get_true_data( TRUE_DATA_FIELD_LONGITUDE );
@@ -643,6 +909,7 @@ int fm_pdr_start_with_file( PDRHandler handler, char* sensor_file_path )
         hdl->m_si               = hdl->m_pdr.start( x0, y0, *hdl->m_data_loader );
         hdl->m_sensor_data_path = strdup( sensor_file_path );
         hdl->m_status           = PDR_RUNNING;
+        hdl->m_mode             = PDR_MODE_FILE;
     }
     catch ( const PDRException& e )
     {
@@ -683,6 +950,90 @@ int fm_pdr_start_with_file( PDRHandler handler, char* sensor_file_path )
     return ret;
 }
 
+int fm_pdr_start_with_push( PDRHandler handler, PDRPoint* start_point )
+{
+    if ( ! handler || ! start_point )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    int           ret = PDR_RESULT_SUCCESS;
+    FmPDRHandler* hdl = nullptr;
+
+    try
+    {
+        hdl = reinterpret_cast< FmPDRHandler* >( handler );
+        if ( hdl->m_status )
+            return PDR_RESULT_ALREADY_RUNNING;
+
+        delete hdl->m_stream;
+        hdl->m_stream = nullptr;
+        hdl->m_si.x0  = start_point->x;
+        hdl->m_si.y0  = start_point->y;
+        hdl->m_gravity_estimator.reset();
+        hdl->m_stream = new CFmStreamPDR( hdl->m_config, hdl->m_pdr, hdl->m_gravity_estimator, start_point->x, start_point->y );
+        hdl->m_status = PDR_RUNNING;
+        hdl->m_mode   = PDR_MODE_PUSH;
+    }
+    catch ( const PDRException& e )
+    {
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+    return ret;
+}
+
+int fm_pdr_push_samples( PDRHandler handler, const PDRSensorData* sensor_data )
+{
+    if ( ! handler || ! sensor_data )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    int              ret = PDR_RESULT_SUCCESS;
+    Eigen::MatrixXd* t   = nullptr;
+
+    try
+    {
+        FmPDRHandler* hdl = reinterpret_cast< FmPDRHandler* >( handler );
+        if ( hdl->m_mode != PDR_MODE_PUSH || hdl->m_status != PDR_RUNNING )
+            return PDR_RESULT_CALL_ERROR;
+
+        // 新产生的位置点写入无锁队列，与实时模式一致通过fm_pdr_predict取得
+        t   = new Eigen::MatrixXd( hdl->m_stream->push( *sensor_data ) );
+        ret = t->rows();
+        if ( ret > 0 )
+            hdl->queue.enqueue( t );
+        else
+            delete t;
+    }
+    catch ( const PDRException& e )
+    {
+        delete t;
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        delete t;
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        delete t;
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+    return ret;
+}
+
 int fm_pdr_predict( PDRHandler handler, PDRTrajectoryArray* trajectories_array )
 {
     if ( ! handler || ! trajectories_array )
@@ -700,8 +1051,8 @@ int fm_pdr_predict( PDRHandler handler, PDRTrajectoryArray* trajectories_array )
         // if ( hdl->m_status != PDR_RUNNING )
         //     return PDR_RESULT_CALL_ERROR;
 
-        // 根据是否创建设备句柄判断PDR模式
-        if ( ! hdl->m_device_handle.handler )
+        // 文件模式一次推算全部数据，实时与推送模式从队列取得位置点
+        if ( hdl->m_mode == PDR_MODE_FILE )
         {
             predict_trajectories = new Eigen::MatrixXd( hdl->m_pdr.pdr( hdl->m_si, *hdl->m_data_loader ) );
             ret                  = eigenToPDRTrajectory( *predict_trajectories, &trajs );
@@ -814,6 +1165,57 @@ int fm_pdr_save_trajectory_data( char* file_path, PDRTrajectoryArray* trajectori
     return ret;
 }
 
+int fm_pdr_save_trajectory_data_async( PDRHandler handler, char* file_path, PDRTrajectoryArray* trajectories_array )
+{
+    // 参数有效性校验
+    if ( ! handler || ! file_path || ! trajectories_array )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    int ret = PDR_RESULT_SUCCESS;
+
+    try
+    {
+        FmPDRHandler* hdl = reinterpret_cast< FmPDRHandler* >( handler );
+        if ( ! hdl->m_writer )
+            hdl->m_writer = new_output_writer( hdl->m_config );
+
+        // 与fm_pdr_save_trajectory_data相同的列，没有数据的列为NaN(空单元格)
+        const int sink    = hdl->m_writer->add_sink( file_path, kLocationHeader, FM_OUTPUT_CSV );
+        int       dropped = 0;
+        for ( unsigned int i = 0; i < trajectories_array->count; ++i )
+        {
+            PDRTrajectory* trajectories = trajectories_array->array[ i ];
+            if ( ! trajectories )
+                return PDR_RESULT_NONE;
+
+            // 数据指针完整性校验
+            if ( ! trajectories->length || ! trajectories->time || ! trajectories->x || ! trajectories->y || ! trajectories->direction )
+                return PDR_RESULT_EMPTY_ERROR;
+
+            const std::vector< double > empty( trajectories->length, std::numeric_limits< double >::quiet_NaN() );
+            const double* const         columns[ 8 ] = { trajectories->time, trajectories->x, trajectories->y, empty.data(), empty.data(), trajectories->direction, empty.data(), empty.data() };
+            dropped += static_cast< int >( trajectories->length - hdl->m_writer->push_columns( sink, columns, trajectories->length ) );
+        }
+        ret = dropped;
+    }
+    catch ( const PDRException& e )
+    {
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+    return ret;
+}
+
 void fm_pdr_free_trajectory( PDRTrajectoryArray* trajectories_array )
 {
     if ( ! trajectories_array )
@@ -837,11 +1239,30 @@ int fm_pdr_stop( PDRHandler handler, PDRTrajectoryArray* trajectories_array )
             return PDR_RESULT_CALL_ERROR;
 
         hdl->m_status = PDR_STOPPED;
+        if ( hdl->m_acquirer.joinable() )
+            hdl->m_acquirer.join();
         if ( hdl->m_worker.joinable() )
             hdl->m_worker.join();
         delete hdl->m_loaded_corrector;
         hdl->m_loaded_corrector = nullptr;
-        fm_device_uninit( hdl->m_device_handle );
+        fm_device_uninit( hdl->m_device_handle );  // 按值传入句柄，由调用者清空
+        hdl->m_device_handle.handler = nullptr;
+
+        // 等待输出线程写完已入队的传感器数据与航迹数据
+        if ( hdl->m_writer )
+            hdl->m_writer->flush();
+
+        // 推送模式下输出等待方向确定的最后一步，之后释放推送引擎
+        if ( hdl->m_stream )
+        {
+            Eigen::MatrixXd* t = new Eigen::MatrixXd( hdl->m_stream->flush() );
+            if ( t->rows() > 0 )
+                hdl->queue.enqueue( t );
+            else
+                delete t;
+            delete hdl->m_stream;
+            hdl->m_stream = nullptr;
+        }
 
         // 返回无锁队列中剩余的行人航迹
         return fm_pdr_predict( handler, trajectories_array );
@@ -864,8 +1285,8 @@ void fm_pdr_uninit( PDRHandler* handler )
 
     FmPDRHandler* hdl = reinterpret_cast< FmPDRHandler* >( *handler );
 
-    // 以hdl->m_loaded_corrector判断是否为实时PDR模式
-    if ( hdl->m_status != PDR_STOPPED && hdl->m_loaded_corrector )
+    // 实时与推送模式需要停止采集、推算线程并输出剩余的位置点
+    if ( hdl->m_status != PDR_STOPPED && ( hdl->m_mode == PDR_MODE_DEVICE || hdl->m_mode == PDR_MODE_PUSH ) )
     {
         PDRTrajectoryArray ta;
         fm_pdr_stop( handler, &ta );
@@ -873,15 +1294,34 @@ void fm_pdr_uninit( PDRHandler* handler )
     }
     delete[] hdl->m_config.model_name;
     delete[] hdl->m_config.model_file_name;
+    free( hdl->m_config.device_backend );
+    free( hdl->m_config.device_replay_path );
+    free( hdl->m_config.device_irq_chip );
+    free( hdl->m_config.device_clock );
+    free( hdl->m_config.record_format );
     delete hdl->m_data_loader;
+    delete hdl->m_stream;
+    delete hdl->m_samples;
+    delete hdl->m_simulated_clock;
+    delete hdl->m_writer;
     free( hdl->m_sensor_data_path );
     delete hdl;
     hdl = nullptr;
 }
 
-int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data )
+// 数据表中时间在[start_time, end_time)内的行数与首行行号，数据表不存在或列数不足时返回0
+static size_t find_table_rows( const std::unique_ptr< CFmTableReader >& table, size_t min_cols, double start_time, double end_time, size_t& first_row )
 {
-    if ( ! dir_path || ! pdr_data )
+    size_t num_rows = 0;
+    first_row       = 0;
+    if ( table && table->cols() >= min_cols )
+        table->find_rows( start_time, end_time, first_row, num_rows );
+    return num_rows;
+}
+
+static int read_pdr_data( char* dir_path, double start_time, double end_time, PDRData* pdr_data )
+{
+    if ( ! dir_path || ! pdr_data || ! ( start_time < end_time ) )
         return PDR_RESULT_PARAMETER_ERROR;
 
     int ret = PDR_RESULT_SUCCESS;
@@ -902,98 +1342,67 @@ int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data )
         memset( sensor_data, 0x00, sizeof( PDRSensorData ) );
 
         // 读取加速度计数据
-        std::string acc_path = dir_path_name + "/Accelerometer.csv";
-        if ( file_exists( acc_path ) )
+        auto   acc       = CFmTableReader::open( dir_path_name, "Accelerometer" );
+        size_t acc_first = 0;
+        size_t acc_rows  = find_table_rows( acc, 4, start_time, end_time, acc_first );
+        if ( acc_rows > 0 )
         {
-            auto acc_data = read_csv_file( acc_path );
-            if ( ! acc_data.empty() && acc_data.size() >= 4 )
-            {
-                sensor_data->length = acc_data[ 0 ].size();
-                allocate_sensor_arrays( sensor_data, sensor_data->length );
+            sensor_data->length = acc_rows;
+            allocate_sensor_arrays( sensor_data, sensor_data->length );
 
-                for ( size_t i = 0; i < sensor_data->length; ++i )
-                {
-                    sensor_data->acc_time[ i ] = acc_data[ 0 ][ i ];
-                    sensor_data->acc_x[ i ]    = acc_data[ 1 ][ i ];
-                    sensor_data->acc_y[ i ]    = acc_data[ 2 ][ i ];
-                    sensor_data->acc_z[ i ]    = acc_data[ 3 ][ i ];
-                }
-            }
+            // 直接读取到传感器数组
+            double* const columns[ 4 ] = { sensor_data->acc_time, sensor_data->acc_x, sensor_data->acc_y, sensor_data->acc_z };
+            acc->read_rows( acc_first, 0, 4, columns, sensor_data->length );
         }
 
         // 读取陀螺仪数据
-        std::string gyr_path = dir_path_name + "/Gyroscope.csv";
-        if ( file_exists( gyr_path ) )
+        auto   gyr       = CFmTableReader::open( dir_path_name, "Gyroscope" );
+        size_t gyr_first = 0;
+        size_t gyr_rows  = find_table_rows( gyr, 4, start_time, end_time, gyr_first );
+        if ( gyr_rows > 0 )
         {
-            auto gyr_data = read_csv_file( gyr_path );
-            if ( ! gyr_data.empty() && gyr_data.size() >= 4 )
+            // 如果还没有分配数组，根据陀螺仪数据长度分配
+            if ( sensor_data->length == 0 )
             {
-                // 如果还没有分配数组，根据陀螺仪数据长度分配
-                if ( sensor_data->length == 0 )
-                {
-                    sensor_data->length = gyr_data[ 0 ].size();
-                    allocate_sensor_arrays( sensor_data, sensor_data->length );
-                }
-
-                for ( size_t i = 0; i < sensor_data->length && i < gyr_data[ 0 ].size(); ++i )
-                {
-                    sensor_data->gyr_time[ i ] = gyr_data[ 0 ][ i ];
-                    sensor_data->gyr_x[ i ]    = gyr_data[ 1 ][ i ];
-                    sensor_data->gyr_y[ i ]    = gyr_data[ 2 ][ i ];
-                    sensor_data->gyr_z[ i ]    = gyr_data[ 3 ][ i ];
-                }
+                sensor_data->length = gyr_rows;
+                allocate_sensor_arrays( sensor_data, sensor_data->length );
             }
+
+            double* const columns[ 4 ] = { sensor_data->gyr_time, sensor_data->gyr_x, sensor_data->gyr_y, sensor_data->gyr_z };
+            gyr->read_rows( gyr_first, 0, 4, columns, std::min< size_t >( gyr_rows, sensor_data->length ) );
         }
 
         // 读取磁力计数据
-        std::string mag_path = dir_path_name + "/Magnetometer.csv";
-        if ( file_exists( mag_path ) )
+        auto   mag       = CFmTableReader::open( dir_path_name, "Magnetometer" );
+        size_t mag_first = 0;
+        size_t mag_rows  = find_table_rows( mag, 4, start_time, end_time, mag_first );
+        if ( mag_rows > 0 )
         {
-            auto mag_data = read_csv_file( mag_path );
-            if ( ! mag_data.empty() && mag_data.size() >= 4 )
+            // 如果还没有分配数组，根据磁力计数据长度分配
+            if ( sensor_data->length == 0 )
             {
-                // 如果还没有分配数组，根据磁力计数据长度分配
-                if ( sensor_data->length == 0 )
-                {
-                    sensor_data->length = mag_data[ 0 ].size();
-                    allocate_sensor_arrays( sensor_data, sensor_data->length );
-                }
-
-                for ( size_t i = 0; i < sensor_data->length && i < mag_data[ 0 ].size(); ++i )
-                {
-                    sensor_data->mag_time[ i ] = mag_data[ 0 ][ i ];
-                    sensor_data->mag_x[ i ]    = mag_data[ 1 ][ i ];
-                    sensor_data->mag_y[ i ]    = mag_data[ 2 ][ i ];
-                    sensor_data->mag_z[ i ]    = mag_data[ 3 ][ i ];
-                }
+                sensor_data->length = mag_rows;
+                allocate_sensor_arrays( sensor_data, sensor_data->length );
             }
+
+            double* const columns[ 4 ] = { sensor_data->mag_time, sensor_data->mag_x, sensor_data->mag_y, sensor_data->mag_z };
+            mag->read_rows( mag_first, 0, 4, columns, std::min< size_t >( mag_rows, sensor_data->length ) );
         }
 
         // 读取GPS数据
         PDRTrueData* true_data = &pdr_data->true_data;
         memset( true_data, 0x00, sizeof( PDRTrueData ) );
 
-        std::string gps_path = dir_path_name + "/Location.csv";
-        if ( file_exists( gps_path ) )
+        auto   gps       = CFmTableReader::open( dir_path_name, "Location" );
+        size_t gps_first = 0;
+        size_t gps_rows  = find_table_rows( gps, 8, start_time, end_time, gps_first );
+        if ( gps_rows > 0 )
         {
-            auto gps_data = read_csv_file( gps_path );
-            if ( ! gps_data.empty() && gps_data.size() >= 8 )
-            {
-                true_data->length = gps_data[ 0 ].size();
-                allocate_true_arrays( true_data, true_data->length );
-
-                for ( size_t i = 0; i < true_data->length; ++i )
-                {
-                    true_data->time_location[ i ]       = gps_data[ 0 ][ i ];
-                    true_data->latitude[ i ]            = gps_data[ 1 ][ i ];
-                    true_data->longitude[ i ]           = gps_data[ 2 ][ i ];
-                    true_data->height[ i ]              = gps_data[ 3 ][ i ];
-                    true_data->velocity[ i ]            = gps_data[ 4 ][ i ];
-                    true_data->direction[ i ]           = gps_data[ 5 ][ i ];
-                    true_data->horizontal_accuracy[ i ] = gps_data[ 6 ][ i ];
-                    true_data->vertical_accuracy[ i ]   = gps_data[ 7 ][ i ];
-                }
-            }
+            true_data->length = gps_rows;
+            allocate_true_arrays( true_data, true_data->length );
+
+            double* const columns[ 8 ] = { true_data->time_location, true_data->latitude, true_data->longitude, true_data->height, true_data->velocity, true_data->direction, true_data->horizontal_accuracy, true_data->vertical_accuracy };
+            gps->read_rows( gps_first, 0, 8, columns, true_data->length );
         }
 
         // 如果没有读取到任何数据，返回错误
@@ -1028,6 +1437,16 @@ int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data )
     return ret;
 }
 
+int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data )
+{
+    return read_pdr_data( dir_path, -std::numeric_limits< double >::infinity(), std::numeric_limits< double >::infinity(), pdr_data );
+}
+
+int fm_pdr_read_pdr_data_range( char* dir_path, double start_time, double end_time, PDRData* pdr_data )
+{
+    return read_pdr_data( dir_path, start_time, end_time, pdr_data );
+}
+
 int fm_pdr_save_pdr_data( char* dir_path, PDRData* pdr_data )
 {
     if ( ! dir_path || ! pdr_data )
@@ -1135,9 +1554,164 @@ int fm_pdr_save_pdr_data( char* dir_path, PDRData* pdr_data )
     return ret;
 }
 
+int fm_pdr_save_pdr_record( char* dir_path, PDRData* pdr_data )
+{
+    if ( ! dir_path || ! pdr_data )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    // 创建目录（如果不存在）
+    if ( mkdir( dir_path, 0755 ) != 0 && errno != EEXIST )
+        return PDR_RESULT_CREATE_FAILED;
+
+    CFmSensorRecorder recorder( dir_path );
+    return save_pdr_record( &recorder, pdr_data );
+}
+
+// 可在CSV与二进制记录之间转换的数据文件（不含扩展名）
+static const char* const kSensorTables[] = { "Accelerometer", "Linear Accelerometer", "Gyroscope", "Magnetometer", "Location" };
+// CSV转换为二进制记录或压缩日志时每个数据块的行数
+constexpr Eigen::Index kConvertChunkRows = 4096;
+
+// 将目录下的CSV文件转换为同名的二进制记录(CFmRecordWriter)或压缩日志(CFmLogWriter)
+template < typename Writer >
+static int convert_from_csv( char* dir_path, const char* extension )
+{
+    if ( ! dir_path )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    int ret = PDR_RESULT_SUCCESS;
+
+    try
+    {
+        std::string dir_path_name( dir_path );
+        int         converted = 0;
+
+        for ( const char* name : kSensorTables )
+        {
+            const std::string csv_path = dir_path_name + "/" + name + ".csv";
+            if ( ! file_exists( csv_path ) )
+                continue;
+
+            CFmCsvReader          csv( csv_path );
+            const Eigen::MatrixXd data = csv.read_matrix();
+
+            // 覆盖已有的同名文件
+            const std::string target_path = dir_path_name + "/" + name + extension;
+            std::remove( target_path.c_str() );
+            Writer writer( target_path, csv.header() );
+
+            std::vector< const double* > columns( data.cols() );
+            for ( Eigen::Index row = 0; row < data.rows(); row += kConvertChunkRows )
+            {
+                const Eigen::Index n = std::min( kConvertChunkRows, data.rows() - row );
+                for ( Eigen::Index k = 0; k < data.cols(); ++k )
+                    columns[ k ] = data.col( k ).data() + row;
+                writer.append( columns.data(), n );
+            }
+            converted++;
+        }
+
+        if ( converted == 0 )
+            ret = PDR_RESULT_EMPTY_ERROR;
+    }
+    catch ( const PDRException& e )
+    {
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+
+    return ret;
+}
+
+// 将目录下的二进制记录(CFmRecordReader)或压缩日志(CFmLogReader)转换为同名的CSV文件
+template < typename Reader >
+static int convert_to_csv( char* dir_path, const char* extension )
+{
+    if ( ! dir_path )
+        return PDR_RESULT_PARAMETER_ERROR;
+
+    int ret = PDR_RESULT_SUCCESS;
+
+    try
+    {
+        std::string dir_path_name( dir_path );
+        int         converted = 0;
+
+        for ( const char* name : kSensorTables )
+        {
+            const std::string source_path = dir_path_name + "/" + name + extension;
+            if ( ! file_exists( source_path ) )
+                continue;
+
+            Reader                source( source_path );
+            const Eigen::MatrixXd data = source.read_matrix();
+
+            std::vector< std::pair< std::string, std::vector< double > > > columns;
+            for ( Eigen::Index k = 0; k < data.cols(); ++k )
+                columns.push_back( { quote_header( source.header()[ k ] ), std::vector< double >( data.col( k ).data(), data.col( k ).data() + data.rows() ) } );
+
+            // 覆盖已有的CSV文件
+            const std::string csv_path = dir_path_name + "/" + name + ".csv";
+            std::remove( csv_path.c_str() );
+            append_to_csv( csv_path, columns );
+            converted++;
+        }
+
+        if ( converted == 0 )
+            ret = PDR_RESULT_EMPTY_ERROR;
+    }
+    catch ( const PDRException& e )
+    {
+        std::cerr << "[PDRError:" << e.code() << "] " << e.what() << std::endl;
+        ret = e.code();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[StdError] " << e.what() << std::endl;
+        ret = PDR_RESULT_GENERAL_ERROR;
+    }
+    catch ( ... )
+    {
+        std::cerr << "[Unknown Error]" << std::endl;
+        ret = PDR_RESULT_UNKNOWN;
+    }
+
+    return ret;
+}
+
 void fm_pdr_free_pdr_data( PDRData* pdr_data )
 {
     if ( ! pdr_data )
         return;
     cleanup_pdr_data( pdr_data );
+}
+
+int fm_pdr_convert_csv_to_record( char* dir_path )
+{
+    return convert_from_csv< CFmRecordWriter >( dir_path, kRecordExtension );
+}
+
+int fm_pdr_convert_record_to_csv( char* dir_path )
+{
+    return convert_to_csv< CFmRecordReader >( dir_path, kRecordExtension );
+}
+
+int fm_pdr_convert_csv_to_log( char* dir_path )
+{
+    return convert_from_csv< CFmLogWriter >( dir_path, kLogExtension );
+}
+
+int fm_pdr_convert_log_to_csv( char* dir_path )
+{
+    return convert_to_csv< CFmLogReader >( dir_path, kLogExtension );
 }
\ No newline at end of file
@@ -12,7 +12,7 @@ typedef struct _PDRConfig
 {
     int    sample_rate;           ///< 采样率
     int    pdr_duration;          ///< 送给PDR算法的时间间隔
-    char*  model_name;            ///< 模型名
+    char*  model_name;            ///< 步长模型名：Mean、Linear、SVR、DecisionTree、RandomForest、GradientBoosting、KNeighbors
     char*  model_file_name;       ///< 保存/加载模型文件名
     int    clean_start;           ///< 训练时去除的头部不稳定数据
     int    clean_end;             ///< 训练时去除的尾部不稳定数据
@@ -23,6 +23,17 @@ typedef struct _PDRConfig
     double optimized_mode_ratio;  ///< 计算初始方向时两种方案所占百分比(单点方向和使用最小化平均)
     double butter_wn;             ///< 巴特沃斯滤波归一化频率
     int    least_start_point;     ///< 传给start函数的最少点数
+    int    butter_lookahead;      ///< 流式巴特沃斯滤波反向前视点数，0表示只做因果滤波（可选，默认为采样率）
+    int    fifo_watermark;        ///< 实时采集时IMU的FIFO水位(帧数)，>0时按水位突发读取，0表示逐点读取寄存器（可选，默认为0）
+    char*  device_backend;        ///< 实时推算的数据来源：i2c(传感器)、replay(回放device_replay_path)、synthetic(合成数据)（可选，默认为i2c）
+    char*  device_replay_path;    ///< 回放的采集数据目录，device_backend为replay时必须指定（可选）
+    double device_speed;          ///< 回放、合成数据的倍速，1为实时，<=0表示不控制节拍，此时推算来不及处理会暂停读取而不丢弃采样点（可选，默认为1）
+    int    device_irq_line;       ///< IMU的INT1所接GPIO中断线编号，>=0时改为中断驱动采集（等待数据就绪/FIFO水位边沿），-1表示按采样时刻轮询（可选，默认为-1）
+    char*  device_irq_chip;       ///< 中断线所在的GPIO芯片设备（可选，默认为/dev/gpiochip0）
+    char*  device_clock;          ///< 实时推算使用的时钟：real(系统单调时钟)、simulated(模拟时钟，回放、合成数据可在数秒内跑完数小时)（可选，默认为real）
+    char*  record_format;         ///< 实时推算保存传感器数据的格式：csv(文本)、binary(二进制记录.fmr)、compressed(压缩日志.fmz，适合长期记录)（可选，默认为csv）
+    int    output_queue_size;     ///< 实时推算异步输出队列可缓存的数据行数，存储跟不上时超出部分丢弃并计数（可选，默认为65536）
+    int    output_fsync_interval;  ///< 异步输出调用fsync的最小间隔（单位：毫秒），0为每次写入后调用，<0表示不调用（可选，默认为-1）
 } PDRConfig;
 
 /// @struct PDRPoint
@@ -102,6 +113,33 @@ typedef struct _PDRTrajectoryArray
     void*           ptr;    ///< 对象指针
 } PDRTrajectoryArray;
 
+/// @struct PDRAcquisitionStats
+/// @brief 实时模式下传感器采集线程的统计信息
+typedef struct _PDRAcquisitionStats
+{
+    unsigned long long acquired;          ///< 采集线程成功写入队列的采样点数
+    unsigned long long consumed;          ///< 推算线程从队列取出的采样点数
+    unsigned long long overruns;          ///< 队列已满而丢弃的采样点数
+    unsigned long long read_errors;       ///< 读取传感器失败的次数
+    unsigned long long missed_deadlines;  ///< 错过采样时刻而跳过的采样点数
+    unsigned long      queue_capacity;    ///< 队列容量（采样点数）
+    unsigned long      max_queue_depth;   ///< 队列中积压采样点数的最大值
+    double             clock_skew_ppm;    ///< 估计的传感器时钟相对主机时钟的频率偏差（单位：ppm），仅FIFO模式下有效
+} PDRAcquisitionStats;
+
+/// @struct PDROutputStats
+/// @brief 实时模式下异步输出(传感器数据、航迹数据)的统计信息
+typedef struct _PDROutputStats
+{
+    unsigned long long queued;        ///< 写入输出队列的数据行数
+    unsigned long long written;       ///< 已写入文件的数据行数
+    unsigned long long dropped;       ///< 队列已满而丢弃的数据行数
+    unsigned long long write_errors;  ///< 写入文件失败而丢失的数据行数
+    unsigned long      queue_depth;   ///< 队列中尚未写入的数据行数
+    unsigned long      max_depth;     ///< 队列中数据行数的最大值
+    unsigned long      capacity;      ///< 队列容量（数据行数）
+} PDROutputStats;
+
 /// @enum PDRResult
 /// @brief PDR接口返回值定义
 typedef enum _PDRResult
@@ -163,6 +201,24 @@ int fm_pdr_start( PDRHandler handler, PDRPoint* start_point, char* raw_data_path
 /// @return 无
 int fm_pdr_start_with_file( PDRHandler handler, char* sensor_file_path );
 
+/// @fn int fm_pdr_start_with_push( PDRHandler handler, PDRPoint* start_point )
+/// @brief 开始推送模式导航，传感器数据由调用方通过fm_pdr_push_samples推送
+/// @param handler [in] PDR句柄
+/// @param start_point [in] 起点经纬度数据，不可为空
+/// @return 0: 启动成功
+///         <0: 错误码
+int fm_pdr_start_with_push( PDRHandler handler, PDRPoint* start_point );
+
+/// @fn int fm_pdr_push_samples( PDRHandler handler, const PDRSensorData* sensor_data )
+/// @brief 推送传感器数据（单个采样点或小批量），增量推算行人航迹，推算结果通过fm_pdr_predict/fm_pdr_stop取得
+/// @details 各传感器数组按下标对齐，以acc_time作为时间轴，磁力计数据需已校准；lacc_x/lacc_y/lacc_z为NULL时使用AHRS估计重力。
+///          前least_start_point个点用于确定初始行进方向，之后每检测到一步输出一个位置点。同一句柄不能在多个线程中同时推送。
+/// @param handler [in] PDR句柄
+/// @param sensor_data [in] 传感器数据，函数返回后即可释放
+/// @return >=0: 本次推送新产生的位置点数量
+///         <0: 错误码
+int fm_pdr_push_samples( PDRHandler handler, const PDRSensorData* sensor_data );
+
 /// @fn int fm_pdr_predict( PDRHandler handler, PDRTrajectoryArray *trajectories_array )
 /// @brief 基于传感器数据，执行行人航迹推算预测
 /// @param handler [in] PDR句柄
@@ -211,22 +267,56 @@ int fm_pdr_get_config( PDRHandler handler, PDRConfig* config );
 /// @return 0: 保存成功；!=0: 保存失败
 int fm_pdr_save_trajectory_data( char* file_path, PDRTrajectoryArray* trajectories_array );
 
-// TODO:改为私有函数
+/// @fn int fm_pdr_save_trajectory_data_async( PDRHandler handler, char* file_path, PDRTrajectoryArray* trajectories_array )
+/// @brief 异步保存行人航迹数据：数据放入输出队列后立即返回，由输出线程批量写入file_path（CSV格式，与fm_pdr_save_trajectory_data相同），
+///        函数可以重复调用，每次追加写入数据；fm_pdr_stop返回前写完队列中的全部数据
+/// @param handler [in] PDR句柄
+/// @param file_path [in] 保存文件路径
+/// @param trajectories_array [in] 预测的行人航迹
+/// @return 0: 全部放入队列；>0: 队列已满而丢弃的条数；<0: 错误码
+int fm_pdr_save_trajectory_data_async( PDRHandler handler, char* file_path, PDRTrajectoryArray* trajectories_array );
+
+/// @fn int fm_pdr_get_output_stats( PDRHandler handler, PDROutputStats* stats )
+/// @brief 取得实时模式下异步输出的统计信息，可在导航过程中随时调用
+/// @param handler [in] PDR句柄
+/// @param stats [out] 输出统计信息，尚未有异步输出时全部为0
+/// @return 0: 成功
+///         <0: 错误码
+int fm_pdr_get_output_stats( PDRHandler handler, PDROutputStats* stats );
+
+/// @fn int fm_pdr_get_acquisition_stats( PDRHandler handler, PDRAcquisitionStats* stats )
+/// @brief 取得实时模式(fm_pdr_start)下采集线程的统计信息，可在导航过程中随时调用，每次fm_pdr_start时清零
+/// @param handler [in] PDR句柄
+/// @param stats [out] 采集统计信息
+/// @return 0: 成功
+///         <0: 错误码
+int fm_pdr_get_acquisition_stats( PDRHandler handler, PDRAcquisitionStats* stats );
+
+// 传感器数据文件的读写：供采集、回放与离线分析使用，不需要PDR句柄；读取函数分配的数据由fm_pdr_free_pdr_data释放
+
 /// @fn int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data )
-/// @brief 读取dir_path目录传感器数据到PDRData结构体中
+/// @brief 读取dir_path目录传感器数据到PDRData结构体中，使用后调用fm_pdr_free_pdr_data释放
 /// @param dir_path [in] 保存文件路径
 /// @param pdr_data [out] PDR数据指针
 /// @return 0: 读取成功；!=0: 读取失败
 int fm_pdr_read_pdr_data( char* dir_path, PDRData* pdr_data );
 
-// TODO:改为私有函数
+/// @fn int fm_pdr_read_pdr_data_range( char* dir_path, double start_time, double end_time, PDRData* pdr_data )
+/// @brief 读取dir_path目录传感器数据中时间在[start_time, end_time)内的部分，二进制记录按块索引定位，
+///        只读取涉及的数据块，可用于在长时间的采集数据中跳转到任意片段
+/// @param dir_path [in] 保存文件路径
+/// @param start_time [in] 开始时间（单位：秒）
+/// @param end_time [in] 结束时间（单位：秒，不含）
+/// @param pdr_data [out] PDR数据指针
+/// @return 0: 读取成功；!=0: 读取失败
+int fm_pdr_read_pdr_data_range( char* dir_path, double start_time, double end_time, PDRData* pdr_data );
+
 /// @fn void fm_pdr_free_pdr_data( PDRData* pdr_data )
-/// @brief 释放PDRData结构体中的数据
+/// @brief 释放fm_pdr_read_pdr_data、fm_pdr_read_pdr_data_range读取到PDRData结构体中的数据
 /// @param pdr_data [in] PDR数据指针
 /// @return 无
 void fm_pdr_free_pdr_data( PDRData* pdr_data );
 
-// TODO:改为私有函数
 /// @fn int fm_pdr_save_pdr_data( char* dir_path, PDRData* pdr_data )
 /// @brief 保存传感器数据，函数可以重复调用，每次追加写入数据
 /// @param dir_path [in] 保存文件路径
@@ -234,6 +324,39 @@ void fm_pdr_free_pdr_data( PDRData* pdr_data );
 /// @return 0: 保存成功；!=0: 保存失败
 int fm_pdr_save_pdr_data( char* dir_path, PDRData* pdr_data );
 
+/// @fn int fm_pdr_save_pdr_record( char* dir_path, PDRData* pdr_data )
+/// @brief 以二进制记录格式(.fmr，与CSV文件同名)保存传感器数据，函数可以重复调用，每次追加一个数据块；
+///        数值按double原样写入，不做格式化，fm_pdr_read_pdr_data及文件模式的加载优先读取二进制记录
+/// @param dir_path [in] 保存文件路径
+/// @param pdr_data [in] PDR数据指针
+/// @return 0: 保存成功；!=0: 保存失败
+int fm_pdr_save_pdr_record( char* dir_path, PDRData* pdr_data );
+
+/// @fn int fm_pdr_convert_csv_to_record( char* dir_path )
+/// @brief 将dir_path目录下的传感器CSV文件(Accelerometer.csv等)转换为同名的二进制记录(.fmr)，已有的二进制记录被覆盖
+/// @param dir_path [in] 数据文件目录
+/// @return 0: 转换成功；!=0: 转换失败
+int fm_pdr_convert_csv_to_record( char* dir_path );
+
+/// @fn int fm_pdr_convert_record_to_csv( char* dir_path )
+/// @brief 将dir_path目录下的二进制记录(.fmr)转换为同名的CSV文件，已有的CSV文件被覆盖
+/// @param dir_path [in] 数据文件目录
+/// @return 0: 转换成功；!=0: 转换失败
+int fm_pdr_convert_record_to_csv( char* dir_path );
+
+/// @fn int fm_pdr_convert_csv_to_log( char* dir_path )
+/// @brief 将dir_path目录下的传感器CSV文件转换为同名的压缩日志(.fmz)，已有的压缩日志被覆盖；
+///        压缩日志按传感器原始分辨率无损存储差分，fm_pdr_read_pdr_data及文件模式的加载可直接读取
+/// @param dir_path [in] 数据文件目录
+/// @return 0: 转换成功；!=0: 转换失败
+int fm_pdr_convert_csv_to_log( char* dir_path );
+
+/// @fn int fm_pdr_convert_log_to_csv( char* dir_path )
+/// @brief 将dir_path目录下的压缩日志(.fmz)转换为同名的CSV文件，已有的CSV文件被覆盖
+/// @param dir_path [in] 数据文件目录
+/// @return 0: 转换成功；!=0: 转换失败
+int fm_pdr_convert_log_to_csv( char* dir_path );
+
 #ifdef __cplusplus
 }
 #endif
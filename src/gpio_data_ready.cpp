@@ -0,0 +1,65 @@
+#include "data_ready.h"
+#include "exception.h"
+#include <gpiod.h>
+#include <stdexcept>
+
+// 一次最多取出的积压边沿数
+constexpr size_t kEdgeEventCapacity = 16;
+
+CFmGpioDataReadyLine::CFmGpioDataReadyLine( const char* chip_path, unsigned int offset ) : m_chip( nullptr ), m_request( nullptr ), m_events( nullptr )
+{
+    m_chip = gpiod_chip_open( chip_path );
+    if ( ! m_chip )
+        throw FileException( FileException::OPEN_FAILED, chip_path );
+
+    // 输入、上升沿触发，边沿时间戳使用CLOCK_MONOTONIC，与采集时间轴一致
+    struct gpiod_line_settings*  settings    = gpiod_line_settings_new();
+    struct gpiod_line_config*    line_config = gpiod_line_config_new();
+    struct gpiod_request_config* req_config  = gpiod_request_config_new();
+    if ( settings && line_config && req_config )
+    {
+        gpiod_line_settings_set_direction( settings, GPIOD_LINE_DIRECTION_INPUT );
+        gpiod_line_settings_set_edge_detection( settings, GPIOD_LINE_EDGE_RISING );
+        gpiod_line_settings_set_event_clock( settings, GPIOD_LINE_CLOCK_MONOTONIC );
+        gpiod_request_config_set_consumer( req_config, "ICM42670_INT" );
+        gpiod_request_config_set_event_buffer_size( req_config, kEdgeEventCapacity );
+        if ( gpiod_line_config_add_line_settings( line_config, &offset, 1, settings ) == 0 )
+            m_request = gpiod_chip_request_lines( m_chip, req_config, line_config );
+    }
+    gpiod_request_config_free( req_config );
+    gpiod_line_config_free( line_config );
+    gpiod_line_settings_free( settings );
+
+    if ( m_request )
+        m_events = gpiod_edge_event_buffer_new( kEdgeEventCapacity );
+    if ( ! m_request || ! m_events )
+    {
+        if ( m_request )
+            gpiod_line_request_release( m_request );
+        gpiod_chip_close( m_chip );
+        throw std::runtime_error( "Failed to request GPIO data-ready line" );
+    }
+}
+
+CFmGpioDataReadyLine::~CFmGpioDataReadyLine()
+{
+    gpiod_edge_event_buffer_free( m_events );
+    gpiod_line_request_release( m_request );
+    gpiod_chip_close( m_chip );
+}
+
+int CFmGpioDataReadyLine::Wait( int64_t timeout_ns, int64_t& timestamp_ns )
+{
+    timestamp_ns = -1;
+
+    const int ret = gpiod_line_request_wait_edge_events( m_request, timeout_ns );
+    if ( ret <= 0 )
+        return ret;
+
+    const int count = gpiod_line_request_read_edge_events( m_request, m_events, kEdgeEventCapacity );
+    if ( count <= 0 )
+        return count;
+
+    timestamp_ns = static_cast< int64_t >( gpiod_edge_event_get_timestamp_ns( gpiod_edge_event_buffer_get_event( m_events, count - 1 ) ) );
+    return count;
+}
\ No newline at end of file
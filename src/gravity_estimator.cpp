@@ -0,0 +1,63 @@
+#include "gravity_estimator.h"
+
+CFmGravityEstimator::CFmGravityEstimator( const PDRConfig& config ) : m_sample_rate( config.sample_rate ), m_sample_count( 0 )
+{
+    reset();
+}
+CFmGravityEstimator::~CFmGravityEstimator() {}
+
+void CFmGravityEstimator::reset()
+{
+    FusionOffsetInitialise( &m_offset, m_sample_rate );
+    FusionAhrsInitialise( &m_ahrs );
+
+    // Set AHRS algorithm settings
+    const FusionAhrsSettings settings = {
+        .convention            = FusionConventionEnu,
+        .gain                  = 0.5f,
+        .gyroscopeRange        = 2000.0f, /* replace this with actual gyroscope range in degrees/s */
+        .accelerationRejection = 10.0f,
+        .magneticRejection     = 10.0f,
+        .recoveryTriggerPeriod = 5 * m_sample_rate, /* 5 seconds */
+    };
+    FusionAhrsSetSettings( &m_ahrs, &settings );
+
+    m_sample_count = 0;
+}
+
+Eigen::Vector3d CFmGravityEstimator::update( const Eigen::Vector3d& accelerometer, const Eigen::Vector3d& gyroscope, const Eigen::Vector3d& magnetometer )
+{
+    FusionVector acc  = { { static_cast< float >( accelerometer( 0 ) ), static_cast< float >( accelerometer( 1 ) ), static_cast< float >( accelerometer( 2 ) ) } };
+    FusionVector gyro = { { static_cast< float >( gyroscope( 0 ) ), static_cast< float >( gyroscope( 1 ) ), static_cast< float >( gyroscope( 2 ) ) } };
+    FusionVector mag  = { { static_cast< float >( magnetometer( 0 ) ), static_cast< float >( magnetometer( 1 ) ), static_cast< float >( magnetometer( 2 ) ) } };
+
+    // Apply calibration
+    gyro = FusionCalibrationInertial( gyro, m_gyroscopeMisalignment, m_gyroscopeSensitivity, m_gyroscopeOffset );
+    acc  = FusionCalibrationInertial( acc, m_accelerometerMisalignment, m_accelerometerSensitivity, m_accelerometerOffset );
+    mag  = FusionCalibrationMagnetic( mag, m_softIronMatrix, m_hardIronOffset );
+
+    // Update gyroscope offset correction algorithm
+    gyro = FusionOffsetUpdate( &m_offset, gyro );
+
+    // Calculate delta time (in seconds) to account for gyroscope sample clock error
+    const float deltaTime = 1.0f / m_sample_rate;
+
+    // Update gyroscope AHRS algorithm
+    FusionAhrsUpdate( &m_ahrs, gyro, acc, mag, deltaTime );
+    ++m_sample_count;
+
+    // Get gravity vector
+    const FusionVector grav = FusionAhrsGetGravity( &m_ahrs );
+    return Eigen::Vector3d( grav.axis.x, grav.axis.y, grav.axis.z );
+}
+
+Eigen::MatrixXd CFmGravityEstimator::update_batch( const Eigen::MatrixXd& accelerometer, const Eigen::MatrixXd& gyroscope, const Eigen::MatrixXd& magnetometer )
+{
+    const Eigen::Index rows = accelerometer.rows();
+    Eigen::MatrixXd    gravity( rows, 3 );
+
+    for ( Eigen::Index i = 0; i < rows; ++i )
+        gravity.row( i ) = update( Eigen::Vector3d( accelerometer.row( i ).transpose() ), Eigen::Vector3d( gyroscope.row( i ).transpose() ), Eigen::Vector3d( magnetometer.row( i ).transpose() ) ).transpose();
+
+    return gravity;
+}
\ No newline at end of file
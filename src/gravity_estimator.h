@@ -0,0 +1,43 @@
+#pragma once
+#include "Fusion.h"
+#include "fm_pdr.h"
+#include <eigen3/Eigen/Dense>
+
+// 基于Fusion AHRS的重力估计器，姿态四元数与陀螺仪零偏状态在多次调用之间保持，
+// 实时模式下由句柄长期持有，每个窗口只需处理新增的采样点，避免每个窗口重新收敛
+class CFmGravityEstimator
+{
+public:
+    CFmGravityEstimator( const PDRConfig& config );
+    ~CFmGravityEstimator();
+
+    // 恢复初始状态，下一次估计将重新收敛
+    void reset();
+    // 输入单个采样点，返回更新后的重力估计
+    Eigen::Vector3d update( const Eigen::Vector3d& accelerometer, const Eigen::Vector3d& gyroscope, const Eigen::Vector3d& magnetometer );
+    // 按行依次输入采样点，返回每个采样点的重力估计
+    Eigen::MatrixXd update_batch( const Eigen::MatrixXd& accelerometer, const Eigen::MatrixXd& gyroscope, const Eigen::MatrixXd& magnetometer );
+
+    // 已处理的采样点数
+    inline unsigned long get_sample_count() const
+    {
+        return m_sample_count;
+    }
+private:
+    const unsigned int m_sample_rate;
+    unsigned long      m_sample_count;
+
+    // Define calibration (replace with actual calibration data if available)
+    FusionMatrix m_gyroscopeMisalignment     = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    FusionVector m_gyroscopeSensitivity      = { 1.0f, 1.0f, 1.0f };
+    FusionVector m_gyroscopeOffset           = { 0.0f, 0.0f, 0.0f };
+    FusionMatrix m_accelerometerMisalignment = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    FusionVector m_accelerometerSensitivity  = { 1.0f, 1.0f, 1.0f };
+    FusionVector m_accelerometerOffset       = { 0.0f, 0.0f, 0.0f };
+    FusionMatrix m_softIronMatrix            = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    FusionVector m_hardIronOffset            = { 0.0f, 0.0f, 0.0f };
+
+    // Initialise algorithms
+    FusionOffset m_offset;
+    FusionAhrs   m_ahrs;
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "heading_kernel.h"
+
+#if defined( __x86_64__ ) && defined( __GNUC__ )
+#include <immintrin.h>
+#define FM_HEADING_AVX2
+#endif
+
+namespace
+{
+// e与e0的有符号夹角（单位：度）：(e×e0)·g>0时为负，<0时为正，=0时为0
+inline double signed_angle( double ex, double ey, double ez, double gx, double gy, double gz, const double e0[ 3 ] )
+{
+    const double dot = ex * e0[ 0 ] + ey * e0[ 1 ] + ez * e0[ 2 ];
+    const double cx  = ey * e0[ 2 ] - ez * e0[ 1 ];
+    const double cy  = ez * e0[ 0 ] - ex * e0[ 2 ];
+    const double cz  = ex * e0[ 1 ] - ey * e0[ 0 ];
+    const double cg  = cx * gx + cy * gy + cz * gz;
+
+    const double angle = fast_atan2( std::sqrt( cx * cx + cy * cy + cz * cz ), dot ) * 180.0 / M_PI;
+    return ( cg > 0 ) ? -angle : ( cg < 0 ) ? angle : 0.0;
+}
+
+// 规范化到[0, 360)：direction0在[0, 360)时只需加减一次360，与fmod结果相同，超出(-360, 720)时使用fmod
+inline double wrap_direction( double direction )
+{
+    if ( direction >= 360.0 && direction < 720.0 )
+        return direction - 360.0;
+    if ( direction < 0 && direction > -360.0 )
+        return direction + 360.0;
+    if ( direction >= 0 && direction < 360.0 )
+        return direction;
+
+    direction = std::fmod( direction, 360.0 );
+    return ( direction < 0 ) ? direction + 360.0 : direction;
+}
+
+inline double heading_direction( const double* const mag[ 3 ], const double* const grv[ 3 ], size_t i, const double e0[ 3 ], double direction0 )
+{
+    const double gx = grv[ 0 ][ i ], gy = grv[ 1 ][ i ], gz = grv[ 2 ][ i ];
+    const double mx = mag[ 0 ][ i ], my = mag[ 1 ][ i ], mz = mag[ 2 ][ i ];
+
+    // 东向量e = g × m
+    const double ex = gy * mz - gz * my;
+    const double ey = gz * mx - gx * mz;
+    const double ez = gx * my - gy * mx;
+    return wrap_direction( direction0 + signed_angle( ex, ey, ez, gx, gy, gz, e0 ) );
+}
+
+#ifdef FM_HEADING_AVX2
+__attribute__( ( target( "avx2" ) ) ) inline __m256d fast_atan2_avx2( __m256d y, __m256d x )
+{
+    const __m256d sign = _mm256_set1_pd( -0.0 );
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d ay   = _mm256_andnot_pd( sign, y );
+    const __m256d ax   = _mm256_andnot_pd( sign, x );
+    const __m256d hi   = _mm256_max_pd( ax, ay );
+    const __m256d lo   = _mm256_min_pd( ax, ay );
+    const __m256d a    = _mm256_and_pd( _mm256_div_pd( lo, hi ), _mm256_cmp_pd( hi, zero, _CMP_GT_OQ ) );
+    const __m256d t    = _mm256_mul_pd( a, a );
+
+    __m256d p = _mm256_set1_pd( kAtanCoeffs[ kAtanTerms - 1 ] );
+    for ( int k = kAtanTerms - 2; k >= 0; --k )
+        p = _mm256_add_pd( _mm256_mul_pd( p, t ), _mm256_set1_pd( kAtanCoeffs[ k ] ) );
+
+    __m256d r = _mm256_mul_pd( a, p );
+    r         = _mm256_blendv_pd( r, _mm256_sub_pd( _mm256_set1_pd( M_PI_2 ), r ), _mm256_cmp_pd( ay, ax, _CMP_GT_OQ ) );
+    r         = _mm256_blendv_pd( r, _mm256_sub_pd( _mm256_set1_pd( M_PI ), r ), _mm256_cmp_pd( x, zero, _CMP_LT_OQ ) );
+    return _mm256_or_pd( r, _mm256_and_pd( sign, y ) );
+}
+
+// 每次处理4行，返回已处理的行数
+__attribute__( ( target( "avx2" ) ) ) size_t heading_directions_avx2( const double* const mag[ 3 ], const double* const grv[ 3 ], size_t rows, const double e0[ 3 ], double direction0, double* direction )
+{
+    const __m256d e0x   = _mm256_set1_pd( e0[ 0 ] );
+    const __m256d e0y   = _mm256_set1_pd( e0[ 1 ] );
+    const __m256d e0z   = _mm256_set1_pd( e0[ 2 ] );
+    const __m256d dir0  = _mm256_set1_pd( direction0 );
+    const __m256d zero  = _mm256_setzero_pd();
+    const __m256d sign  = _mm256_set1_pd( -0.0 );
+    const __m256d full  = _mm256_set1_pd( 360.0 );
+    const __m256d lower = _mm256_set1_pd( -360.0 );
+    const __m256d upper = _mm256_set1_pd( 720.0 );
+
+    size_t i = 0;
+    for ( ; i + 4 <= rows; i += 4 )
+    {
+        const __m256d gx = _mm256_loadu_pd( grv[ 0 ] + i );
+        const __m256d gy = _mm256_loadu_pd( grv[ 1 ] + i );
+        const __m256d gz = _mm256_loadu_pd( grv[ 2 ] + i );
+        const __m256d mx = _mm256_loadu_pd( mag[ 0 ] + i );
+        const __m256d my = _mm256_loadu_pd( mag[ 1 ] + i );
+        const __m256d mz = _mm256_loadu_pd( mag[ 2 ] + i );
+
+        const __m256d ex = _mm256_sub_pd( _mm256_mul_pd( gy, mz ), _mm256_mul_pd( gz, my ) );
+        const __m256d ey = _mm256_sub_pd( _mm256_mul_pd( gz, mx ), _mm256_mul_pd( gx, mz ) );
+        const __m256d ez = _mm256_sub_pd( _mm256_mul_pd( gx, my ), _mm256_mul_pd( gy, mx ) );
+
+        const __m256d dot = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( ex, e0x ), _mm256_mul_pd( ey, e0y ) ), _mm256_mul_pd( ez, e0z ) );
+        const __m256d cx  = _mm256_sub_pd( _mm256_mul_pd( ey, e0z ), _mm256_mul_pd( ez, e0y ) );
+        const __m256d cy  = _mm256_sub_pd( _mm256_mul_pd( ez, e0x ), _mm256_mul_pd( ex, e0z ) );
+        const __m256d cz  = _mm256_sub_pd( _mm256_mul_pd( ex, e0y ), _mm256_mul_pd( ey, e0x ) );
+        const __m256d cg  = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( cx, gx ), _mm256_mul_pd( cy, gy ) ), _mm256_mul_pd( cz, gz ) );
+        const __m256d nc  = _mm256_sqrt_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( cx, cx ), _mm256_mul_pd( cy, cy ) ), _mm256_mul_pd( cz, cz ) ) );
+
+        __m256d angle = _mm256_div_pd( _mm256_mul_pd( fast_atan2_avx2( nc, dot ), _mm256_set1_pd( 180.0 ) ), _mm256_set1_pd( M_PI ) );
+        angle         = _mm256_and_pd( angle, _mm256_cmp_pd( cg, zero, _CMP_NEQ_OQ ) );
+        angle         = _mm256_blendv_pd( angle, _mm256_xor_pd( angle, sign ), _mm256_cmp_pd( cg, zero, _CMP_GT_OQ ) );
+        __m256d d     = _mm256_add_pd( dir0, angle );
+
+        const __m256d in_range = _mm256_and_pd( _mm256_cmp_pd( d, lower, _CMP_GT_OQ ), _mm256_cmp_pd( d, upper, _CMP_LT_OQ ) );
+        if ( _mm256_movemask_pd( in_range ) == 0xF )
+        {
+            d = _mm256_blendv_pd( d, _mm256_sub_pd( d, full ), _mm256_cmp_pd( d, full, _CMP_GE_OQ ) );
+            d = _mm256_blendv_pd( d, _mm256_add_pd( d, full ), _mm256_cmp_pd( d, zero, _CMP_LT_OQ ) );
+            _mm256_storeu_pd( direction + i, d );
+        }
+        else
+        {
+            alignas( 32 ) double lanes[ 4 ];
+            _mm256_store_pd( lanes, d );
+            for ( int k = 0; k < 4; ++k )
+                direction[ i + k ] = wrap_direction( lanes[ k ] );
+        }
+    }
+    return i;
+}
+
+bool cpu_has_avx2()
+{
+    static const bool has_avx2 = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports( "avx2" ) != 0;
+    }();
+    return has_avx2;
+}
+#endif
+}  // namespace
+
+double calc_heading_direction( const double e[ 3 ], const double g[ 3 ], const double e0[ 3 ], double direction0 )
+{
+    return wrap_direction( direction0 + signed_angle( e[ 0 ], e[ 1 ], e[ 2 ], g[ 0 ], g[ 1 ], g[ 2 ], e0 ) );
+}
+
+void calc_heading_directions( const double* const mag[ 3 ], const double* const grv[ 3 ], size_t rows, const double e0[ 3 ], double direction0, double* direction )
+{
+    size_t i = 0;
+#ifdef FM_HEADING_AVX2
+    if ( cpu_has_avx2() )
+        i = heading_directions_avx2( mag, grv, rows, e0, direction0, direction );
+#endif
+    for ( ; i < rows; ++i )
+        direction[ i ] = heading_direction( mag, grv, i, e0, direction0 );
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// atan(a) ≈ a·P(a²)，a∈[0, 1]，P为10次多项式(minimax拟合)，最大绝对误差1.4e-10弧度(8.0e-9度)
+constexpr int    kAtanTerms                = 11;
+constexpr double kAtanCoeffs[ kAtanTerms ] = { 0.99999999667243478,  -0.33333302089545597, 0.19999129798022858,   -0.14274432138862836,
+                                               0.11028651220095476,  -0.087138610789927254, 0.065413805093926358, -0.04208814285989055,
+                                               0.020467873207981848, -0.0063947884317457262, 0.00093756274766404956 };
+
+// 快速atan2：以min(|x|,|y|)/max(|x|,|y|)归约到[0, 1]后多项式求值，再按象限还原，
+// 最大绝对误差1.4e-10弧度；x、y均为0时返回0，只含乘加与一次除法，与AVX2版本(heading_kernel.cpp)逐位一致
+inline double fast_atan2( double y, double x )
+{
+    const double ay = std::fabs( y );
+    const double ax = std::fabs( x );
+    const double hi = std::max( ax, ay );
+    const double lo = std::min( ax, ay );
+    const double a  = ( hi > 0 ) ? lo / hi : 0.0;
+    const double t  = a * a;
+
+    double p = kAtanCoeffs[ kAtanTerms - 1 ];
+    for ( int k = kAtanTerms - 2; k >= 0; --k )
+        p = p * t + kAtanCoeffs[ k ];
+
+    double r = a * p;
+    if ( ay > ax )
+        r = M_PI_2 - r;
+    if ( x < 0 )
+        r = M_PI - r;
+    return std::copysign( r, y );
+}
+
+// 单点行进方向（单位：度，范围[0, 360)）：e与初始东向量e0的夹角由atan2(|e×e0|, e·e0)一次求出，
+// 方向由(e×e0)·g的符号确定，与CFmDirectionPredictor原acos算法的定义相同(e0不必与g垂直)
+double calc_heading_direction( const double e[ 3 ], const double g[ 3 ], const double e0[ 3 ], double direction0 );
+
+// 批量行进方向：mag、grv为滤波后磁场与重力的x/y/z三列(各列连续存放，即列主序矩阵的列)，
+// 一次遍历完成东向量e=g×m、与e0的有符号夹角和[0, 360)的规范化，结果写入direction[0, rows)；
+// x86上CPU支持AVX2时每次处理4行，其余平台及剩余行使用相同运算的标量实现，结果逐位一致
+void calc_heading_directions( const double* const mag[ 3 ], const double* const grv[ 3 ], size_t rows, const double e0[ 3 ], double direction0, double* direction );
\ No newline at end of file
@@ -68,20 +68,64 @@ public:
             return it->value.GetDouble();
         };
 
+        auto getOptionalIntMember = [ & ]( const char* key, int default_value ) -> int
+        {
+            auto it = doc.FindMember( key );
+            if ( it == doc.MemberEnd() )
+                return default_value;
+            if ( ! it->value.IsInt() )
+                throw JsonException( JsonException::TYPE_MISMATCH, "The data type of the " + std::string( key ) + "field is incorrect. It should be of int type.");
+
+            return it->value.GetInt();
+        };
+
+        auto getOptionalStringMember = [ & ]( const char* key ) -> char*
+        {
+            auto it = doc.FindMember( key );
+            if ( it == doc.MemberEnd() )
+                return nullptr;
+            if ( ! it->value.IsString() )
+                throw JsonException( JsonException::TYPE_MISMATCH, "The data type of the " + std::string( key ) + "field is incorrect. It should be of string type.");
+
+            return strdup( it->value.GetString() );  // 复制字符串（需手动释放）
+        };
+
+        auto getOptionalDoubleMember = [ & ]( const char* key, double default_value ) -> double
+        {
+            auto it = doc.FindMember( key );
+            if ( it == doc.MemberEnd() )
+                return default_value;
+            if ( ! it->value.IsNumber() )
+                throw JsonException( JsonException::TYPE_MISMATCH, "The data type of the " + std::string( key ) + "field is incorrect. It should be of double type.");
+
+            return it->value.GetDouble();
+        };
+
         // 映射字段到结构体
-        config.sample_rate          = getIntMember( "sample_rate" );
-        config.pdr_duration         = getIntMember( "pdr_duration" );
-        config.model_name           = getStringMember( "model_name" );
-        config.model_file_name      = getStringMember( "model_file_name" );
-        config.clean_start          = getIntMember( "clean_start" );
-        config.clean_end            = getIntMember( "clean_end" );
-        config.default_east_point   = getIntMember( "default_east_point" );
-        config.move_average         = getIntMember( "move_average" );
-        config.min_distance         = getIntMember( "min_distance" );
-        config.distance_frac_step   = getDoubleMember( "distance_frac_step" );
-        config.optimized_mode_ratio = getDoubleMember( "optimized_mode_ratio" );
-        config.butter_wn            = getDoubleMember( "butter_wn" );
-        config.least_start_point    = getIntMember( "least_start_point" );
+        config.sample_rate           = getIntMember( "sample_rate" );
+        config.pdr_duration          = getIntMember( "pdr_duration" );
+        config.model_name            = getStringMember( "model_name" );
+        config.model_file_name       = getStringMember( "model_file_name" );
+        config.clean_start           = getIntMember( "clean_start" );
+        config.clean_end             = getIntMember( "clean_end" );
+        config.default_east_point    = getIntMember( "default_east_point" );
+        config.move_average          = getIntMember( "move_average" );
+        config.min_distance          = getIntMember( "min_distance" );
+        config.distance_frac_step    = getDoubleMember( "distance_frac_step" );
+        config.optimized_mode_ratio  = getDoubleMember( "optimized_mode_ratio" );
+        config.butter_wn             = getDoubleMember( "butter_wn" );
+        config.least_start_point     = getIntMember( "least_start_point" );
+        config.butter_lookahead      = getOptionalIntMember( "butter_lookahead", config.sample_rate );
+        config.fifo_watermark        = getOptionalIntMember( "fifo_watermark", 0 );
+        config.device_backend        = getOptionalStringMember( "device_backend" );
+        config.device_replay_path    = getOptionalStringMember( "device_replay_path" );
+        config.device_speed          = getOptionalDoubleMember( "device_speed", 1.0 );
+        config.device_irq_line       = getOptionalIntMember( "device_irq_line", -1 );
+        config.device_irq_chip       = getOptionalStringMember( "device_irq_chip" );
+        config.device_clock          = getOptionalStringMember( "device_clock" );
+        config.record_format         = getOptionalStringMember( "record_format" );
+        config.output_queue_size     = getOptionalIntMember( "output_queue_size", 65536 );
+        config.output_fsync_interval = getOptionalIntMember( "output_fsync_interval", -1 );
 
         return config;
     }
@@ -1,7 +1,8 @@
 #include "merge_direction_step.h"
 #include "fm_pdr.h"
+#include "step_model.h"
 
-CFmMergeDirectionStep::CFmMergeDirectionStep( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_config( config ), m_valid_peak_value( 0.0f ), m_mean_step( 0.0f ), m_step_predictor( config, train_data ), m_direction_predictor( config )
+CFmMergeDirectionStep::CFmMergeDirectionStep( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_config( config ), m_valid_peak_value( 0.0f ), m_step_model( CFmStepModel::create( config.model_name ) ), m_step_predictor( config, train_data ), m_direction_predictor( config ), m_step_detector( config )
 {
     // 添加切片后的原始轨迹点
     train_position.resize( train_data.get_train_data_size(), 4 );
@@ -14,20 +15,17 @@ CFmMergeDirectionStep::CFmMergeDirectionStep( const PDRConfig& config, const CFm
     // StartInfo si = m_direction_predictor.start(train_data, m_config.least_start_point);
     // Eigen::VectorXd direction_pred = m_direction_predictor.predict_direction(si, train_data);
 
-    // 步长模型选择
-    if ( string( config.model_name ) != "Mean" )
-        m_model = m_step_predictor.step_process_regression( config.model_name, config.move_average, config.min_distance, config.distance_frac_step, config.model_file_name, m_valid_peak_value, false );
+    // 训练构造时按model_name创建的步长模型，平均步长按训练数据的总距离与总步数计算
+    if ( CFmMeanStepModel* mean = dynamic_cast< CFmMeanStepModel* >( m_step_model.get() ) )
+        mean->set_step_length( m_step_predictor.step_process_mean( config.move_average, config.min_distance, config.model_file_name, m_valid_peak_value ) );
     else
-        m_mean_step = m_step_predictor.step_process_mean( config.move_average, config.min_distance, config.model_file_name, m_valid_peak_value );
+        m_step_predictor.step_process_regression( *m_step_model, config.move_average, config.min_distance, config.distance_frac_step, config.model_file_name, m_valid_peak_value, false );
 }
 
-CFmMergeDirectionStep::CFmMergeDirectionStep( const PDRConfig& config ) : m_config( config ), m_valid_peak_value( 0.0f ), m_mean_step( 0.0f ), m_step_predictor( config ), m_direction_predictor( config )
+CFmMergeDirectionStep::CFmMergeDirectionStep( const PDRConfig& config ) : m_config( config ), m_valid_peak_value( 0.0f ), m_step_model( CFmStepModel::create( config.model_name ) ), m_step_predictor( config ), m_direction_predictor( config ), m_step_detector( config )
 {
-    // 步长模型选择
-    if ( string( config.model_name ) != "Mean" )
-        m_step_predictor.load_model( config.model_file_name, m_model, m_valid_peak_value );
-    else
-        m_step_predictor.load_model( config.model_file_name, m_mean_step, m_valid_peak_value );
+    // 加载构造时按model_name创建的步长模型
+    m_step_predictor.load_model( config.model_file_name, *m_step_model, m_valid_peak_value );
 }
 
 CFmMergeDirectionStep::~CFmMergeDirectionStep() {}
@@ -37,67 +35,77 @@ StartInfo CFmMergeDirectionStep::start( const CFmDataManager& start_data )
     StartInfo si = m_direction_predictor.start( start_data, m_config.least_start_point );
     si.last_x    = 0;
     si.last_y    = 0;
+
+    // 重新开始步态检测，丢弃上次推算未输出方向的点
+    m_step_detector.reset( m_valid_peak_value );
+    m_pending_time.clear();
+    m_pending_acc_mag.clear();
     return si;
 }
 
-// TODO: 暂时限定除最后一个送进来的数据，其它必须是查找峰值间隔数（20）的整数倍
-Eigen::MatrixXd CFmMergeDirectionStep::merge_dir_step( StartInfo& start_info, const CFmDataManager& process_data )
+Eigen::VectorXd CFmMergeDirectionStep::predict_step_lengths( const std::vector< DetectedStep >& steps ) const
 {
-    // 预测方向
-    Eigen::VectorXd direction_pred = m_direction_predictor.predict_direction( start_info, process_data );
+    const Eigen::Index count = steps.size();
+    StepFeatures       features( count, 2 );
+    for ( Eigen::Index i = 0; i < count; ++i )
+    {
+        features( i, 0 ) = steps[ i ].features( 0 );
+        features( i, 1 ) = steps[ i ].features( 1 );
+    }
+
+    return m_step_model->predict( features );
+}
+
+Eigen::MatrixXd CFmMergeDirectionStep::merge_dir_step( StartInfo& start_info, const CFmDataManager& process_data, bool is_last )
+{
+    // 预测方向，方向比输入滞后，只返回流式滤波已输出的点
+    Eigen::VectorXd direction_pred = m_direction_predictor.predict_direction( start_info, process_data, is_last );
     // for (auto dp : direction_pred)
     //     cout << dp << ",";
     // cout << endl;
 
-    Eigen::VectorXd filtered_accel_data;
-    const VectorXd& accelerometer_data_mag = process_data.get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
-    Eigen::VectorXi real_peak_indices      = m_step_predictor.find_real_peak_indices( accelerometer_data_mag, m_config.move_average, m_config.min_distance, filtered_accel_data, m_valid_peak_value );
-    // for (auto idx : real_peak_indices)
-    //     cout << idx << ",";
-    // cout << "size: " << real_peak_indices.size() << endl;
+    // 时间与加速度模长排队等待对应的方向
+    ConstVectorRef accelerometer_data_mag = process_data.get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
+    ConstVectorRef process_data_time      = process_data.get_pdr_data( PDR_DATA_FIELD_TIME );
+    m_pending_time.insert( m_pending_time.end(), process_data_time.data(), process_data_time.data() + process_data_time.size() );
+    m_pending_acc_mag.insert( m_pending_acc_mag.end(), accelerometer_data_mag.data(), accelerometer_data_mag.data() + accelerometer_data_mag.size() );
+
+    // 逐点送入步态检测，峰值与特征状态延续上一批数据，批次之间不丢步、不重复计步
+    const Eigen::Index rows = direction_pred.size();
+    for ( Eigen::Index i = 0; i < rows; ++i )
+        m_step_detector.push( m_pending_time[ i ], m_pending_acc_mag[ i ], direction_pred[ i ] );
+    m_pending_time.erase( m_pending_time.begin(), m_pending_time.begin() + rows );
+    m_pending_acc_mag.erase( m_pending_acc_mag.begin(), m_pending_acc_mag.begin() + rows );
+
+    // 最后一批数据输出剩余的最后一步
+    if ( is_last )
+        m_step_detector.finish();
 
-    Eigen::Index peak_size = real_peak_indices.size();
-    if ( peak_size < 2 )
+    std::vector< DetectedStep > steps = m_step_detector.take_steps();
+    if ( steps.empty() )
         return Eigen::MatrixXd();
-    
-    Eigen::MatrixXd trajectory( peak_size - 1, 4 );
-    for ( Eigen::Index i = 1; i < peak_size; ++i )
+
+    // 本批所有步的步长一次预测
+    Eigen::VectorXd step_lengths = predict_step_lengths( steps );
+
+    Eigen::MatrixXd trajectory( steps.size(), 4 );
+    for ( size_t i = 0; i < steps.size(); ++i )
     {
-        // 预测步长
-        double step_pred;
-        if ( std::string( m_config.model_name ) != "Mean" )
-        {
-            FeatureMatrix features = m_step_predictor.calculate_features( process_data, real_peak_indices, filtered_accel_data, i - 1, i );
-            step_pred              = m_model( features );
-        }
-        else
-        {
-            step_pred = m_mean_step;
-        }
-
-        // 计算平均方向
-        double          mean_direction;
-        int             start_idx   = real_peak_indices[ i ];
-        int             end_idx     = ( i == real_peak_indices.size() - 1 ? direction_pred.size() - real_peak_indices[ i ] : real_peak_indices[ i + 1 ] - real_peak_indices[ i ] + 1 );
-        Eigen::VectorXd dir_segment = direction_pred.segment( start_idx, end_idx );
-        mean_direction              = dir_segment.mean();
+        double step_pred = step_lengths[ i ];
 
         // 计算位移
-        double rad = mean_direction * M_PI / 180.0;
+        double rad = steps[ i ].direction * M_PI / 180.0;
         double dx  = step_pred * std::cos( rad );
         double dy  = step_pred * std::sin( rad );
 
-        start_info.last_x = ( i == 1 ) ? start_info.last_x : trajectory( i - 2, 1 );
-        start_info.last_y = ( i == 1 ) ? start_info.last_y : trajectory( i - 2, 2 );
-
         // 更新位置，这里修改为存储每一步的方向
-        const VectorXd& process_data_time = process_data.get_pdr_data( PDR_DATA_FIELD_TIME );
-        trajectory( i - 1, 0 )            = process_data_time[ real_peak_indices[ i ] ];
-        trajectory( i - 1, 1 )            = start_info.last_x + dx;
-        trajectory( i - 1, 2 )            = start_info.last_y + dy;
-        trajectory( i - 1, 3 )            = mean_direction;
+        start_info.last_x += dx;
+        start_info.last_y += dy;
 
-        // cout << "time: " << process_data_time[real_peak_indices[i]] << ", x: " << start_info.last_x + dx << ", y: " << start_info.last_y + dy << ", direction: " << mean_direction << endl;
+        trajectory( i, 0 ) = steps[ i ].time;
+        trajectory( i, 1 ) = start_info.last_x;
+        trajectory( i, 2 ) = start_info.last_y;
+        trajectory( i, 3 ) = steps[ i ].direction;
     }
 
     return trajectory;
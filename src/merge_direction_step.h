@@ -1,7 +1,13 @@
+#pragma once
 #include "data_file_loader.h"
 #include "direction_predictor.h"
 #include "fm_pdr.h"
+#include "step_detector.h"
 #include "step_predictor.h"
+#include <deque>
+#include <memory>
+
+class CFmStepModel;
 
 struct MergeResult
 {
@@ -17,13 +23,23 @@ public:
     ~CFmMergeDirectionStep();
 
     StartInfo       start( const CFmDataManager& start_data );
-    Eigen::MatrixXd merge_dir_step( StartInfo& start_info, const CFmDataManager& process_data );
+    Eigen::MatrixXd merge_dir_step( StartInfo& start_info, const CFmDataManager& process_data, bool is_last = true );
+    // 批量预测步长：各步特征组成矩阵后由步长模型一次求值
+    Eigen::VectorXd predict_step_lengths( const std::vector< DetectedStep >& steps ) const;
+
+    inline double get_valid_peak_value() const
+    {
+        return m_valid_peak_value;
+    }
 private:
     const PDRConfig& m_config;
     double           m_valid_peak_value;
-    LinearModel      m_model;
-    double           m_mean_step;
+
+    std::unique_ptr< CFmStepModel > m_step_model;  // 按model_name在构造时创建
 
     CFmStepPredictor      m_step_predictor;
     CFmDirectionPredictor m_direction_predictor;
+    CFmStepDetector       m_step_detector;    // 步态检测状态在各批数据之间保持
+    std::deque< double >  m_pending_time;     // 已输入、方向尚未输出的点的时间
+    std::deque< double >  m_pending_acc_mag;  // 已输入、方向尚未输出的点的加速度模长
 };
\ No newline at end of file
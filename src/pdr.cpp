@@ -2,9 +2,9 @@
 
 // bool compare_time( double t_val, const PDRPosition& pos );
 
-CFmPDR::CFmPDR( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_merge_direction_step( config, train_data, train_position ) {}
+CFmPDR::CFmPDR( const PDRConfig& config, const CFmDataManager& train_data, Eigen::MatrixXd& train_position ) : m_merge_direction_step( config, train_data, train_position ), m_have_last_step( false ) {}
 
-CFmPDR::CFmPDR( const PDRConfig& config ) : m_merge_direction_step( config ) {}
+CFmPDR::CFmPDR( const PDRConfig& config ) : m_merge_direction_step( config ), m_have_last_step( false ) {}
 
 CFmPDR::~CFmPDR() {}
 
@@ -16,49 +16,18 @@ StartInfo CFmPDR::start( double x0, double y0, const CFmDataManager& start_data
     si.x0 = x0;
     si.y0 = y0;
 
-    return si;
-}
-
-size_t CFmPDR::find_interval( double t, const MatrixXd& trajectory ) const
-{
-    const size_t n = trajectory.rows();
-
-    if ( n < 2 )
-        return 0;
-
-    size_t low  = 0;
-    size_t high = n - 2;  // 最大有效索引是 n-2
-
-    while ( low <= high )
-    {
-        size_t mid    = low + ( high - low ) / 2;
-        double t_mid  = trajectory( mid, 0 );
-        double t_next = trajectory( mid + 1, 0 );
-
-        if ( t >= t_mid && t < t_next )
-        {
-            return mid;
-        }
-        else if ( t < t_mid )
-        {
-            high = mid - 1;
-        }
-        else
-        {
-            low = mid + 1;
-        }
-    }
+    m_have_last_step = false;
 
-    // 如果没找到，返回最后一个区间
-    return n - 2;
+    return si;
 }
 
-// 核心插值函数（返回Eigen矩阵）
-MatrixXd CFmPDR::linear_interpolation( const VectorXd& target_times, const MatrixXd& trajectory )
+// 核心插值函数（返回Eigen矩阵）：目标时间与轨迹时间都递增，一次归并扫描找出落在同一轨迹区间的连续目标，
+// 同一区间的端点与增量相同，整段按列插值，O(n+m)
+MatrixXd CFmPDR::linear_interpolation( ConstVectorRef target_times, const MatrixXd& trajectory )
 {
     // 0. 边界处理
-    const size_t traj_rows   = trajectory.rows();
-    const size_t num_targets = target_times.size();
+    const Eigen::Index traj_rows   = trajectory.rows();
+    const Eigen::Index num_targets = target_times.size();
     if ( traj_rows == 0 || num_targets == 0 )
         return MatrixXd();
 
@@ -68,11 +37,11 @@ MatrixXd CFmPDR::linear_interpolation( const VectorXd& target_times, const Matri
 
     // 2. 准备结果矩阵
     MatrixXd result( num_targets, 4 );
+    result.col( 0 ) = target_times;
 
     // 3. 单点轨迹处理
     if ( traj_rows == 1 )
     {
-        result.col( 0 ) = target_times;
         result.col( 1 ).fill( trajectory( 0, 1 ) );
         result.col( 2 ).fill( trajectory( 0, 2 ) );
         result.col( 3 ).fill( trajectory( 0, 3 ) );
@@ -80,61 +49,95 @@ MatrixXd CFmPDR::linear_interpolation( const VectorXd& target_times, const Matri
     }
 
     // 4. 获取时间范围
-    const double first_time = trajectory( 0, 0 );
-    const double last_time  = trajectory( traj_rows - 1, 0 );
-
-    for ( size_t i = 0; i < num_targets; ++i )
+    const double* times      = trajectory.col( 0 ).data();
+    const double  first_time = times[ 0 ];
+    const double  last_time  = times[ traj_rows - 1 ];
+
+    // 5. 目标所在区间：首时刻之前为第0段，末时刻之后为最后一段（外推），其余为t_k <= t < t_(k+1)的第k段；
+    //    扫描位置只前进，目标时间回退时从头扫描
+    Eigen::Index k        = 0;
+    auto         interval = [ & ]( double t ) -> Eigen::Index {
+        if ( t <= first_time )
+            return 0;
+        if ( t >= last_time )
+            return traj_rows - 2;
+        if ( t < times[ k ] )
+            k = 0;
+        while ( t >= times[ k + 1 ] )
+            ++k;
+        return k;
+    };
+
+    for ( Eigen::Index i = 0; i < num_targets; )
     {
-        const double t = target_times( i );
-        RowVector4d  interp_row;
-        interp_row( 0 ) = t;
-
-        // 5. 统一使用线性插值（包括边界情况）
-        size_t idx = ( t <= first_time ) ? 0 : ( t >= last_time ) ? traj_rows - 2 : find_interval( t, trajectory );
-
-        const RowVector4d& p0 = trajectory.row( idx );
-        const RowVector4d& p1 = trajectory.row( idx + 1 );
-
-        // 6. 计算精确的插值比例
-        double time_diff = p1( 0 ) - p0( 0 );
-        double ratio     = ( time_diff > 1e-10 ) ? ( t - p0( 0 ) ) / time_diff : 0.0;
+        const Eigen::Index idx = interval( target_times( i ) );
+        Eigen::Index       end = i + 1;
+        while ( end < num_targets && interval( target_times( end ) ) == idx )
+            ++end;
+        const Eigen::Index len = end - i;
+
+        // 6. 计算精确的插值比例，暂存在方向列
+        const double t0        = times[ idx ];
+        const double time_diff = times[ idx + 1 ] - t0;
+        auto         ratio     = result.col( 3 ).segment( i, len ).array();
+        if ( time_diff > 1e-10 )
+            ratio = ( target_times.segment( i, len ).array() - t0 ) / time_diff;
+        else
+            ratio.setZero();
 
         // 7. 线性插值x和y
-        interp_row( 1 ) = p0( 1 ) + ratio * ( p1( 1 ) - p0( 1 ) );
-        interp_row( 2 ) = p0( 2 ) + ratio * ( p1( 2 ) - p0( 2 ) );
-
-        // 8. 严格的角度插值（确保总是执行）
-        double v0   = p0( 3 );
-        double v1   = p1( 3 );
-        double diff = v1 - v0;
-
-        // 处理角度环绕
+        const double x0 = trajectory( idx, 1 );
+        const double y0 = trajectory( idx, 2 );
+        result.col( 1 ).segment( i, len ).array() = x0 + ratio * ( trajectory( idx + 1, 1 ) - x0 );
+        result.col( 2 ).segment( i, len ).array() = y0 + ratio * ( trajectory( idx + 1, 2 ) - y0 );
+
+        // 8. 角度插值，处理角度环绕
+        const double v0   = trajectory( idx, 3 );
+        double       diff = trajectory( idx + 1, 3 ) - v0;
         if ( diff > 180.0 )
             diff -= 360.0;
         else if ( diff < -180.0 )
             diff += 360.0;
 
-        double interpolated_dir = v0 + diff * ratio;
-
-        // 标准化到[0,360)
-        interpolated_dir = fmod( interpolated_dir, 360.0 );
-        if ( interpolated_dir < 0.0 )
-            interpolated_dir += 360.0;
-
-        interp_row( 3 ) = interpolated_dir;
+        // 标准化到[0,360)：插值结果在(-360,720)内时减360与fmod结果相同且无舍入，只有超出该范围(外推)时调用fmod
+        double* direction = result.col( 3 ).data() + i;
+        for ( Eigen::Index j = 0; j < len; ++j )
+        {
+            double dir = v0 + diff * direction[ j ];
+            if ( dir > -360.0 && dir < 720.0 )
+                dir = dir >= 360.0 ? dir - 360.0 : dir;
+            else
+                dir = fmod( dir, 360.0 );
+            direction[ j ] = dir < 0.0 ? dir + 360.0 : dir;
+        }
 
-        result.row( i ) = interp_row;
+        i = end;
     }
 
     return result;
 }
 
-MatrixXd CFmPDR::pdr( StartInfo& start_info, const CFmDataManager& process_data )
+MatrixXd CFmPDR::pdr( StartInfo& start_info, const CFmDataManager& process_data, bool is_last )
 {
-    Eigen::MatrixXd trajectory = m_merge_direction_step.merge_dir_step( start_info, process_data );
-    if ( 0 == trajectory.rows() )
+    Eigen::MatrixXd steps = m_merge_direction_step.merge_dir_step( start_info, process_data, is_last );
+    if ( 0 == steps.rows() )
         return Eigen::MatrixXd();
 
+    // 分批推算时，以上一批的最后一步作为本批轨迹的起点，使批次之间的插值连续
+    Eigen::MatrixXd trajectory;
+    if ( m_have_last_step )
+    {
+        trajectory.resize( steps.rows() + 1, 4 );
+        trajectory.row( 0 )                   = m_last_step;
+        trajectory.bottomRows( steps.rows() ) = steps;
+    }
+    else
+    {
+        trajectory = steps;
+    }
+    m_last_step      = steps.bottomRows( 1 );
+    m_have_last_step = ! is_last;
+
     // for ( Eigen::Index i = 0; i < trajectory.rows(); i++ )
     //     cout << "time:" << trajectory( i, 0 ) << ", x:" << trajectory( i, 1 ) << ", y:" << trajectory( i, 2 ) << ", direction:" << trajectory( i, 3 ) << endl;
 
@@ -142,17 +145,15 @@ MatrixXd CFmPDR::pdr( StartInfo& start_info, const CFmDataManager& process_data
     
     if ( process_data.have_location_true() )
     {
-        size_t          true_data_size = process_data.get_true_data_size();
-        const VectorXd& true_data_time = process_data.get_true_data( TRUE_DATA_FIELD_TIME );
-        Eigen::VectorXd time_location  = Eigen::Map< const Eigen::VectorXd >( true_data_time.data(), true_data_size );
-        t                              = linear_interpolation( time_location, trajectory );
+        const size_t   true_data_size = process_data.get_true_data_size();
+        ConstVectorRef true_data_time = process_data.get_true_data( TRUE_DATA_FIELD_TIME );
+        t                             = linear_interpolation( true_data_time.head( true_data_size ), trajectory );
     }
     else
     {
-        size_t          data_size     = process_data.get_pdr_data_size();
-        const VectorXd& data_time     = process_data.get_pdr_data( PDR_DATA_FIELD_TIME );
-        Eigen::VectorXd time_location = Eigen::Map< const Eigen::VectorXd >( data_time.data(), data_size );
-        t                             = linear_interpolation( time_location, trajectory );
+        const size_t   data_size = process_data.get_pdr_data_size();
+        ConstVectorRef data_time = process_data.get_pdr_data( PDR_DATA_FIELD_TIME );
+        t                        = linear_interpolation( data_time.head( data_size ), trajectory );
     }
 
     // cout << "==========================================================================================" << endl;
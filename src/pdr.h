@@ -1,3 +1,4 @@
+#pragma once
 #include "merge_direction_step.h"
 
 class CFmPDR
@@ -8,10 +9,17 @@ public:
     ~CFmPDR();
 
     StartInfo start( double x0, double y0, const CFmDataManager& start_data );
-    MatrixXd  pdr( StartInfo& start_info, const CFmDataManager& process_data );
+    // 分批推算时，is_last为false表示之后还有数据，尚未确定的最后一步留到下一批输出
+    MatrixXd  pdr( StartInfo& start_info, const CFmDataManager& process_data, bool is_last = true );
+
+    inline const CFmMergeDirectionStep& get_merge_direction_step() const
+    {
+        return m_merge_direction_step;
+    }
 private:
     CFmMergeDirectionStep m_merge_direction_step;
+    Eigen::RowVector4d    m_last_step;       // 上一批数据的最后一步(time, x, y, direction)
+    bool                  m_have_last_step;  // 是否有上一批数据的最后一步
 
-    size_t   find_interval( double t, const Eigen::MatrixXd& trajectory ) const;
-    MatrixXd linear_interpolation( const VectorXd& target_times, const MatrixXd& trajectory );
+    MatrixXd linear_interpolation( ConstVectorRef target_times, const MatrixXd& trajectory );
 };
\ No newline at end of file
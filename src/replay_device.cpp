@@ -0,0 +1,114 @@
+#include "replay_device.h"
+#include "exception.h"
+#include "table_reader.h"
+#include <vector>
+
+// 读取一个传感器的数据文件（二进制记录或CSV），第0列为时间，第1~3列为三轴数据
+static void load_sensor_table( const std::string& data_path, const std::string& name, std::vector< double >& time, Eigen::MatrixXd& values )
+{
+    auto table = CFmTableReader::open( data_path, name );
+    if ( ! table )
+        throw FileException( FileException::OPEN_FAILED, ( data_path + "/" + name + ".csv" ).c_str() );
+    if ( table->cols() < 4 )
+        throw FileException( FileException::READ_FAILED, ( data_path + "/" + name ).c_str() );
+
+    time.resize( table->rows() );
+    values.resize( table->rows(), 3 );
+    double* const columns[ 4 ] = { time.data(), values.col( 0 ).data(), values.col( 1 ).data(), values.col( 2 ).data() };
+    table->read_columns( 0, 4, columns, table->rows() );
+}
+
+// 在以t0为起点的均匀时间轴上取各时刻之前最近的采样值，写入samples的第col~col+2列
+static void resample_hold( const std::vector< double >& time, const Eigen::MatrixXd& values, double t0, int sample_rate, Eigen::MatrixXd& samples, int col )
+{
+    size_t idx = 0;
+    for ( Eigen::Index i = 0; i < samples.rows(); ++i )
+    {
+        const double t = t0 + static_cast< double >( i ) / sample_rate;
+        while ( idx + 1 < time.size() && t >= time[ idx + 1 ] )
+            ++idx;
+        samples.block( i, col, 1, 3 ) = values.row( idx );
+    }
+}
+
+CFmReplayDevice::CFmReplayDevice( const std::string& data_path, int sample_rate, double speed, bool loop )
+    : CFmDeviceBackend( speed > 0 ? sample_rate * speed : 0 ), m_sample_rate( sample_rate ), m_loop( loop ), m_have_lacc( false ), m_cursor( 0 ), m_time_offset( 0.0 )
+{
+    if ( sample_rate <= 0 )
+        throw std::invalid_argument( "sample_rate must be greater than 0" );
+
+    std::vector< double > acc_time, lacc_time, gyr_time, mag_time;
+    Eigen::MatrixXd       acc, lacc, gyr, mag;
+    load_sensor_table( data_path, "Accelerometer", acc_time, acc );
+    load_sensor_table( data_path, "Gyroscope", gyr_time, gyr );
+    load_sensor_table( data_path, "Magnetometer", mag_time, mag );
+    m_have_lacc = CFmTableReader::exists( data_path, "Linear Accelerometer" );
+    if ( m_have_lacc )
+        load_sensor_table( data_path, "Linear Accelerometer", lacc_time, lacc );
+
+    if ( acc_time.empty() || gyr_time.empty() || mag_time.empty() || ( m_have_lacc && lacc_time.empty() ) )
+        throw DataException( DataException::EMPTY_ERROR, "Replay data is empty" );
+
+    // 以加速度计的时间范围为准，按采样率生成均匀时间轴
+    const double       t0    = acc_time.front();
+    const Eigen::Index count = static_cast< Eigen::Index >( ( acc_time.back() - t0 ) * sample_rate ) + 1;
+    m_samples                = Eigen::MatrixXd::Zero( count, 12 );
+    resample_hold( acc_time, acc, t0, sample_rate, m_samples, 0 );
+    if ( m_have_lacc )
+        resample_hold( lacc_time, lacc, t0, sample_rate, m_samples, 3 );
+    resample_hold( gyr_time, gyr, t0, sample_rate, m_samples, 6 );
+    resample_hold( mag_time, mag, t0, sample_rate, m_samples, 9 );
+}
+
+CFmReplayDevice::~CFmReplayDevice() {}
+
+unsigned long CFmReplayDevice::Read( PDRSensorData& sensor_data, unsigned long length, bool is_first )
+{
+    if ( is_first )
+    {
+        m_cursor      = 0;
+        m_time_offset = 0.0;
+    }
+
+    for ( unsigned long i = 0; i < length; ++i )
+    {
+        if ( m_cursor >= m_samples.rows() )
+        {
+            if ( ! m_loop )
+                return i;
+
+            // 从头循环，时间戳接着上一轮继续
+            m_time_offset += static_cast< double >( m_samples.rows() ) / m_sample_rate;
+            m_cursor = 0;
+        }
+
+        WaitNextSample( is_first );
+        is_first = false;
+
+        const double time = m_time_offset + static_cast< double >( m_cursor ) / m_sample_rate;
+        const auto   row  = m_samples.row( m_cursor++ );
+
+        sensor_data.acc_time[ i ] = time;
+        sensor_data.acc_x[ i ]    = row( 0 );
+        sensor_data.acc_y[ i ]    = row( 1 );
+        sensor_data.acc_z[ i ]    = row( 2 );
+        if ( m_have_lacc )
+        {
+            sensor_data.lacc_time[ i ] = time;
+            sensor_data.lacc_x[ i ]    = row( 3 );
+            sensor_data.lacc_y[ i ]    = row( 4 );
+            sensor_data.lacc_z[ i ]    = row( 5 );
+        }
+        sensor_data.gyr_time[ i ] = time;
+        sensor_data.gyr_x[ i ]    = row( 6 );
+        sensor_data.gyr_y[ i ]    = row( 7 );
+        sensor_data.gyr_z[ i ]    = row( 8 );
+        sensor_data.mag_time[ i ] = time;
+        sensor_data.mag_x[ i ]    = row( 9 );
+        sensor_data.mag_y[ i ]    = row( 10 );
+        sensor_data.mag_z[ i ]    = row( 11 );
+        sensor_data.length        = i + 1;
+    }
+
+    return length;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include "device_backend.h"
+#include <Eigen/Dense>
+#include <string>
+
+// 回放后端：读取采集目录(Accelerometer.csv、Gyroscope.csv、Magnetometer.csv，可选Linear Accelerometer.csv)，
+// 按采样率重采样到均匀时间轴（取前一个采样值）后，以speed倍速输出，speed<=0时不控制节拍
+class CFmReplayDevice : public CFmDeviceBackend
+{
+public:
+    CFmReplayDevice( const std::string& data_path, int sample_rate, double speed, bool loop );
+    ~CFmReplayDevice();
+
+    unsigned long Read( PDRSensorData& sensor_data, unsigned long length, bool is_first ) override;
+
+    inline Eigen::Index get_sample_count() const
+    {
+        return m_samples.rows();
+    }
+private:
+    int             m_sample_rate;
+    bool            m_loop;         // 读完后是否从头循环，循环时时间戳继续递增
+    bool            m_have_lacc;    // 是否包含线性加速度计数据
+    Eigen::MatrixXd m_samples;      // 每行依次为加速度计、线性加速度计、陀螺仪、磁力计的三轴数据
+    Eigen::Index    m_cursor;       // 下一个输出的采样点
+    double          m_time_offset;  // 循环回放累计的时间偏移（单位：秒）
+};
\ No newline at end of file
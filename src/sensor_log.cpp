@@ -0,0 +1,543 @@
+#include "sensor_log.h"
+#include "exception.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char     kFileMagic[ 8 ] = { 'F', 'M', 'P', 'D', 'R', 'L', 'O', 'G' };
+constexpr uint32_t kVersion        = 1;
+constexpr uint32_t kBlockMagic     = 0x424C4D46;  // "FMLB"
+constexpr uint32_t kMaxColumns     = 64;
+
+struct FmLogFileHeader
+{
+    char     magic[ 8 ];
+    uint32_t version;
+    uint32_t columns;
+    uint32_t header_size;  // 含列名，8字节对齐
+    uint32_t reserved;
+};
+
+struct FmLogBlockHeader
+{
+    uint32_t magic;
+    uint32_t rows;
+    uint32_t size;  // 块数据长度(不含块头)
+    uint32_t reserved;
+    double   first_time;
+    double   last_time;
+};
+
+struct FmLogColumnHeader
+{
+    uint8_t  codec;  // 低4位为量化方式，高4位为差分阶数
+    uint8_t  reserved[ 3 ];
+    uint32_t size;  // 列数据长度
+};
+
+static_assert( sizeof( FmLogFileHeader ) == 24, "log file header must be packed" );
+static_assert( sizeof( FmLogBlockHeader ) == 32, "log block header must be packed" );
+static_assert( sizeof( FmLogColumnHeader ) == 8, "log column header must be packed" );
+
+// 量化方式：数值按传感器的原始分辨率还原为整数计数，换算与device_wrapper.cpp、MMC56x3.cpp一致，
+// 编码时逐个校验由计数换算回的值与原值完全相同，有一个不同则该列不使用该方式
+enum FmLogQuantizer : uint8_t
+{
+    kQuantRaw,       // 原始8字节double
+    kQuantBits,      // double的位模式（数值平滑变化时差分较小）
+    kQuantGyro,      // ICM42670 ±2000dps：计数 / 16.4
+    kQuantMag,       // MMC56x3：(float)(20位计数 × 0.00625)
+    kQuantAcc,       // ICM42670 ±16g：9.8035f × 计数 / 2048
+    kQuantMicros,    // 微秒时间戳：计数 / 1e6
+    kQuantDecimal8,  // CSV的8位小数：计数 / 1e8
+    kQuantCount
+};
+
+// 与device_wrapper.cpp相同，重力加速度为float常量
+constexpr double kAccGravity = 9.8035f;
+// 数值乘以该系数后取整得到计数
+constexpr double kQuantScale[ kQuantCount ] = { 0.0, 0.0, 16.4, 1.0 / 0.00625, 2048.0 / kAccGravity, 1e6, 1e8 };
+
+static double dequantize( uint8_t quantizer, int64_t count )
+{
+    switch ( quantizer )
+    {
+        case kQuantGyro:
+            return count / 16.4;
+        case kQuantMag:
+            return static_cast< float >( static_cast< float >( count ) * 0.00625 );
+        case kQuantAcc:
+            return kAccGravity * count / 2048.0;
+        case kQuantMicros:
+            return count / 1e6;
+        case kQuantDecimal8:
+            return count / 1e8;
+        default:
+        {
+            double value;
+            memcpy( &value, &count, sizeof( value ) );
+            return value;
+        }
+    }
+}
+
+// 按量化方式把一列转为整数计数，不能无损还原时返回false
+static bool quantize( uint8_t quantizer, const double* values, size_t rows, int64_t* counts )
+{
+    if ( quantizer == kQuantBits )
+    {
+        memcpy( counts, values, rows * sizeof( double ) );
+        return true;
+    }
+
+    const double scale = kQuantScale[ quantizer ];
+    for ( size_t i = 0; i < rows; ++i )
+    {
+        // 超出2^52时计数不能精确表示，同时排除NaN与无穷
+        const double x = values[ i ] * scale;
+        if ( ! ( std::fabs( x ) < 4503599627370496.0 ) )
+            return false;
+        counts[ i ]        = std::llround( x );
+        const double value = dequantize( quantizer, counts[ i ] );
+        if ( memcmp( &value, &values[ i ], sizeof( value ) ) != 0 )
+            return false;
+    }
+    return true;
+}
+
+static void put_varint( uint64_t value, std::vector< uint8_t >& out )
+{
+    while ( value >= 0x80 )
+    {
+        out.push_back( static_cast< uint8_t >( value | 0x80 ) );
+        value >>= 7;
+    }
+    out.push_back( static_cast< uint8_t >( value ) );
+}
+
+// 读取一个变长整数，数据不完整时返回nullptr
+static const uint8_t* get_varint( const uint8_t* p, const uint8_t* end, uint64_t& value )
+{
+    value = 0;
+    for ( int shift = 0; shift < 64 && p < end; shift += 7 )
+    {
+        const uint8_t byte = *p++;
+        value |= static_cast< uint64_t >( byte & 0x7F ) << shift;
+        if ( ! ( byte & 0x80 ) )
+            return p;
+    }
+    return nullptr;
+}
+
+// 计数的差分按zigzag编码为变长整数，差分按无符号数回绕计算，位模式相减溢出时同样可逆；
+// 编码长度达到limit时放弃并返回false
+static bool encode_residuals( const int64_t* counts, size_t rows, int order, size_t limit, std::vector< uint8_t >& out )
+{
+    uint64_t prev       = 0;
+    uint64_t prev_delta = 0;
+    for ( size_t i = 0; i < rows; ++i )
+    {
+        const uint64_t value    = static_cast< uint64_t >( counts[ i ] );
+        const uint64_t delta    = value - prev;
+        const uint64_t residual = order == 2 && i > 1 ? delta - prev_delta : delta;
+        put_varint( residual << 1 ^ static_cast< uint64_t >( static_cast< int64_t >( residual ) >> 63 ), out );
+        if ( out.size() >= limit )
+            return false;
+        prev       = value;
+        prev_delta = delta;
+    }
+    return true;
+}
+
+// 编码一列追加到out，返回编码方式：尝试各量化方式的一阶、二阶差分，取最短的一种，都不短于原始数据时原样存储
+static uint8_t encode_column( const double* values, size_t rows, std::vector< int64_t >& counts, std::vector< uint8_t >& trial, std::vector< uint8_t >& out )
+{
+    const size_t raw_size = rows * sizeof( double );
+    const size_t start    = out.size();
+    uint8_t      codec    = kQuantRaw;
+    size_t       size     = raw_size;
+
+    counts.resize( rows );
+    for ( uint8_t quantizer = kQuantBits; quantizer < kQuantCount; ++quantizer )
+    {
+        if ( ! quantize( quantizer, values, rows, counts.data() ) )
+            continue;
+        for ( int order = 1; order <= 2; ++order )
+        {
+            trial.clear();
+            if ( ! encode_residuals( counts.data(), rows, order, size, trial ) )
+                continue;
+            out.resize( start );
+            out.insert( out.end(), trial.begin(), trial.end() );
+            codec = static_cast< uint8_t >( quantizer | order << 4 );
+            size  = trial.size();
+        }
+    }
+
+    if ( codec == kQuantRaw )
+    {
+        out.resize( start + raw_size );
+        memcpy( out.data() + start, values, raw_size );
+    }
+    return codec;
+}
+
+// 解码一列的前count行，数据损坏时返回false
+static bool decode_values( uint8_t codec, const uint8_t* p, const uint8_t* end, size_t rows, size_t count, double* values )
+{
+    const uint8_t quantizer = codec & 0x0F;
+    const int     order     = codec >> 4;
+    if ( quantizer == kQuantRaw )
+    {
+        if ( static_cast< size_t >( end - p ) != rows * sizeof( double ) )
+            return false;
+        memcpy( values, p, count * sizeof( double ) );
+        return true;
+    }
+    if ( quantizer >= kQuantCount || ( order != 1 && order != 2 ) )
+        return false;
+
+    uint64_t prev       = 0;
+    uint64_t prev_delta = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        uint64_t zigzag;
+        p = get_varint( p, end, zigzag );
+        if ( ! p )
+            return false;
+        const uint64_t residual = zigzag >> 1 ^ ( ~( zigzag & 1 ) + 1 );
+        const uint64_t delta    = order == 2 && i > 1 ? prev_delta + residual : residual;
+        prev                    = prev + delta;
+        prev_delta              = delta;
+        values[ i ]             = dequantize( quantizer, static_cast< int64_t >( prev ) );
+    }
+    return true;
+}
+
+// 校验文件头，返回列名，data为文件开头的size字节
+static bool parse_file_header( const char* data, size_t size, FmLogFileHeader& fh, std::vector< std::string >& header )
+{
+    if ( size < sizeof( fh ) )
+        return false;
+    memcpy( &fh, data, sizeof( fh ) );
+    if ( memcmp( fh.magic, kFileMagic, sizeof( kFileMagic ) ) != 0 || fh.version != kVersion )
+        return false;
+    if ( fh.columns == 0 || fh.columns > kMaxColumns || fh.header_size < sizeof( fh ) || fh.header_size > size || fh.header_size % 8 != 0 )
+        return false;
+
+    header.clear();
+    const char* p   = data + sizeof( fh );
+    const char* end = data + fh.header_size;
+    for ( uint32_t k = 0; k < fh.columns; ++k )
+    {
+        const char* nul = static_cast< const char* >( memchr( p, '\0', end - p ) );
+        if ( ! nul )
+            return false;
+        header.emplace_back( p, nul - p );
+        p = nul + 1;
+    }
+    return true;
+}
+
+// 数据块的总长度(含块头)，块不完整时返回0
+static size_t block_size( const FmLogBlockHeader& bh, size_t available )
+{
+    if ( bh.magic != kBlockMagic || bh.rows == 0 )
+        return 0;
+    const size_t size = sizeof( bh ) + bh.size;
+    return size <= available ? size : 0;
+}
+
+static bool write_all( int fd, const uint8_t* data, size_t size )
+{
+    while ( size > 0 )
+    {
+        const ssize_t n = write( fd, data, size );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast< size_t >( n );
+    }
+    return true;
+}
+
+CFmLogWriter::CFmLogWriter( const std::string& file_path, const std::vector< std::string >& header ) : m_file_path( file_path ), m_fd( -1 ), m_cols( header.size() ), m_size( 0 )
+{
+    if ( header.empty() || header.size() > kMaxColumns )
+        throw std::invalid_argument( "Invalid log column count: " + std::to_string( header.size() ) );
+
+    m_fd = open( file_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+    if ( m_fd < 0 )
+        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
+
+    try
+    {
+        struct stat st;
+        if ( fstat( m_fd, &st ) != 0 )
+            throw FileException( FileException::READ_FAILED, file_path.c_str() );
+
+        if ( st.st_size == 0 )
+        {
+            // 新文件：写入文件头与列名
+            std::string buffer( sizeof( FmLogFileHeader ), '\0' );
+            for ( const auto& name : header )
+                buffer.append( name.c_str(), name.size() + 1 );
+            buffer.resize( ( buffer.size() + 7 ) / 8 * 8, '\0' );
+
+            FmLogFileHeader fh;
+            memcpy( fh.magic, kFileMagic, sizeof( kFileMagic ) );
+            fh.version     = kVersion;
+            fh.columns     = static_cast< uint32_t >( m_cols );
+            fh.header_size = static_cast< uint32_t >( buffer.size() );
+            fh.reserved    = 0;
+            memcpy( &buffer[ 0 ], &fh, sizeof( fh ) );
+
+            if ( ! write_all( m_fd, reinterpret_cast< const uint8_t* >( buffer.data() ), buffer.size() ) )
+                throw FileException( FileException::WRITE_FAILED, file_path.c_str() );
+            m_size = buffer.size();
+        }
+        else
+        {
+            // 已有文件：校验文件头，再沿块头找到最后一个完整的数据块
+            const size_t        file_size = static_cast< size_t >( st.st_size );
+            std::vector< char > head( std::min< size_t >( file_size, 4096 ) );
+            if ( pread( m_fd, head.data(), head.size(), 0 ) != static_cast< ssize_t >( head.size() ) )
+                throw FileException( FileException::READ_FAILED, file_path.c_str() );
+
+            FmLogFileHeader            fh;
+            std::vector< std::string > names;
+            if ( ! parse_file_header( head.data(), head.size(), fh, names ) )
+                throw FileException( FileException::READ_FAILED, file_path.c_str() );
+            if ( fh.columns != m_cols )
+                throw DataException( DataException::COLUMN_INCONSISTENT, "Log '" + file_path + "' has " + std::to_string( fh.columns ) + " columns but expected " + std::to_string( m_cols ) );
+
+            m_size = fh.header_size;
+            FmLogBlockHeader bh;
+            while ( m_size + sizeof( bh ) <= file_size && pread( m_fd, &bh, sizeof( bh ), m_size ) == sizeof( bh ) )
+            {
+                const size_t size = block_size( bh, file_size - m_size );
+                if ( size == 0 )
+                    break;
+                m_size += size;
+            }
+
+            // 截掉写入中断留下的不完整数据块
+            if ( m_size < file_size && ftruncate( m_fd, m_size ) != 0 )
+                throw FileException( FileException::WRITE_FAILED, file_path.c_str() );
+        }
+    }
+    catch ( ... )
+    {
+        close( m_fd );
+        throw;
+    }
+}
+
+CFmLogWriter::~CFmLogWriter()
+{
+    if ( m_fd >= 0 )
+        close( m_fd );
+}
+
+void CFmLogWriter::append( const double* const* columns, size_t rows )
+{
+    if ( m_fd < 0 )
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+    if ( rows == 0 )
+        return;
+    if ( rows > std::numeric_limits< uint32_t >::max() )
+        throw std::invalid_argument( "Too many rows in one log block" );
+
+    // 块头之后依次编码各列，列头在编码后填写
+    std::vector< int64_t > counts;
+    std::vector< uint8_t > trial;
+    m_buffer.resize( sizeof( FmLogBlockHeader ) );
+    for ( size_t k = 0; k < m_cols; ++k )
+    {
+        const size_t start = m_buffer.size();
+        m_buffer.resize( start + sizeof( FmLogColumnHeader ) );
+
+        FmLogColumnHeader chd = {};
+        chd.codec             = encode_column( columns[ k ], rows, counts, trial, m_buffer );
+        chd.size              = static_cast< uint32_t >( m_buffer.size() - start - sizeof( chd ) );
+        memcpy( m_buffer.data() + start, &chd, sizeof( chd ) );
+    }
+    if ( m_buffer.size() - sizeof( FmLogBlockHeader ) > std::numeric_limits< uint32_t >::max() )
+        throw std::invalid_argument( "Too many rows in one log block" );
+
+    FmLogBlockHeader bh;
+    bh.magic      = kBlockMagic;
+    bh.rows       = static_cast< uint32_t >( rows );
+    bh.size       = static_cast< uint32_t >( m_buffer.size() - sizeof( bh ) );
+    bh.reserved   = 0;
+    bh.first_time = columns[ 0 ][ 0 ];
+    bh.last_time  = columns[ 0 ][ rows - 1 ];
+    memcpy( m_buffer.data(), &bh, sizeof( bh ) );
+
+    if ( ! write_all( m_fd, m_buffer.data(), m_buffer.size() ) )
+    {
+        // 截掉已写入的部分，不留下不完整的数据块，截断也失败时不再追加（下次打开时截掉）
+        if ( ftruncate( m_fd, m_size ) != 0 )
+        {
+            close( m_fd );
+            m_fd = -1;
+        }
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+    }
+    m_size += m_buffer.size();
+}
+
+void CFmLogWriter::sync()
+{
+    if ( m_fd >= 0 && fdatasync( m_fd ) != 0 )
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+}
+
+CFmLogReader::CFmLogReader( const std::string& file_path ) : m_file_path( file_path ), m_data( nullptr ), m_size( 0 )
+{
+    int fd = ::open( file_path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        throw FileException( FileException::READ_FAILED, file_path.c_str() );
+    }
+
+    m_size = static_cast< size_t >( st.st_size );
+    if ( m_size > 0 )
+    {
+        void* addr = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( addr == MAP_FAILED )
+        {
+            close( fd );
+            throw FileException( FileException::READ_FAILED, file_path.c_str() );
+        }
+        m_data = static_cast< const char* >( addr );
+    }
+    close( fd );
+
+    FmLogFileHeader fh;
+    if ( ! parse_file_header( m_data, m_size, fh, m_header ) )
+    {
+        if ( m_data )
+            munmap( const_cast< char* >( m_data ), m_size );
+        throw FileException( FileException::READ_FAILED, file_path.c_str() );
+    }
+
+    // 压缩后的文件较小，不另建索引，打开时沿块头建立块列表
+    size_t offset = fh.header_size;
+    while ( offset + sizeof( FmLogBlockHeader ) <= m_size )
+    {
+        FmLogBlockHeader bh;
+        memcpy( &bh, m_data + offset, sizeof( bh ) );
+        const size_t size = block_size( bh, m_size - offset );
+        if ( size == 0 )
+            break;
+
+        m_blocks.push_back( { offset, size, m_rows, bh.rows, bh.first_time, bh.last_time } );
+        m_rows += bh.rows;
+        offset += size;
+    }
+}
+
+CFmLogReader::~CFmLogReader()
+{
+    if ( m_data )
+        munmap( const_cast< char* >( m_data ), m_size );
+}
+
+void CFmLogReader::decode_column( const FmLogBlock& block, size_t col, size_t count, double* values ) const
+{
+    // 沿列头跳过前面的列
+    const uint8_t*    p   = reinterpret_cast< const uint8_t* >( m_data + block.offset + sizeof( FmLogBlockHeader ) );
+    const uint8_t*    end = reinterpret_cast< const uint8_t* >( m_data + block.offset + block.size );
+    FmLogColumnHeader chd;
+    for ( size_t k = 0;; ++k )
+    {
+        if ( static_cast< size_t >( end - p ) < sizeof( chd ) )
+            throw FileException( FileException::READ_FAILED, m_file_path.c_str() );
+        memcpy( &chd, p, sizeof( chd ) );
+        p += sizeof( chd );
+        if ( chd.size > static_cast< size_t >( end - p ) )
+            throw FileException( FileException::READ_FAILED, m_file_path.c_str() );
+        if ( k == col )
+            break;
+        p += chd.size;
+    }
+
+    if ( ! decode_values( chd.codec, p, p + chd.size, block.rows, count, values ) )
+        throw FileException( FileException::READ_FAILED, m_file_path.c_str() );
+}
+
+// 包含第row行的数据块
+static std::vector< FmLogBlock >::const_iterator block_of_row( const std::vector< FmLogBlock >& blocks, size_t row )
+{
+    auto it = std::upper_bound( blocks.begin(), blocks.end(), row, []( size_t r, const FmLogBlock& block ) { return r < block.row; } );
+    return it == blocks.begin() ? blocks.end() : it - 1;
+}
+
+size_t CFmLogReader::read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const
+{
+    if ( start_col < 0 || count <= 0 || first_row >= m_rows || max_rows == 0 )
+        return 0;
+
+    // 差分编码须从块首解码，块内跳过的行解码到临时缓存
+    const size_t          cols = m_header.size();
+    std::vector< double > decoded;
+    size_t                row = 0;
+    for ( auto it = block_of_row( m_blocks, first_row ); it != m_blocks.end() && row < max_rows; ++it )
+    {
+        const size_t skip = first_row + row - it->row;
+        const size_t n    = std::min( it->rows - skip, max_rows - row );
+        for ( int k = 0; k < count; ++k )
+        {
+            const size_t col = static_cast< size_t >( start_col + k );
+            if ( col >= cols )
+                std::fill( columns[ k ] + row, columns[ k ] + row + n, std::numeric_limits< double >::quiet_NaN() );
+            else if ( skip == 0 )
+                decode_column( *it, col, n, columns[ k ] + row );
+            else
+            {
+                decoded.resize( skip + n );
+                decode_column( *it, col, skip + n, decoded.data() );
+                std::copy( decoded.begin() + skip, decoded.end(), columns[ k ] + row );
+            }
+        }
+        row += n;
+    }
+
+    return row;
+}
+
+size_t CFmLogReader::lower_bound_row( double time ) const
+{
+    // 按块的末行时间找到首个可能包含该时间的块，只解码该块的时间列
+    auto it = std::lower_bound( m_blocks.begin(), m_blocks.end(), time, []( const FmLogBlock& block, double t ) { return block.last_time < t; } );
+    if ( it == m_blocks.end() )
+        return m_rows;
+
+    std::vector< double > column( it->rows );
+    decode_column( *it, 0, it->rows, column.data() );
+    return it->row + static_cast< size_t >( std::lower_bound( column.begin(), column.end(), time ) - column.begin() );
+}
+
+void CFmLogReader::find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const
+{
+    first_row             = lower_bound_row( start_time );
+    const size_t last_row = lower_bound_row( end_time );
+    num_rows              = last_row > first_row ? last_row - first_row : 0;
+}
\ No newline at end of file
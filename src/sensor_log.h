@@ -0,0 +1,83 @@
+#pragma once
+#include "table_reader.h"
+#include "table_writer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 压缩日志的扩展名，与同名CSV文件一一对应（如Accelerometer.fmz对应Accelerometer.csv）
+constexpr const char* kLogExtension = ".fmz";
+
+// 压缩日志格式（只追加，按本机字节序），用于在小容量存储上长期记录原始传感器数据：
+//   文件头：8字节魔数"FMPDRLOG"、版本、列数、文件头总长度(含列名，8字节对齐)，之后为以'\0'结尾的各列列名；
+//   数据块：块头(魔数、行数、块数据长度、首行与末行时间)，之后依次为各列：1字节编码方式、4字节长度、列数据。
+// 每列按块选择编码：数值能按传感器的原始分辨率(IMU的int16计数、MMC56x3的20位计数、微秒时间戳、CSV的8位小数)
+// 无损还原为整数时存储整数的一阶或二阶差分(zigzag变长整数)，时间等步长固定的列二阶差分多为0，只占1字节；
+// 都不能还原时存储double的位模式差分或原始8字节。数据块各自独立解码，文件末尾不完整的数据块在读取时忽略，追加时截掉。
+struct FmLogBlock
+{
+    size_t offset;      // 数据块(含块头)在文件中的偏移
+    size_t size;        // 数据块(含块头)的长度
+    size_t row;         // 首行的行号
+    size_t rows;        // 行数
+    double first_time;  // 首行时间
+    double last_time;   // 末行时间
+};
+
+// 压缩日志写入：每次append编码为一个数据块，由一次write写出
+class CFmLogWriter : public CFmTableWriter
+{
+public:
+    // 文件不存在时创建并写入文件头，已存在时校验列数后追加
+    CFmLogWriter( const std::string& file_path, const std::vector< std::string >& header );
+    ~CFmLogWriter() override;
+
+    CFmLogWriter( const CFmLogWriter& )            = delete;
+    CFmLogWriter& operator=( const CFmLogWriter& ) = delete;
+
+    void append( const double* const* columns, size_t rows ) override;
+    void sync() override;
+
+    inline size_t cols() const override
+    {
+        return m_cols;
+    }
+private:
+    std::string            m_file_path;
+    int                    m_fd;
+    size_t                 m_cols;
+    size_t                 m_size;    // 已写入的有效长度，写入失败时截回该长度
+    std::vector< uint8_t > m_buffer;  // 编码缓存，跨数据块复用
+};
+
+// 压缩日志读取：文件整体mmap映射，打开时沿块头建立块列表(不解码数据)，读取时只解码涉及的数据块与列，
+// CFmDataFileLoader经CFmTableReader::open直接按时间范围读取
+class CFmLogReader : public CFmTableReader
+{
+public:
+    explicit CFmLogReader( const std::string& file_path );
+    ~CFmLogReader();
+
+    CFmLogReader( const CFmLogReader& )            = delete;
+    CFmLogReader& operator=( const CFmLogReader& ) = delete;
+
+    // 超出文件列数的列为NaN
+    size_t read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const override;
+    // 按块头的时间范围二分查找，只解码边界上数据块的时间列
+    void find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const override;
+
+    inline const std::vector< FmLogBlock >& blocks() const
+    {
+        return m_blocks;
+    }
+private:
+    // 解码数据块第col列的前count行到values
+    void decode_column( const FmLogBlock& block, size_t col, size_t count, double* values ) const;
+    // 时间不小于time的首行
+    size_t lower_bound_row( double time ) const;
+
+    std::string               m_file_path;
+    const char*               m_data;  // 映射的文件内容
+    size_t                    m_size;
+    std::vector< FmLogBlock > m_blocks;
+};
\ No newline at end of file
@@ -0,0 +1,457 @@
+#include "sensor_record.h"
+#include "exception.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+constexpr char     kFileMagic[ 8 ]  = { 'F', 'M', 'P', 'D', 'R', 'R', 'E', 'C' };
+constexpr char     kIndexMagic[ 8 ] = { 'F', 'M', 'P', 'D', 'R', 'I', 'D', 'X' };
+constexpr uint32_t kVersion         = 1;
+constexpr uint32_t kChunkMagic      = 0x4B434D46;  // "FMCK"
+constexpr uint32_t kMaxColumns      = 64;
+
+struct FmRecordFileHeader
+{
+    char     magic[ 8 ];
+    uint32_t version;
+    uint32_t columns;
+    uint32_t header_size;  // 含列名，8字节对齐
+    uint32_t reserved;
+};
+
+struct FmRecordChunkHeader
+{
+    uint32_t magic;
+    uint32_t rows;
+    double   first_time;
+    double   last_time;
+};
+
+// 索引文件：文件头之后每个数据块一项，按块在记录文件中的顺序
+struct FmRecordIndexHeader
+{
+    char     magic[ 8 ];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct FmRecordIndexEntry
+{
+    uint64_t offset;
+    uint32_t rows;
+    uint32_t reserved;
+    double   first_time;
+    double   last_time;
+};
+
+static_assert( sizeof( FmRecordFileHeader ) == 24, "record file header must be packed" );
+static_assert( sizeof( FmRecordChunkHeader ) == 24, "record chunk header must be packed" );
+static_assert( sizeof( FmRecordIndexEntry ) == 32, "record index entry must be packed" );
+
+// 校验文件头，返回列名，data为文件开头的size字节
+static bool parse_file_header( const char* data, size_t size, FmRecordFileHeader& fh, std::vector< std::string >& header )
+{
+    if ( size < sizeof( fh ) )
+        return false;
+    memcpy( &fh, data, sizeof( fh ) );
+    if ( memcmp( fh.magic, kFileMagic, sizeof( kFileMagic ) ) != 0 || fh.version != kVersion )
+        return false;
+    if ( fh.columns == 0 || fh.columns > kMaxColumns || fh.header_size < sizeof( fh ) || fh.header_size > size || fh.header_size % 8 != 0 )
+        return false;
+
+    header.clear();
+    const char* p   = data + sizeof( fh );
+    const char* end = data + fh.header_size;
+    for ( uint32_t k = 0; k < fh.columns; ++k )
+    {
+        const char* nul = static_cast< const char* >( memchr( p, '\0', end - p ) );
+        if ( ! nul )
+            return false;
+        header.emplace_back( p, nul - p );
+        p = nul + 1;
+    }
+    return true;
+}
+
+// 数据块的总长度(含块头)，块不完整时返回0
+static size_t chunk_size( const FmRecordChunkHeader& ch, size_t cols, size_t available )
+{
+    if ( ch.magic != kChunkMagic || ch.rows == 0 )
+        return 0;
+    const size_t size = sizeof( ch ) + static_cast< size_t >( ch.rows ) * cols * sizeof( double );
+    return size <= available ? size : 0;
+}
+
+// 覆盖写入索引文件头，返回索引文件句柄，失败时返回-1（记录仍可读取，读取时沿块头扫描）
+static int create_index( const std::string& index_path )
+{
+    int fd = open( index_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644 );
+    if ( fd < 0 )
+        return -1;
+
+    FmRecordIndexHeader ih;
+    memcpy( ih.magic, kIndexMagic, sizeof( kIndexMagic ) );
+    ih.version  = kVersion;
+    ih.reserved = 0;
+    if ( write( fd, &ih, sizeof( ih ) ) != sizeof( ih ) )
+    {
+        close( fd );
+        return -1;
+    }
+    return fd;
+}
+
+CFmRecordWriter::CFmRecordWriter( const std::string& file_path, const std::vector< std::string >& header ) : m_file_path( file_path ), m_fd( -1 ), m_index_fd( -1 ), m_cols( header.size() ), m_size( 0 )
+{
+    if ( header.empty() || header.size() > kMaxColumns )
+        throw std::invalid_argument( "Invalid record column count: " + std::to_string( header.size() ) );
+
+    m_fd = open( file_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+    if ( m_fd < 0 )
+        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
+
+    try
+    {
+        struct stat st;
+        if ( fstat( m_fd, &st ) != 0 )
+            throw FileException( FileException::READ_FAILED, file_path.c_str() );
+
+        if ( st.st_size == 0 )
+        {
+            // 新文件：写入文件头与列名
+            std::string buffer( sizeof( FmRecordFileHeader ), '\0' );
+            for ( const auto& name : header )
+                buffer.append( name.c_str(), name.size() + 1 );
+            buffer.resize( ( buffer.size() + 7 ) / 8 * 8, '\0' );
+
+            FmRecordFileHeader fh;
+            memcpy( fh.magic, kFileMagic, sizeof( kFileMagic ) );
+            fh.version     = kVersion;
+            fh.columns     = static_cast< uint32_t >( m_cols );
+            fh.header_size = static_cast< uint32_t >( buffer.size() );
+            fh.reserved    = 0;
+            memcpy( &buffer[ 0 ], &fh, sizeof( fh ) );
+
+            if ( write( m_fd, buffer.data(), buffer.size() ) != static_cast< ssize_t >( buffer.size() ) )
+                throw FileException( FileException::WRITE_FAILED, file_path.c_str() );
+            m_size     = buffer.size();
+            m_index_fd = create_index( file_path + kRecordIndexSuffix );
+        }
+        else
+        {
+            // 已有文件：校验文件头，再沿块头找到最后一个完整的数据块
+            const size_t file_size = static_cast< size_t >( st.st_size );
+            std::vector< char > head( std::min< size_t >( file_size, 4096 ) );
+            if ( pread( m_fd, head.data(), head.size(), 0 ) != static_cast< ssize_t >( head.size() ) )
+                throw FileException( FileException::READ_FAILED, file_path.c_str() );
+
+            FmRecordFileHeader         fh;
+            std::vector< std::string > names;
+            if ( ! parse_file_header( head.data(), head.size(), fh, names ) )
+                throw FileException( FileException::READ_FAILED, file_path.c_str() );
+            if ( fh.columns != m_cols )
+                throw DataException( DataException::COLUMN_INCONSISTENT, "Record '" + file_path + "' has " + std::to_string( fh.columns ) + " columns but expected " + std::to_string( m_cols ) );
+
+            m_size = fh.header_size;
+            std::vector< FmRecordIndexEntry > entries;
+            FmRecordChunkHeader               ch;
+            while ( m_size + sizeof( ch ) <= file_size && pread( m_fd, &ch, sizeof( ch ), m_size ) == sizeof( ch ) )
+            {
+                const size_t size = chunk_size( ch, m_cols, file_size - m_size );
+                if ( size == 0 )
+                    break;
+                entries.push_back( { m_size, ch.rows, 0, ch.first_time, ch.last_time } );
+                m_size += size;
+            }
+
+            // 截掉写入中断留下的不完整数据块
+            if ( m_size < file_size && ftruncate( m_fd, m_size ) != 0 )
+                throw FileException( FileException::WRITE_FAILED, file_path.c_str() );
+
+            // 按扫描结果重建索引
+            m_index_fd         = create_index( file_path + kRecordIndexSuffix );
+            const size_t bytes = entries.size() * sizeof( FmRecordIndexEntry );
+            if ( m_index_fd >= 0 && bytes > 0 && write( m_index_fd, entries.data(), bytes ) != static_cast< ssize_t >( bytes ) )
+            {
+                close( m_index_fd );
+                m_index_fd = -1;
+            }
+        }
+    }
+    catch ( ... )
+    {
+        close( m_fd );
+        throw;
+    }
+}
+
+CFmRecordWriter::~CFmRecordWriter()
+{
+    if ( m_fd >= 0 )
+        close( m_fd );
+    if ( m_index_fd >= 0 )
+        close( m_index_fd );
+}
+
+void CFmRecordWriter::append( const double* const* columns, size_t rows )
+{
+    if ( m_fd < 0 )
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+    if ( rows == 0 )
+        return;
+    if ( rows > std::numeric_limits< uint32_t >::max() )
+        throw std::invalid_argument( "Too many rows in one record chunk" );
+
+    FmRecordChunkHeader ch;
+    ch.magic      = kChunkMagic;
+    ch.rows       = static_cast< uint32_t >( rows );
+    ch.first_time = columns[ 0 ][ 0 ];
+    ch.last_time  = columns[ 0 ][ rows - 1 ];
+
+    struct iovec iov[ 1 + kMaxColumns ];
+    iov[ 0 ].iov_base = &ch;
+    iov[ 0 ].iov_len  = sizeof( ch );
+    for ( size_t k = 0; k < m_cols; ++k )
+    {
+        iov[ 1 + k ].iov_base = const_cast< double* >( columns[ k ] );
+        iov[ 1 + k ].iov_len  = rows * sizeof( double );
+    }
+
+    const size_t  total   = sizeof( ch ) + m_cols * rows * sizeof( double );
+    const ssize_t written = writev( m_fd, iov, static_cast< int >( 1 + m_cols ) );
+    if ( written != static_cast< ssize_t >( total ) )
+    {
+        // 截掉已写入的部分，不留下不完整的数据块，截断也失败时不再追加（下次打开时截掉）
+        if ( written > 0 && ftruncate( m_fd, m_size ) != 0 )
+        {
+            close( m_fd );
+            m_fd = -1;
+        }
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+    }
+
+    // 索引写入失败时不再写入索引，之后的数据块在读取时沿块头扫描
+    const FmRecordIndexEntry entry = { m_size, ch.rows, 0, ch.first_time, ch.last_time };
+    if ( m_index_fd >= 0 && write( m_index_fd, &entry, sizeof( entry ) ) != sizeof( entry ) )
+    {
+        close( m_index_fd );
+        m_index_fd = -1;
+    }
+    m_size += total;
+}
+
+void CFmRecordWriter::sync()
+{
+    if ( m_fd >= 0 && fdatasync( m_fd ) != 0 )
+        throw FileException( FileException::WRITE_FAILED, m_file_path.c_str() );
+}
+
+CFmRecordReader::CFmRecordReader( const std::string& file_path ) : m_file_path( file_path ), m_data( nullptr ), m_size( 0 )
+{
+    int fd = ::open( file_path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        throw FileException( FileException::OPEN_FAILED, file_path.c_str() );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        throw FileException( FileException::READ_FAILED, file_path.c_str() );
+    }
+
+    m_size = static_cast< size_t >( st.st_size );
+    if ( m_size > 0 )
+    {
+        void* addr = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( addr == MAP_FAILED )
+        {
+            close( fd );
+            throw FileException( FileException::READ_FAILED, file_path.c_str() );
+        }
+        // 按时间范围读取时只访问部分数据块，由read_rows预读实际读取的范围
+        madvise( addr, m_size, MADV_RANDOM );
+        m_data = static_cast< const char* >( addr );
+    }
+    close( fd );
+
+    FmRecordFileHeader fh;
+    if ( ! parse_file_header( m_data, m_size, fh, m_header ) )
+    {
+        if ( m_data )
+            munmap( const_cast< char* >( m_data ), m_size );
+        throw FileException( FileException::READ_FAILED, file_path.c_str() );
+    }
+
+    // 块索引：先取索引文件中的块，不访问记录文件的数据页；索引之后的块(写入索引前中断)沿块头扫描
+    size_t offset = load_index( file_path + kRecordIndexSuffix, fh.header_size );
+    while ( offset + sizeof( FmRecordChunkHeader ) <= m_size )
+    {
+        FmRecordChunkHeader ch;
+        memcpy( &ch, m_data + offset, sizeof( ch ) );
+        const size_t size = chunk_size( ch, m_header.size(), m_size - offset );
+        if ( size == 0 )
+            break;
+
+        m_chunks.push_back( { offset, m_rows, ch.rows, ch.first_time, ch.last_time } );
+        m_rows += ch.rows;
+        offset += size;
+    }
+}
+
+size_t CFmRecordReader::load_index( const std::string& index_path, size_t header_size )
+{
+    int fd = ::open( index_path.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return header_size;
+
+    struct stat                       st;
+    FmRecordIndexHeader               ih;
+    std::vector< FmRecordIndexEntry > entries;
+    bool                              valid = fstat( fd, &st ) == 0 && pread( fd, &ih, sizeof( ih ), 0 ) == sizeof( ih ) && memcmp( ih.magic, kIndexMagic, sizeof( kIndexMagic ) ) == 0 && ih.version == kVersion;
+    if ( valid )
+    {
+        entries.resize( ( static_cast< size_t >( st.st_size ) - sizeof( ih ) ) / sizeof( FmRecordIndexEntry ) );
+        const size_t bytes = entries.size() * sizeof( FmRecordIndexEntry );
+        valid              = bytes == 0 || pread( fd, entries.data(), bytes, sizeof( ih ) ) == static_cast< ssize_t >( bytes );
+    }
+    close( fd );
+    if ( ! valid || entries.empty() )
+        return header_size;
+
+    // 各块须首尾相接且在文件范围内，只校验最后一块的块头，索引与记录文件不一致时改为扫描全部块头
+    const size_t cols   = m_header.size();
+    size_t       offset = header_size;
+    for ( const auto& entry : entries )
+    {
+        const size_t size = sizeof( FmRecordChunkHeader ) + static_cast< size_t >( entry.rows ) * cols * sizeof( double );
+        if ( entry.offset != offset || entry.rows == 0 || offset + size > m_size )
+            break;
+
+        m_chunks.push_back( { offset, m_rows, entry.rows, entry.first_time, entry.last_time } );
+        m_rows += entry.rows;
+        offset += size;
+    }
+
+    FmRecordChunkHeader ch = {};
+    if ( ! m_chunks.empty() )
+        memcpy( &ch, m_data + m_chunks.back().offset, sizeof( ch ) );
+    if ( m_chunks.size() != entries.size() || ch.magic != kChunkMagic || ch.rows != m_chunks.back().rows )
+    {
+        m_chunks.clear();
+        m_rows = 0;
+        return header_size;
+    }
+    return offset;
+}
+
+CFmRecordReader::~CFmRecordReader()
+{
+    if ( m_data )
+        munmap( const_cast< char* >( m_data ), m_size );
+}
+
+// 包含第row行的数据块
+static std::vector< FmRecordChunk >::const_iterator chunk_of_row( const std::vector< FmRecordChunk >& chunks, size_t row )
+{
+    auto it = std::upper_bound( chunks.begin(), chunks.end(), row, []( size_t r, const FmRecordChunk& chunk ) { return r < chunk.row; } );
+    return it == chunks.begin() ? chunks.end() : it - 1;
+}
+
+size_t CFmRecordReader::read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const
+{
+    if ( start_col < 0 || count <= 0 || first_row >= m_rows || max_rows == 0 )
+        return 0;
+
+    // 预读涉及的数据块
+    const size_t last_row = std::min( m_rows, first_row + max_rows ) - 1;
+    auto         first    = chunk_of_row( m_chunks, first_row );
+    auto         last     = chunk_of_row( m_chunks, last_row );
+    const size_t page     = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+    const size_t begin    = first->offset / page * page;
+    const size_t end      = last->offset + sizeof( FmRecordChunkHeader ) + last->rows * m_header.size() * sizeof( double );
+    madvise( const_cast< char* >( m_data ) + begin, end - begin, MADV_WILLNEED );
+
+    const size_t cols = m_header.size();
+    size_t       row  = 0;
+    for ( auto it = first; it != m_chunks.end() && row < max_rows; ++it )
+    {
+        const size_t skip = first_row + row - it->row;
+        const size_t n    = std::min( it->rows - skip, max_rows - row );
+        const char*  body = m_data + it->offset + sizeof( FmRecordChunkHeader );
+        for ( int k = 0; k < count; ++k )
+        {
+            const size_t col = static_cast< size_t >( start_col + k );
+            if ( col < cols )
+                memcpy( columns[ k ] + row, body + ( col * it->rows + skip ) * sizeof( double ), n * sizeof( double ) );
+            else
+                std::fill( columns[ k ] + row, columns[ k ] + row + n, std::numeric_limits< double >::quiet_NaN() );
+        }
+        row += n;
+    }
+
+    return row;
+}
+
+size_t CFmRecordReader::lower_bound_row( double time ) const
+{
+    // 按块的末行时间找到首个可能包含该时间的块，再在块的时间列中二分查找，只访问一个块
+    auto it = std::lower_bound( m_chunks.begin(), m_chunks.end(), time, []( const FmRecordChunk& chunk, double t ) { return chunk.last_time < t; } );
+    if ( it == m_chunks.end() )
+        return m_rows;
+
+    const double* column = reinterpret_cast< const double* >( m_data + it->offset + sizeof( FmRecordChunkHeader ) );
+    return it->row + static_cast< size_t >( std::lower_bound( column, column + it->rows, time ) - column );
+}
+
+void CFmRecordReader::find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const
+{
+    first_row             = lower_bound_row( start_time );
+    const size_t last_row = lower_bound_row( end_time );
+    num_rows              = last_row > first_row ? last_row - first_row : 0;
+}
+
+// 列名与fm_pdr_save_pdr_data写入的CSV一致，转换为CSV时作为列头
+const std::vector< std::string > kAccelerometerHeader = { "Time (s)", "X (m/s^2)", "Y (m/s^2)", "Z (m/s^2)" };
+const std::vector< std::string > kGyroscopeHeader     = { "Time (s)", "X (rad/s)", "Y (rad/s)", "Z (rad/s)" };
+const std::vector< std::string > kMagnetometerHeader  = { "Time (s)", "X (µT)", "Y (µT)", "Z (µT)" };
+const std::vector< std::string > kLocationHeader      = { "Time (s)", "Latitude (°)", "Longitude (°)", "Height (m)", "Velocity (m/s)", "Direction (°)", "Horizontal Accuracy (m)", "Vertical Accuracy (°)" };
+
+CFmSensorRecorder::CFmSensorRecorder( const std::string& dir_path ) : m_dir_path( dir_path ) {}
+
+// 各列指针均有效时追加，记录文件在首次追加时打开
+static void append_record( std::unique_ptr< CFmRecordWriter >& writer, const std::string& path, const std::vector< std::string >& header, const double* const* columns, unsigned long length )
+{
+    if ( length == 0 )
+        return;
+    for ( size_t k = 0; k < header.size(); ++k )
+    {
+        if ( ! columns[ k ] )
+            return;
+    }
+
+    if ( ! writer )
+        writer = std::make_unique< CFmRecordWriter >( path, header );
+    writer->append( columns, length );
+}
+
+void CFmSensorRecorder::append( const PDRData& pdr_data )
+{
+    const PDRSensorData& s = pdr_data.sensor_data;
+    const PDRTrueData&   t = pdr_data.true_data;
+
+    const double* const acc[ 4 ] = { s.acc_time, s.acc_x, s.acc_y, s.acc_z };
+    const double* const gyr[ 4 ] = { s.gyr_time, s.gyr_x, s.gyr_y, s.gyr_z };
+    const double* const mag[ 4 ] = { s.mag_time, s.mag_x, s.mag_y, s.mag_z };
+    const double* const gps[ 8 ] = { t.time_location, t.latitude, t.longitude, t.height, t.velocity, t.direction, t.horizontal_accuracy, t.vertical_accuracy };
+
+    append_record( m_accelerometer, m_dir_path + "/Accelerometer" + kRecordExtension, kAccelerometerHeader, acc, s.length );
+    append_record( m_gyroscope, m_dir_path + "/Gyroscope" + kRecordExtension, kGyroscopeHeader, gyr, s.length );
+    append_record( m_magnetometer, m_dir_path + "/Magnetometer" + kRecordExtension, kMagnetometerHeader, mag, s.length );
+    append_record( m_location, m_dir_path + "/Location" + kRecordExtension, kLocationHeader, gps, t.length );
+}
\ No newline at end of file
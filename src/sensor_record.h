@@ -0,0 +1,107 @@
+#pragma once
+#include "fm_pdr.h"
+#include "table_reader.h"
+#include "table_writer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 二进制记录文件的扩展名，与同名CSV文件一一对应（如Accelerometer.fmr对应Accelerometer.csv）
+constexpr const char* kRecordExtension = ".fmr";
+// 记录文件的块索引文件后缀（如Accelerometer.fmr.idx）
+constexpr const char* kRecordIndexSuffix = ".idx";
+
+// 二进制记录格式（只追加，按本机字节序）：
+//   文件头：8字节魔数"FMPDRREC"、版本、列数、文件头总长度(含列名，8字节对齐)，之后为以'\0'结尾的各列列名；
+//   数据块：块头(魔数、行数、首行与末行时间)，之后按列存储 列数 × 行数 个double，一次追加写入一个数据块。
+// 第0列为时间，块头的时间范围可用于不读数据而按时间定位；文件末尾不完整的数据块(写入中断)在读取时忽略，追加时截掉。
+// 写入时同时追加稀疏的块索引文件(每块一项：偏移、行数、时间范围)，读取时只需读索引文件即可按时间二分定位到块
+struct FmRecordChunk
+{
+    size_t offset;      // 数据块(含块头)在文件中的偏移
+    size_t row;         // 首行的行号
+    size_t rows;        // 行数
+    double first_time;  // 首行时间
+    double last_time;   // 末行时间
+};
+
+// 二进制记录写入：每次append写入一个数据块，块头与各列数据由一次writev直接从调用者的数组写出，不做格式化
+class CFmRecordWriter : public CFmTableWriter
+{
+public:
+    // 文件不存在时创建并写入文件头，已存在时校验列数后追加
+    CFmRecordWriter( const std::string& file_path, const std::vector< std::string >& header );
+    ~CFmRecordWriter() override;
+
+    CFmRecordWriter( const CFmRecordWriter& )            = delete;
+    CFmRecordWriter& operator=( const CFmRecordWriter& ) = delete;
+
+    void append( const double* const* columns, size_t rows ) override;
+    void sync() override;
+
+    inline size_t cols() const override
+    {
+        return m_cols;
+    }
+private:
+    std::string m_file_path;
+    int         m_fd;
+    int         m_index_fd;  // 块索引，-1表示不写索引
+    size_t      m_cols;
+    size_t      m_size;  // 已写入的有效长度，写入失败时截回该长度
+};
+
+// 二进制记录读取：文件整体mmap映射，按块索引定位后只访问涉及的数据块，读取时按块memcpy各列，
+// 会话再长常驻内存也只与读取的时间范围有关
+class CFmRecordReader : public CFmTableReader
+{
+public:
+    explicit CFmRecordReader( const std::string& file_path );
+    ~CFmRecordReader();
+
+    CFmRecordReader( const CFmRecordReader& )            = delete;
+    CFmRecordReader& operator=( const CFmRecordReader& ) = delete;
+
+    // 超出文件列数的列为NaN
+    size_t read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const override;
+    // 按块索引二分查找，O(log n)且只访问边界上的两个数据块
+    void find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const override;
+
+    inline const std::vector< FmRecordChunk >& chunks() const
+    {
+        return m_chunks;
+    }
+private:
+    // 读取索引文件，返回索引之后第一个块的偏移，索引不存在或与记录文件不一致时返回header_size
+    size_t load_index( const std::string& index_path, size_t header_size );
+    // 时间不小于time的首行
+    size_t lower_bound_row( double time ) const;
+
+    std::string                  m_file_path;
+    const char*                  m_data;  // 映射的文件内容
+    size_t                       m_size;
+    std::vector< FmRecordChunk > m_chunks;
+};
+
+// 各传感器数据表的列名，与采集保存的CSV文件一致
+extern const std::vector< std::string > kAccelerometerHeader;
+extern const std::vector< std::string > kGyroscopeHeader;
+extern const std::vector< std::string > kMagnetometerHeader;
+extern const std::vector< std::string > kLocationHeader;
+
+// 按PDRData追加写入dir_path目录下各传感器的二进制记录，记录文件在首次写入时打开并保持打开，
+// 实时模式下每个窗口只有各传感器一次writev
+class CFmSensorRecorder
+{
+public:
+    explicit CFmSensorRecorder( const std::string& dir_path );
+
+    void append( const PDRData& pdr_data );
+private:
+    std::string                        m_dir_path;
+    std::unique_ptr< CFmRecordWriter > m_accelerometer;
+    std::unique_ptr< CFmRecordWriter > m_gyroscope;
+    std::unique_ptr< CFmRecordWriter > m_magnetometer;
+    std::unique_ptr< CFmRecordWriter > m_location;
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "sensor_ring.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+CFmSensorRing::CFmSensorRing( int slots ) : m_buffer( nullptr ), m_window_length( 0 ), m_window_stride( 0 ), m_slots( slots ), m_next_slot( 0 )
+{
+    if ( slots <= 0 )
+        throw std::invalid_argument( "Sensor ring slots must be greater than 0" );
+}
+
+CFmSensorRing::~CFmSensorRing()
+{
+    std::free( m_buffer );
+}
+
+void CFmSensorRing::reserve( unsigned long window_length )
+{
+    if ( window_length <= m_window_length )
+        return;
+
+    // 每个窗口的起始地址按缓存行对齐，列与列、窗口与窗口之间不共享缓存行
+    constexpr unsigned long kDoublesPerLine = kAlignment / sizeof( double );
+    const unsigned long     window_stride   = ( window_length + kDoublesPerLine - 1 ) / kDoublesPerLine * kDoublesPerLine;
+    const size_t            bytes           = sizeof( double ) * window_stride * m_slots * kColumns;
+
+    double* buffer = static_cast< double* >( std::aligned_alloc( kAlignment, bytes ) );
+    if ( ! buffer )
+        throw std::bad_alloc();
+
+    // 设备不提供的列（如线性加速度计）保持为0
+    memset( buffer, 0x00, bytes );
+
+    std::free( m_buffer );
+    m_buffer        = buffer;
+    m_window_length = window_length;
+    m_window_stride = window_stride;
+    m_next_slot     = 0;
+}
+
+PDRSensorData CFmSensorRing::next_window( unsigned long length )
+{
+    // 窗口长度增大时重新分配，此前返回的视图全部失效
+    reserve( length );
+
+    const int slot = m_next_slot;
+    m_next_slot    = ( m_next_slot + 1 ) % m_slots;
+
+    PDRSensorData data;
+    memset( &data, 0x00, sizeof( data ) );
+    double** fields[ kColumns ] = { &data.acc_time, &data.acc_x, &data.acc_y, &data.acc_z, &data.lacc_time, &data.lacc_x, &data.lacc_y, &data.lacc_z,
+                                    &data.gyr_time, &data.gyr_x, &data.gyr_y, &data.gyr_z, &data.mag_time, &data.mag_x, &data.mag_y, &data.mag_z };
+    for ( int k = 0; k < kColumns; ++k )
+        *fields[ k ] = m_buffer + ( static_cast< unsigned long >( k ) * m_slots + slot ) * m_window_stride;
+
+    return data;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include "fm_pdr.h"
+#include <cstddef>
+
+// 传感器采集环形缓存：结构体数组(SoA)布局，每列的每个窗口均按缓存行对齐，采样点直接写入缓存，
+// 读取方得到指向缓存内部的PDRSensorData视图。缓存按窗口轮转使用，窗口长度不增大时不再分配内存，
+// 返回的视图在其窗口被再次轮转到之前（即之后slots-1次取窗口期间）保持有效
+class CFmSensorRing
+{
+public:
+    static constexpr int    kColumns   = 16;  // 与PDRSensorData中的数组字段一一对应
+    static constexpr size_t kAlignment = 64;  // 缓存行大小（单位：字节）
+
+    CFmSensorRing( int slots );
+    ~CFmSensorRing();
+
+    CFmSensorRing( const CFmSensorRing& )            = delete;
+    CFmSensorRing& operator=( const CFmSensorRing& ) = delete;
+
+    // 预分配每个窗口window_length个采样点的缓存，容量足够时不重新分配
+    void reserve( unsigned long window_length );
+    // 取得下一个窗口，返回的各列指针指向缓存内部，长度为0，由写入方在写入后设置
+    PDRSensorData next_window( unsigned long length );
+
+    inline unsigned long get_window_capacity() const
+    {
+        return m_window_length;
+    }
+
+    inline int get_slots() const
+    {
+        return m_slots;
+    }
+private:
+    double*       m_buffer;         // 所有列共用一块对齐内存
+    unsigned long m_window_length;  // 每个窗口可容纳的采样点数
+    unsigned long m_window_stride;  // 相邻窗口的间隔，按缓存行取整（单位：采样点）
+    int           m_slots;          // 窗口数
+    int           m_next_slot;      // 下一个写入的窗口
+};
\ No newline at end of file
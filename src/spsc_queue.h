@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// 有界单生产者/单消费者无锁队列：容量取2的幂，入队、出队均为无等待操作（不加锁、不自旋），
+// 只允许一个线程调用try_push、另一个线程调用try_pop。读写位置分别位于独立的缓存行，避免伪共享
+template < typename T >
+class CFmSpscQueue
+{
+public:
+    explicit CFmSpscQueue( size_t capacity ) : m_head( 0 ), m_tail( 0 )
+    {
+        if ( capacity == 0 )
+            throw std::invalid_argument( "SPSC queue capacity must be greater than 0" );
+
+        size_t size = 1;
+        while ( size < capacity )
+            size <<= 1;
+        m_buffer.resize( size );
+        m_mask = size - 1;
+    }
+
+    CFmSpscQueue( const CFmSpscQueue& )            = delete;
+    CFmSpscQueue& operator=( const CFmSpscQueue& ) = delete;
+
+    // 生产者调用，队列已满时返回false，不覆盖未被取走的数据
+    bool try_push( const T& value )
+    {
+        const size_t tail = m_tail.load( std::memory_order_relaxed );
+        if ( tail - m_head.load( std::memory_order_acquire ) > m_mask )
+            return false;
+
+        m_buffer[ tail & m_mask ] = value;
+        m_tail.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    // 消费者调用，队列为空时返回false
+    bool try_pop( T& value )
+    {
+        const size_t head = m_head.load( std::memory_order_relaxed );
+        if ( head == m_tail.load( std::memory_order_acquire ) )
+            return false;
+
+        value = m_buffer[ head & m_mask ];
+        m_head.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    // 当前元素个数，在生产者或消费者线程中调用时为近似值
+    size_t size() const
+    {
+        return m_tail.load( std::memory_order_acquire ) - m_head.load( std::memory_order_acquire );
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+private:
+    std::vector< T > m_buffer;
+    size_t           m_mask;
+
+    alignas( 64 ) std::atomic< size_t > m_head;  // 消费者读取位置
+    alignas( 64 ) std::atomic< size_t > m_tail;  // 生产者写入位置
+};
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "step_detector.h"
+#include <cmath>
+#include <stdexcept>
+
+CFmStepDetector::CFmStepDetector( const PDRConfig& config ) : m_config( config ), m_valid_peak_value( 0.0 )
+{
+    if ( config.move_average <= 0 || config.min_distance <= 0 )
+        throw std::invalid_argument( "move_average and min_distance must be greater than 0" );
+
+    m_range     = config.move_average;
+    m_lookahead = m_range - 1 - ( m_range - 1 ) / 2;
+    m_weight    = 1.0 / static_cast< double >( m_range );
+
+    // 环形缓存需要覆盖：滑动平均延迟 + 候选峰最长等待距离
+    m_ring_size = m_range + config.min_distance + 8;
+
+    reset( 0.0 );
+}
+
+CFmStepDetector::~CFmStepDetector() {}
+
+void CFmStepDetector::reset( double valid_peak_value )
+{
+    m_valid_peak_value = valid_peak_value;
+
+    m_ma_window.assign( m_range, 0.0 );
+    m_ma_pos = 0;
+    m_ma_sum = 0.0;
+
+    m_ring_time.assign( m_ring_size, 0.0 );
+    m_ring_direction.assign( m_ring_size, 0.0 );
+    m_ring_filtered.assign( m_ring_size, 0.0 );
+
+    m_sample_count   = 0;
+    m_ma_count       = 0;
+    m_filtered_count = 0;
+    m_have_candidate = false;
+    m_candidate_idx  = 0;
+
+    m_commit_idx         = 0;
+    m_have_anchor        = false;
+    m_anchor_time        = 0.0;
+    m_feature_base       = 0.0;
+    m_feature_sum        = 0.0;
+    m_feature_square_sum = 0.0;
+    m_direction_cos_sum  = 0.0;
+    m_direction_sin_sum  = 0.0;
+    m_segment_count      = 0;
+
+    m_have_pending_step = false;
+    m_pending_time      = 0.0;
+}
+
+void CFmStepDetector::push( double time, double accel_magnitude, double direction )
+{
+    const size_t slot        = m_sample_count % m_ring_size;
+    m_ring_time[ slot ]      = time;
+    m_ring_direction[ slot ] = direction;
+    ++m_sample_count;
+
+    push_moving_average( accel_magnitude );
+}
+
+void CFmStepDetector::finish()
+{
+    if ( m_sample_count > 0 )
+    {
+        // 末端零填充，得到剩余点的滑动平均值
+        for ( int i = 0; i < m_lookahead; ++i )
+            push_moving_average( 0.0 );
+
+        // 数据结束，候选峰不会再被替换
+        if ( m_have_candidate )
+            finalize_candidate();
+        commit_until( m_filtered_count );
+
+        // 最后一步的方向取到数据末尾的平均值
+        if ( m_have_pending_step )
+            emit_pending_step();
+    }
+
+    std::vector< DetectedStep > steps;
+    steps.swap( m_steps );
+    reset( m_valid_peak_value );
+    m_steps.swap( steps );
+}
+
+std::vector< DetectedStep > CFmStepDetector::take_steps()
+{
+    std::vector< DetectedStep > steps;
+    steps.swap( m_steps );
+    return steps;
+}
+
+void CFmStepDetector::push_moving_average( double value )
+{
+    const double out        = m_ma_window[ m_ma_pos ];
+    m_ma_window[ m_ma_pos ] = value;
+    m_ma_pos                = ( m_ma_pos + 1 ) % m_range;
+
+    // 窗口和逐点加入新点、移出旧点，每点O(1)
+    m_ma_sum += value * m_weight;
+    m_ma_sum -= out * m_weight;
+
+    // 窗口覆盖[j - pad, j + lookahead]时得到第j点的滑动平均
+    if ( ++m_ma_count <= m_lookahead )
+        return;
+
+    // 每range个点从最旧的点开始按卷积顺序重新求和，均摊仍为O(1)：误差不累积，重新求和的点与
+    // CFmStepPredictor::detect_peaks逐位一致，其余点只有舍入级的差别
+    const Eigen::Index j = m_ma_count - 1 - m_lookahead;
+    if ( j % m_range == 0 )
+    {
+        m_ma_sum = 0.0;
+        for ( int k = 0; k < m_range; ++k )
+            m_ma_sum += m_ma_window[ ( m_ma_pos + k ) % m_range ] * m_weight;
+    }
+
+    push_filtered( m_ma_sum );
+}
+
+void CFmStepDetector::push_filtered( double value )
+{
+    const Eigen::Index j               = m_filtered_count++;
+    m_ring_filtered[ j % m_ring_size ] = value;
+
+    // 第j点到达后才能判断j-1点是否为局部极大值
+    if ( j >= 2 )
+    {
+        const Eigen::Index i    = j - 1;
+        const double       f_i  = m_ring_filtered[ i % m_ring_size ];
+        const bool         peak = f_i > m_ring_filtered[ ( i - 1 ) % m_ring_size ] && f_i > value;
+
+        if ( peak )
+        {
+            if ( m_have_candidate && i - m_candidate_idx < m_config.min_distance )
+            {
+                // 大于原来波峰，则替换旧峰；否则丢弃当前峰
+                if ( f_i > m_ring_filtered[ m_candidate_idx % m_ring_size ] )
+                    m_candidate_idx = i;
+            }
+            else
+            {
+                if ( m_have_candidate )
+                    finalize_candidate();
+                m_have_candidate = true;
+                m_candidate_idx  = i;
+            }
+        }
+    }
+
+    // 之后的局部极大值不可能落在min_distance范围内时，候选峰即可确定
+    if ( m_have_candidate && j - m_candidate_idx >= m_config.min_distance )
+        finalize_candidate();
+
+    // 候选峰之前（或当前点之前）的数据不会再变化，可以累加
+    commit_until( m_have_candidate ? m_candidate_idx : j );
+}
+
+void CFmStepDetector::finalize_candidate()
+{
+    const Eigen::Index idx = m_candidate_idx;
+    m_have_candidate       = false;
+
+    commit_until( idx );
+    commit( idx, m_ring_filtered[ idx % m_ring_size ] > m_valid_peak_value );
+    m_commit_idx = idx + 1;
+}
+
+void CFmStepDetector::commit_until( Eigen::Index end )
+{
+    while ( m_commit_idx < end )
+    {
+        commit( m_commit_idx, false );
+        ++m_commit_idx;
+    }
+}
+
+void CFmStepDetector::commit( Eigen::Index idx, bool is_peak )
+{
+    const size_t slot      = idx % m_ring_size;
+    const double filtered  = m_ring_filtered[ slot ];
+    const double direction = m_ring_direction[ slot ] * M_PI / 180.0;
+    const double time      = m_ring_time[ slot ];
+
+    // 段的首尾均包含有效峰本身
+    if ( m_have_anchor )
+    {
+        const double d = filtered - m_feature_base;
+        m_feature_sum += d;
+        m_feature_square_sum += d * d;
+        m_direction_cos_sum += std::cos( direction );
+        m_direction_sin_sum += std::sin( direction );
+        ++m_segment_count;
+    }
+
+    if ( ! is_peak )
+        return;
+
+    // 上一步的方向段到此结束
+    if ( m_have_pending_step )
+        emit_pending_step();
+
+    // 由上一有效峰到当前峰的特征：步频f与滤波后加速度的方差sigma
+    if ( m_have_anchor )
+    {
+        const double mean       = m_feature_sum / m_segment_count;
+        m_pending_features( 0 ) = 1.0 / ( time - m_anchor_time );
+        m_pending_features( 1 ) = m_feature_square_sum / m_segment_count - mean * mean;
+        m_pending_time          = time;
+        m_have_pending_step     = true;
+    }
+
+    // 以当前峰开始新的段
+    m_have_anchor        = true;
+    m_anchor_time        = time;
+    m_feature_base       = filtered;
+    m_feature_sum        = 0.0;
+    m_feature_square_sum = 0.0;
+    m_direction_cos_sum  = std::cos( direction );
+    m_direction_sin_sum  = std::sin( direction );
+    m_segment_count      = 1;
+}
+
+void CFmStepDetector::emit_pending_step()
+{
+    DetectedStep step;
+    step.time      = m_pending_time;
+    step.features  = m_pending_features;
+    step.direction = std::atan2( m_direction_sin_sum, m_direction_cos_sum ) * 180.0 / M_PI;
+    if ( step.direction < 0 )
+        step.direction += 360.0;
+    if ( step.direction >= 360.0 )
+        step.direction -= 360.0;
+    m_steps.push_back( step );
+
+    m_have_pending_step = false;
+}
\ No newline at end of file
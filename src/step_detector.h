@@ -0,0 +1,81 @@
+#pragma once
+#include "fm_pdr.h"
+#include "step_predictor.h"
+#include <vector>
+
+// 检测到的一步：时间为该步结束时的有效峰时间，方向为该峰到下一有效峰（或数据末尾）的圆周平均方向
+typedef struct _DetectedStep
+{
+    double        time;       ///< 有效峰时间
+    FeatureMatrix features;   ///< 步长特征(f, sigma)
+    double        direction;  ///< 圆周平均方向，范围[0, 360)
+} DetectedStep;
+
+// 逐点步态检测：滑动平均、峰值检测、min_distance替换规则、有效峰值筛选以及特征与方向的累加状态在调用之间保持，
+// 数据可以按任意长度分段送入，分段结果与整段数据一次处理的结果一致，不会丢步或重复计步
+class CFmStepDetector
+{
+public:
+    CFmStepDetector( const PDRConfig& config );
+    ~CFmStepDetector();
+
+    // 清除所有状态，开始新的推算
+    void reset( double valid_peak_value );
+    // 送入一个采样点：时间、加速度模长、行进方向
+    void push( double time, double accel_magnitude, double direction );
+    // 数据结束：输出缓存中剩余的最后一步，之后恢复初始状态
+    void finish();
+
+    // 取出已检测到的步
+    std::vector< DetectedStep > take_steps();
+private:
+    const PDRConfig& m_config;
+    double           m_valid_peak_value;
+
+    // 加速度模长滑动平均（与CFmStepPredictor::detect_peaks一致的居中窗口与零填充，窗口和逐点更新）
+    int                   m_range;      // 窗口长度
+    int                   m_lookahead;  // 窗口中心之后的点数
+    double                m_weight;     // 平均滤波器系数
+    std::vector< double > m_ma_window;
+    size_t                m_ma_pos;
+    double                m_ma_sum;
+
+    // 按采样序号取模的环形缓存
+    size_t                m_ring_size;
+    std::vector< double > m_ring_time;
+    std::vector< double > m_ring_direction;
+    std::vector< double > m_ring_filtered;
+
+    Eigen::Index m_sample_count;    // 已送入的采样点数
+    Eigen::Index m_ma_count;        // 已送入滑动平均的点数（含结束时的零填充）
+    Eigen::Index m_filtered_count;  // 已得到滑动平均值的点数
+
+    // 峰值检测，候选峰在min_distance范围内可能被更高的峰替换
+    bool         m_have_candidate;
+    Eigen::Index m_candidate_idx;
+
+    // 已确认的数据按序累加到当前步的特征段与方向段
+    Eigen::Index m_commit_idx;
+    bool         m_have_anchor;   // 是否已有上一有效峰
+    double       m_anchor_time;   // 上一有效峰时间
+    double       m_feature_base;  // 特征段平移量，避免方差计算的数值抵消
+    double       m_feature_sum;
+    double       m_feature_square_sum;
+    double       m_direction_cos_sum;  // 方向段单位向量之和，平均方向取atan2，跨越0/360度时不会平均到反方向
+    double       m_direction_sin_sum;
+    Eigen::Index m_segment_count;
+
+    // 等待下一有效峰确定平均方向的步
+    bool          m_have_pending_step;
+    double        m_pending_time;
+    FeatureMatrix m_pending_features;
+
+    std::vector< DetectedStep > m_steps;
+
+    void push_moving_average( double value );
+    void push_filtered( double value );
+    void finalize_candidate();
+    void commit_until( Eigen::Index end );
+    void commit( Eigen::Index idx, bool is_peak );
+    void emit_pending_step();
+};
\ No newline at end of file
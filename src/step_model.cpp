@@ -0,0 +1,522 @@
+#include "step_model.h"
+#include <algorithm>
+#include <dlib/serialize.h>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+constexpr int      kNeighbors     = 5;    // k近邻的k，与scikit-learn的KNeighborsRegressor默认值相同
+constexpr int      kTreeMaxDepth  = 8;    // 决策树与随机森林的最大深度，限制每步的比较次数
+constexpr int      kForestTrees   = 20;   // 随机森林的树数
+constexpr int      kBoostingTrees = 100;  // 梯度提升的树数、深度与学习率，与scikit-learn的默认值相同
+constexpr int      kBoostingDepth = 3;
+constexpr double   kBoostingRate  = 0.1;
+constexpr unsigned kRandomSeed    = 42;   // 随机森林自助采样的种子，同一训练数据得到同一模型
+
+std::vector< FeatureMatrix > to_samples( const StepFeatures& x )
+{
+    std::vector< FeatureMatrix > samples( x.rows() );
+    for ( Eigen::Index i = 0; i < x.rows(); ++i )
+    {
+        samples[ i ]( 0 ) = x( i, 0 );
+        samples[ i ]( 1 ) = x( i, 1 );
+    }
+    return samples;
+}
+
+void check_training_set( const StepFeatures& x, const Eigen::VectorXd& y )
+{
+    if ( x.rows() == 0 || x.rows() != y.size() )
+        throw std::runtime_error( "Step model training set is empty or its features and labels differ in size" );
+}
+
+// 模型名的最大长度，用于判断文件开头是否为模型名
+constexpr unsigned long kMaxTagLength = 32;
+
+// 读取模型文件开头的模型名；原格式的线性模型与平均步长文件没有模型名，此时恢复读取位置并返回空字符串
+std::string read_model_tag( std::istream& in )
+{
+    static const char* const kNames[] = { "Mean", "Linear", "SVR", "DecisionTree", "RandomForest", "GradientBoosting", "KNeighbors" };
+
+    const std::streampos start = in.tellg();
+    unsigned long        size  = 0;
+    std::string          tag;
+    try
+    {
+        // 先读取长度，避免把原格式文件的数据当作很长的字符串读取
+        dlib::deserialize( size, in );
+        if ( size > 0 && size <= kMaxTagLength )
+        {
+            tag.resize( size );
+            in.read( &tag[ 0 ], size );
+        }
+    }
+    catch ( const dlib::serialization_error& )
+    {
+        tag.clear();
+    }
+
+    if ( in && std::find( std::begin( kNames ), std::end( kNames ), tag ) != std::end( kNames ) )
+        return tag;
+
+    in.clear();
+    in.seekg( start );
+    return std::string();
+}
+
+// 除"Linear"外的模型文件以模型名开头，加载时与配置的model_name核对(原格式的"Mean"文件在CFmMeanStepModel中处理)
+void check_model_tag( std::istream& in, const char* name )
+{
+    const std::string tag = read_model_tag( in );
+    if ( tag.empty() )
+        throw std::runtime_error( "Step model file does not contain a \"" + std::string( name ) + "\" model" );
+    if ( tag != name )
+        throw std::runtime_error( "Step model file contains a \"" + tag + "\" model, expected \"" + name + "\"" );
+}
+}  // namespace
+
+std::unique_ptr< CFmStepModel > CFmStepModel::create( const std::string& name )
+{
+    if ( name == "Mean" )
+        return std::make_unique< CFmMeanStepModel >();
+    if ( name == "Linear" )
+        return std::make_unique< CFmLinearStepModel >( false );
+    if ( name == "SVR" )
+        return std::make_unique< CFmLinearStepModel >( true );
+    if ( name == "DecisionTree" )
+        return std::make_unique< CFmTreeStepModel >( CFmTreeStepModel::DECISION_TREE );
+    if ( name == "RandomForest" )
+        return std::make_unique< CFmTreeStepModel >( CFmTreeStepModel::RANDOM_FOREST );
+    if ( name == "GradientBoosting" )
+        return std::make_unique< CFmTreeStepModel >( CFmTreeStepModel::GRADIENT_BOOSTING );
+    if ( name == "KNeighbors" )
+        return std::make_unique< CFmKNeighborsStepModel >();
+    throw std::runtime_error( "Unknown model: " + name );
+}
+
+const char* CFmMeanStepModel::name() const
+{
+    return "Mean";
+}
+
+void CFmMeanStepModel::train( const StepFeatures& /*x*/, const Eigen::VectorXd& /*y*/ )
+{
+    // 各段步长的平均值不等于总距离除以总步数，平均步长只能由CFmStepPredictor::step_process_mean计算
+    throw std::runtime_error( "Mean step model is computed from the total distance and step count, it cannot be trained from segment step lengths" );
+}
+
+Eigen::VectorXd CFmMeanStepModel::predict( const StepFeatures& x ) const
+{
+    return Eigen::VectorXd::Constant( x.rows(), m_step_length );
+}
+
+void CFmMeanStepModel::serialize( std::ostream& out ) const
+{
+    dlib::serialize( std::string( name() ), out );
+    dlib::serialize( m_step_length, out );
+}
+
+void CFmMeanStepModel::deserialize( std::istream& in )
+{
+    // 原格式的文件没有模型名，只有步长与有效峰值两个double
+    const std::string tag = read_model_tag( in );
+    if ( ! tag.empty() && tag != name() )
+        throw std::runtime_error( "Step model file contains a \"" + tag + "\" model, expected \"Mean\"" );
+
+    bool valid = true;
+    try
+    {
+        dlib::deserialize( m_step_length, in );
+
+        // 没有模型名时核对其后只剩有效峰值，原格式的线性模型文件不能作为"Mean"加载
+        if ( tag.empty() )
+        {
+            const std::streampos pos = in.tellg();
+            double               valid_peak_value;
+            dlib::deserialize( valid_peak_value, in );
+            valid = in.peek() == std::char_traits< char >::eof();
+            in.clear();
+            in.seekg( pos );
+        }
+    }
+    catch ( const dlib::serialization_error& )
+    {
+        valid = false;
+    }
+    if ( ! valid )
+        throw std::runtime_error( "Step model file does not contain a \"Mean\" model" );
+}
+
+CFmLinearStepModel::CFmLinearStepModel( bool svr ) : m_svr( svr ), m_weights( Eigen::Vector2d::Zero() ), m_weight_scale( 1.0 ), m_bias( 0.0 ) {}
+
+const char* CFmLinearStepModel::name() const
+{
+    return m_svr ? "SVR" : "Linear";
+}
+
+void CFmLinearStepModel::train( const StepFeatures& x, const Eigen::VectorXd& y )
+{
+    check_training_set( x, y );
+    std::vector< FeatureMatrix > samples = to_samples( x );
+    std::vector< double >        labels( y.data(), y.data() + y.size() );
+
+    if ( m_svr )
+    {
+        // 支持向量回归，参数与scikit-learn的SVR默认值相同(C=1，epsilon=0.1)
+        dlib::svr_trainer< dlib::linear_kernel< FeatureMatrix > > trainer;
+        trainer.set_c( 1.0 );
+        trainer.set_epsilon_insensitivity( 0.1 );
+        m_model = trainer.train( samples, labels );
+    }
+    else
+    {
+        // 线性回归
+        dlib::rr_trainer< dlib::linear_kernel< FeatureMatrix > > trainer;
+        trainer.set_lambda( 0 );
+        m_model = trainer.train( samples, labels );
+    }
+    unpack();
+}
+
+void CFmLinearStepModel::unpack()
+{
+    // 线性核的决策函数为 sum(alpha_i * (basis_i · x)) - b，多个基向量(SVR的支持向量)时合并为一个权重向量
+    const long basis_count = m_model.basis_vectors.size();
+    m_weights.setZero();
+    m_weight_scale = 1.0;
+    m_bias         = m_model.b;
+    if ( basis_count == 1 )
+    {
+        m_weights      = Eigen::Vector2d( m_model.basis_vectors( 0 )( 0 ), m_model.basis_vectors( 0 )( 1 ) );
+        m_weight_scale = m_model.alpha( 0 );
+    }
+    else
+    {
+        for ( long i = 0; i < basis_count; ++i )
+            m_weights += m_model.alpha( i ) * Eigen::Vector2d( m_model.basis_vectors( i )( 0 ), m_model.basis_vectors( i )( 1 ) );
+    }
+}
+
+Eigen::VectorXd CFmLinearStepModel::predict( const StepFeatures& x ) const
+{
+    Eigen::VectorXd lengths = x * m_weights;
+    return ( lengths.array() * m_weight_scale - m_bias ).matrix();
+}
+
+void CFmLinearStepModel::serialize( std::ostream& out ) const
+{
+    // "Linear"与原模型文件格式相同，只有dlib的决策函数；"SVR"的决策函数格式相同，以模型名开头加以区分
+    if ( m_svr )
+        dlib::serialize( std::string( name() ), out );
+    dlib::serialize( m_model, out );
+}
+
+void CFmLinearStepModel::deserialize( std::istream& in )
+{
+    // 没有模型名的文件只能作为"Linear"加载
+    if ( m_svr )
+        check_model_tag( in, name() );
+    else
+    {
+        const std::string tag = read_model_tag( in );
+        if ( ! tag.empty() )
+            throw std::runtime_error( "Step model file contains a \"" + tag + "\" model, expected \"Linear\"" );
+    }
+
+    try
+    {
+        dlib::deserialize( m_model, in );
+    }
+    catch ( const dlib::serialization_error& )
+    {
+        throw std::runtime_error( "Step model file does not contain a \"" + std::string( name() ) + "\" model" );
+    }
+    unpack();
+}
+
+CFmTreeStepModel::CFmTreeStepModel( Kind kind ) : m_kind( kind ), m_base( 0.0 ), m_scale( 1.0 ) {}
+
+const char* CFmTreeStepModel::name() const
+{
+    switch ( m_kind )
+    {
+        case RANDOM_FOREST:
+            return "RandomForest";
+        case GRADIENT_BOOSTING:
+            return "GradientBoosting";
+        default:
+            return "DecisionTree";
+    }
+}
+
+void CFmTreeStepModel::train( const StepFeatures& x, const Eigen::VectorXd& y )
+{
+    check_training_set( x, y );
+    m_roots.clear();
+    m_feature.clear();
+    m_threshold.clear();
+    m_left.clear();
+    m_right.clear();
+    m_value.clear();
+
+    const int          n = static_cast< int >( x.rows() );
+    std::vector< int > samples( n );
+    if ( m_kind == DECISION_TREE )
+    {
+        m_base  = 0.0;
+        m_scale = 1.0;
+        std::iota( samples.begin(), samples.end(), 0 );
+        grow_tree( x, y, samples, kTreeMaxDepth );
+    }
+    else if ( m_kind == RANDOM_FOREST )
+    {
+        // 每棵树使用有放回抽取的n个样本，输出取平均
+        std::mt19937                         random( kRandomSeed );
+        std::uniform_int_distribution< int > pick( 0, n - 1 );
+        m_base  = 0.0;
+        m_scale = 1.0 / kForestTrees;
+        for ( int t = 0; t < kForestTrees; ++t )
+        {
+            for ( int& s : samples )
+                s = pick( random );
+            grow_tree( x, y, samples, kTreeMaxDepth );
+        }
+    }
+    else
+    {
+        // 从均值开始，每棵树拟合当前残差，输出乘以学习率累加
+        m_base  = y.mean();
+        m_scale = kBoostingRate;
+        Eigen::VectorXd residual = y.array() - m_base;
+        for ( int t = 0; t < kBoostingTrees; ++t )
+        {
+            std::iota( samples.begin(), samples.end(), 0 );
+            const int root = grow_tree( x, residual, samples, kBoostingDepth );
+            for ( int i = 0; i < n; ++i )
+            {
+                int node = root;
+                while ( m_feature[ node ] >= 0 )
+                    node = ( x( i, m_feature[ node ] ) <= m_threshold[ node ] ) ? m_left[ node ] : m_right[ node ];
+                residual[ i ] -= m_scale * m_value[ node ];
+            }
+        }
+    }
+}
+
+int CFmTreeStepModel::grow_tree( const StepFeatures& x, const Eigen::VectorXd& y, std::vector< int >& samples, int max_depth )
+{
+    const int root = grow_node( x, y, samples.data(), static_cast< int >( samples.size() ), 0, max_depth );
+    m_roots.push_back( root );
+    return root;
+}
+
+int CFmTreeStepModel::grow_node( const StepFeatures& x, const Eigen::VectorXd& y, int* samples, int count, int depth, int max_depth )
+{
+    const int node = static_cast< int >( m_value.size() );
+    double    sum  = 0.0;
+    for ( int i = 0; i < count; ++i )
+        sum += y[ samples[ i ] ];
+
+    m_feature.push_back( -1 );
+    m_threshold.push_back( 0.0 );
+    m_left.push_back( -1 );
+    m_right.push_back( -1 );
+    m_value.push_back( sum / count );
+    if ( depth >= max_depth || count < 2 )
+        return node;
+
+    // 平方误差最小的分裂：按特征排序后扫描各分裂点，左右两侧 sum^2/n 之和最大即误差最小，只在取值不同的相邻样本之间分裂
+    double best_score     = sum * sum / count;
+    int    best_feature   = -1;
+    double best_threshold = 0.0;
+    for ( int feature = 0; feature < 2; ++feature )
+    {
+        std::sort( samples, samples + count, [ & ]( int a, int b ) { return x( a, feature ) < x( b, feature ); } );
+
+        double left_sum = 0.0;
+        for ( int i = 0; i < count - 1; ++i )
+        {
+            left_sum += y[ samples[ i ] ];
+            const double value = x( samples[ i ], feature );
+            const double next  = x( samples[ i + 1 ], feature );
+            if ( ! ( value < next ) )
+                continue;
+
+            const double right_sum = sum - left_sum;
+            const double score     = left_sum * left_sum / ( i + 1 ) + right_sum * right_sum / ( count - i - 1 );
+            if ( score > best_score * ( 1.0 + 1e-12 ) )
+            {
+                best_score     = score;
+                best_feature   = feature;
+                best_threshold = value + ( next - value ) / 2.0;
+                if ( ! ( best_threshold < next ) )
+                    best_threshold = value;
+            }
+        }
+    }
+    if ( best_feature < 0 )
+        return node;
+
+    // 左子树紧随当前节点，右子树在左子树之后
+    int*      middle     = std::partition( samples, samples + count, [ & ]( int s ) { return x( s, best_feature ) <= best_threshold; } );
+    const int left_count = static_cast< int >( middle - samples );
+    m_feature[ node ]    = best_feature;
+    m_threshold[ node ]  = best_threshold;
+
+    const int left  = grow_node( x, y, samples, left_count, depth + 1, max_depth );
+    const int right = grow_node( x, y, middle, count - left_count, depth + 1, max_depth );
+    m_left[ node ]  = left;
+    m_right[ node ] = right;
+    return node;
+}
+
+Eigen::VectorXd CFmTreeStepModel::predict( const StepFeatures& x ) const
+{
+    const Eigen::Index rows    = x.rows();
+    Eigen::VectorXd    lengths = Eigen::VectorXd::Constant( rows, m_base );
+
+    for ( int root : m_roots )
+    {
+        for ( Eigen::Index i = 0; i < rows; ++i )
+        {
+            int node = root;
+            while ( m_feature[ node ] >= 0 )
+                node = ( x( i, m_feature[ node ] ) <= m_threshold[ node ] ) ? m_left[ node ] : m_right[ node ];
+            lengths[ i ] += m_scale * m_value[ node ];
+        }
+    }
+
+    return lengths;
+}
+
+void CFmTreeStepModel::serialize( std::ostream& out ) const
+{
+    dlib::serialize( std::string( name() ), out );
+    dlib::serialize( m_base, out );
+    dlib::serialize( m_scale, out );
+    dlib::serialize( m_roots, out );
+    dlib::serialize( m_feature, out );
+    dlib::serialize( m_threshold, out );
+    dlib::serialize( m_left, out );
+    dlib::serialize( m_right, out );
+    dlib::serialize( m_value, out );
+}
+
+void CFmTreeStepModel::deserialize( std::istream& in )
+{
+    check_model_tag( in, name() );
+    dlib::deserialize( m_base, in );
+    dlib::deserialize( m_scale, in );
+    dlib::deserialize( m_roots, in );
+    dlib::deserialize( m_feature, in );
+    dlib::deserialize( m_threshold, in );
+    dlib::deserialize( m_left, in );
+    dlib::deserialize( m_right, in );
+    dlib::deserialize( m_value, in );
+    validate();
+}
+
+void CFmTreeStepModel::validate() const
+{
+    // 子节点序号必须大于父节点，保证预测时的遍历一定在叶节点结束
+    const int  nodes = static_cast< int >( m_value.size() );
+    const bool sizes = m_feature.size() == m_value.size() && m_threshold.size() == m_value.size() && m_left.size() == m_value.size() && m_right.size() == m_value.size();
+    bool       valid = sizes;
+    for ( int node = 0; valid && node < nodes; ++node )
+    {
+        if ( m_feature[ node ] < 0 )
+            continue;
+        valid = m_feature[ node ] < 2 && m_left[ node ] > node && m_left[ node ] < nodes && m_right[ node ] > node && m_right[ node ] < nodes;
+    }
+    for ( size_t t = 0; valid && t < m_roots.size(); ++t )
+        valid = m_roots[ t ] >= 0 && m_roots[ t ] < nodes;
+
+    if ( ! valid )
+        throw std::runtime_error( "Invalid " + std::string( name() ) + " step model file" );
+}
+
+CFmKNeighborsStepModel::CFmKNeighborsStepModel() : m_k( kNeighbors ) {}
+
+const char* CFmKNeighborsStepModel::name() const
+{
+    return "KNeighbors";
+}
+
+void CFmKNeighborsStepModel::train( const StepFeatures& x, const Eigen::VectorXd& y )
+{
+    check_training_set( x, y );
+    m_f.assign( x.col( 0 ).data(), x.col( 0 ).data() + x.rows() );
+    m_sigma.assign( x.col( 1 ).data(), x.col( 1 ).data() + x.rows() );
+    m_length.assign( y.data(), y.data() + y.size() );
+}
+
+Eigen::VectorXd CFmKNeighborsStepModel::predict( const StepFeatures& x ) const
+{
+    const size_t    n = m_length.size();
+    const int       k = static_cast< int >( std::min< size_t >( m_k, n ) );
+    Eigen::VectorXd lengths( x.rows() );
+    if ( k == 0 )
+        return lengths.setZero();
+
+    // 逐步计算到全部训练样本的距离平方，插入排序保留最近的k个
+    std::vector< double > distance( n );
+    std::vector< double > nearest( k );
+    std::vector< size_t > nearest_index( k );
+    for ( Eigen::Index i = 0; i < x.rows(); ++i )
+    {
+        const double f     = x( i, 0 );
+        const double sigma = x( i, 1 );
+        for ( size_t j = 0; j < n; ++j )
+        {
+            const double df = m_f[ j ] - f;
+            const double ds = m_sigma[ j ] - sigma;
+            distance[ j ]   = df * df + ds * ds;
+        }
+
+        int count = 0;
+        for ( size_t j = 0; j < n; ++j )
+        {
+            if ( count == k && distance[ j ] >= nearest[ k - 1 ] )
+                continue;
+
+            int pos = ( count < k ) ? count++ : k - 1;
+            while ( pos > 0 && nearest[ pos - 1 ] > distance[ j ] )
+            {
+                nearest[ pos ]       = nearest[ pos - 1 ];
+                nearest_index[ pos ] = nearest_index[ pos - 1 ];
+                --pos;
+            }
+            nearest[ pos ]       = distance[ j ];
+            nearest_index[ pos ] = j;
+        }
+
+        double sum = 0.0;
+        for ( int m = 0; m < k; ++m )
+            sum += m_length[ nearest_index[ m ] ];
+        lengths[ i ] = sum / k;
+    }
+
+    return lengths;
+}
+
+void CFmKNeighborsStepModel::serialize( std::ostream& out ) const
+{
+    dlib::serialize( std::string( name() ), out );
+    dlib::serialize( m_k, out );
+    dlib::serialize( m_f, out );
+    dlib::serialize( m_sigma, out );
+    dlib::serialize( m_length, out );
+}
+
+void CFmKNeighborsStepModel::deserialize( std::istream& in )
+{
+    check_model_tag( in, name() );
+    dlib::deserialize( m_k, in );
+    dlib::deserialize( m_f, in );
+    dlib::deserialize( m_sigma, in );
+    dlib::deserialize( m_length, in );
+    if ( m_k <= 0 || m_f.size() != m_length.size() || m_sigma.size() != m_length.size() )
+        throw std::runtime_error( "Invalid KNeighbors step model file" );
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+#include "step_predictor.h"
+#include <eigen3/Eigen/Dense>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 步长特征：每行一步，第0列为步频f，第1列为方差sigma
+using StepFeatures = Eigen::Matrix< double, Eigen::Dynamic, 2 >;
+
+// 步长模型：按配置的model_name在构造推算时创建一次，推算时每批步一次批量求值，热路径中不再比较模型名；
+// 每种模型各自负责序列化，模型文件的内容为模型数据之后接有效峰值(CFmStepPredictor::save_model)
+class CFmStepModel
+{
+public:
+    virtual ~CFmStepModel() = default;
+
+    // 按名称创建未训练的模型："Mean"、"Linear"、"SVR"、"DecisionTree"、"RandomForest"、"GradientBoosting"、"KNeighbors"，
+    // 名称未知时抛出std::runtime_error
+    static std::unique_ptr< CFmStepModel > create( const std::string& name );
+
+    virtual const char* name() const = 0;
+    // 以每段的特征x与实际步长y训练
+    virtual void train( const StepFeatures& x, const Eigen::VectorXd& y ) = 0;
+    // 批量预测x各行的步长
+    virtual Eigen::VectorXd predict( const StepFeatures& x ) const = 0;
+
+    virtual void serialize( std::ostream& out ) const = 0;
+    virtual void deserialize( std::istream& in )      = 0;
+};
+
+// 平均步长：训练数据总距离除以总步数（由CFmStepPredictor::step_process_mean计算，不能由各段步长训练，train抛出异常），
+// 模型文件为模型名之后接一个double，也可以加载没有模型名的原格式文件
+class CFmMeanStepModel : public CFmStepModel
+{
+public:
+    CFmMeanStepModel() : m_step_length( 0.0 ) {}
+    explicit CFmMeanStepModel( double step_length ) : m_step_length( step_length ) {}
+
+    inline void set_step_length( double step_length )
+    {
+        m_step_length = step_length;
+    }
+
+    const char*     name() const override;
+    void            train( const StepFeatures& x, const Eigen::VectorXd& y ) override;
+    Eigen::VectorXd predict( const StepFeatures& x ) const override;
+    void            serialize( std::ostream& out ) const override;
+    void            deserialize( std::istream& in ) override;
+private:
+    double m_step_length;
+};
+
+// 线性模型：dlib线性核回归("Linear"为岭回归，"SVR"为支持向量回归)，模型文件为dlib的决策函数，"SVR"在其前写入模型名，
+// 没有模型名的决策函数文件(原格式)作为"Linear"加载；
+// 加载或训练后展开为 scale * (w · x) - b，预测为一次矩阵向量乘积，只有一个基向量时与dlib逐点求值的运算顺序相同
+class CFmLinearStepModel : public CFmStepModel
+{
+public:
+    explicit CFmLinearStepModel( bool svr );
+
+    const char*     name() const override;
+    void            train( const StepFeatures& x, const Eigen::VectorXd& y ) override;
+    Eigen::VectorXd predict( const StepFeatures& x ) const override;
+    void            serialize( std::ostream& out ) const override;
+    void            deserialize( std::istream& in ) override;
+private:
+    bool            m_svr;
+    LinearModel     m_model;
+    Eigen::Vector2d m_weights;
+    double          m_weight_scale;
+    double          m_bias;
+
+    void unpack();
+};
+
+// 回归树集成：决策树、随机森林(自助采样，各树取平均)与梯度提升(平方损失，拟合残差)，
+// 所有树的节点按先序平铺在同一组数组中(左子节点紧随父节点，右子节点在左子树之后)，
+// 预测时逐棵树处理整批步，一棵树的节点在处理整批时始终在缓存中
+class CFmTreeStepModel : public CFmStepModel
+{
+public:
+    typedef enum _Kind
+    {
+        DECISION_TREE,
+        RANDOM_FOREST,
+        GRADIENT_BOOSTING,
+    } Kind;
+
+    explicit CFmTreeStepModel( Kind kind );
+
+    const char*     name() const override;
+    void            train( const StepFeatures& x, const Eigen::VectorXd& y ) override;
+    Eigen::VectorXd predict( const StepFeatures& x ) const override;
+    void            serialize( std::ostream& out ) const override;
+    void            deserialize( std::istream& in ) override;
+private:
+    Kind                  m_kind;
+    double                m_base;       // 预测的初值
+    double                m_scale;      // 每棵树输出的系数：随机森林为1/树数，梯度提升为学习率
+    std::vector< int >    m_roots;      // 各树根节点序号
+    std::vector< int >    m_feature;    // 分裂特征，<0为叶节点
+    std::vector< double > m_threshold;  // 特征<=阈值走左子节点
+    std::vector< int >    m_left;
+    std::vector< int >    m_right;
+    std::vector< double > m_value;      // 叶节点输出
+
+    // 以samples中的样本拟合一棵树，返回根节点序号
+    int  grow_tree( const StepFeatures& x, const Eigen::VectorXd& y, std::vector< int >& samples, int max_depth );
+    int  grow_node( const StepFeatures& x, const Eigen::VectorXd& y, int* samples, int count, int depth, int max_depth );
+    void validate() const;
+};
+
+// k近邻回归：k个最近(欧氏距离)训练样本的实际步长取平均，模型文件保存全部训练样本
+class CFmKNeighborsStepModel : public CFmStepModel
+{
+public:
+    CFmKNeighborsStepModel();
+
+    const char*     name() const override;
+    void            train( const StepFeatures& x, const Eigen::VectorXd& y ) override;
+    Eigen::VectorXd predict( const StepFeatures& x ) const override;
+    void            serialize( std::ostream& out ) const override;
+    void            deserialize( std::istream& in ) override;
+private:
+    int                   m_k;
+    std::vector< double > m_f;  // 训练样本按列存放
+    std::vector< double > m_sigma;
+    std::vector< double > m_length;
+};
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "step_predictor.h"
-#include "data_buffer_loader.h"
-#include "data_file_loader.h"
+#include "data_view.h"
 #include "fm_pdr.h"
+#include "step_model.h"
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cmath>
 #include <dlib/matrix.h>
 #include <dlib/serialize.h>
@@ -16,23 +17,15 @@ CFmStepPredictor::CFmStepPredictor( const PDRConfig& config, const CFmDataManage
     int start = ( config.clean_start <= 0 ? 0 : config.clean_start ) * config.sample_rate;
     int end   = ( config.clean_end <= 0 ? ( int )train_data.get_train_data_size() : config.clean_end ) * config.sample_rate;
 
-    if ( train_data.get_data_type() == DATA_TYPE_FILE )
-    {
-        const CFmDataFileLoader& file_loader = dynamic_cast< const CFmDataFileLoader& >( train_data );
-        m_train_data                         = slice( file_loader, start, end );
-    }
-    else
-    {
-        const CFmDataBufferLoader& buffer_loader = dynamic_cast< const CFmDataBufferLoader& >( train_data );
-        m_train_data                             = slice( buffer_loader, start, end );
-    }
+    // 训练数据只在训练期间使用，以视图方式引用，不复制传感器数据
+    m_train_data.reset( new CFmDataView( train_data, start, end ) );
 }
 
-CFmStepPredictor::CFmStepPredictor( const PDRConfig& config ) : m_config( config ) {}
+CFmStepPredictor::CFmStepPredictor( const PDRConfig& config ) : m_config( config ), m_train_data( nullptr ) {}
 
 CFmStepPredictor::~CFmStepPredictor() {}
 
-Eigen::VectorXd CFmStepPredictor::filter( int range, const Eigen::VectorXd& data )
+void CFmStepPredictor::detect_peaks( const ConstVectorRef& data, int range, int min_distance, double valid_peak_value, bool keep_all, Eigen::VectorXd& filter_data, std::vector< int >& peak_indices )
 {
     const int n = data.size();
     if ( n == 0 )
@@ -41,85 +34,68 @@ Eigen::VectorXd CFmStepPredictor::filter( int range, const Eigen::VectorXd& data
     if ( range <= 0 || range > n )
         throw std::invalid_argument( "Filter range=" + std::to_string( range ) + " needs to be greater than or equal to 0 and less than " + std::to_string( n ) + "." );
 
-    // 创建平均滤波器核
-    Eigen::VectorXd kernel = Eigen::VectorXd::Ones( range ) / static_cast< double >( range );
-
-    // 计算填充大小
-    const int pad = ( range - 1 ) / 2;
+    // 平均滤波器系数与填充大小，与NumPy的same模式卷积一致（零填充）
+    const double weight = 1.0 / static_cast< double >( range );
+    const int    pad    = ( range - 1 ) / 2;
 
-    // 创建结果向量
-    Eigen::VectorXd filter_data( n );
+    filter_data.resize( n );
+    peak_indices.clear();
 
-    // 实现与NumPy相同的卷积行为
-    for ( int i = 0; i < n; ++i )
+    // 1. 滑动平均：按卷积的累加顺序逐项求和(每个点的和从0开始，依次加上窗口内第0..range-1项，越界项跳过)，
+    //    与逐点卷积逐位一致；按项而非按点循环，每一项为一次连续的向量乘加，可向量化。
+    //    注意：计算量仍为O(n·range)，随move_average增长。窗口和逐点更新可降为O(n)，但结果与卷积有舍入级的差别，
+    //    训练得到的有效峰值与模型会随之变化，这里为与原结果逐位一致而保留逐项求和；逐点推算见CFmStepDetector(O(1)均摊)
+    filter_data.setZero();
+    for ( int k = 0; k < range; ++k )
     {
-        double sum = 0.0;
-
-        // 对于每个输出位置，计算卷积和
-        for ( int k = 0; k < range; ++k )
-        {
-            const int data_index = i - pad + k;
-
-            // 处理边界情况（零填充）
-            if ( data_index >= 0 && data_index < n )
-                sum += data( data_index ) * kernel( k );
-            // 对于超出边界的情况，NumPy使用零填充，所以不需要做任何操作
-        }
-
-        filter_data( i ) = sum;
+        // 第i点的第k项为data(i - pad + k)，有效的i为[pad - k, n + pad - k)与[0, n)的交集
+        const int first = std::max( 0, pad - k );
+        const int last  = std::min( n, n + pad - k );
+        if ( last > first )
+            filter_data.segment( first, last - first ) += data.segment( first - pad + k, last - first ) * weight;
     }
 
-    return filter_data;
-}
+    bool have_last = false;  // 是否有尚未确定的峰（min_distance范围内仍可能被更高的峰替换）
+    int  last_idx  = 0;
 
-Eigen::VectorXi CFmStepPredictor::find_peaks( const VectorXd& data, int min_distance )
-{
-    vector< int > peak_indices;
-
-    for ( int i = 1; i < data.size() - 1; ++i )
+    for ( int j = 1; j < n - 1; ++j )
     {
-        // 检测局部极大值
-        if ( data( i ) > data( i - 1 ) && data( i ) > data( i + 1 ) )
+        // 2. 局部极大值
+        if ( ! ( filter_data( j ) > filter_data( j - 1 ) && filter_data( j ) > filter_data( j + 1 ) ) )
+            continue;
+
+        // 3. 最小距离约束：在min_distance范围内，更高的峰替换旧峰，否则丢弃当前峰
+        if ( have_last && j - last_idx < min_distance )
         {
-            bool valid = true;
-
-            // 检查最小距离约束
-            if ( ! peak_indices.empty() )
-            {
-                int last_idx = peak_indices.back();
-                if ( i - last_idx < min_distance )  // 在0.4秒间隔范围内查找到新的波峰
-                {
-                    if ( data( i ) > data( last_idx ) )  // 大于原来波峰，则替换旧峰
-                        peak_indices.pop_back();
-                    else
-                        valid = false;  // 小于等于原来波峰，丢弃当前峰，保留旧峰
-                }
-            }
-
-            if ( valid )
-                peak_indices.push_back( i );
+            if ( filter_data( j ) > filter_data( last_idx ) )
+                last_idx = j;
+            continue;
         }
+
+        // 4. 旧峰已不可能被替换，按有效峰值筛选后输出
+        if ( have_last && ( keep_all || filter_data( last_idx ) > valid_peak_value ) )
+            peak_indices.push_back( last_idx );
+        have_last = true;
+        last_idx  = j;
     }
 
-    // 转换为Eigen向量
-    return Map< VectorXi >( peak_indices.data(), peak_indices.size() );
+    if ( have_last && ( keep_all || filter_data( last_idx ) > valid_peak_value ) )
+        peak_indices.push_back( last_idx );
 }
 
-Eigen::VectorXi CFmStepPredictor::find_real_peak_indices( const Eigen::VectorXd& data, int range, int min_distance, Eigen::VectorXd& filtered_accel_data, double& valid_peak_value, bool is_train )
+Eigen::VectorXi CFmStepPredictor::find_real_peak_indices( const ConstVectorRef& data, int range, int min_distance, Eigen::VectorXd& filtered_accel_data, double& valid_peak_value, bool is_train )
 {
-    // 滤波处理
-    filtered_accel_data = filter( range, data );
-
-    // 峰值检测
-    Eigen::VectorXi peak_indices = find_peaks( filtered_accel_data, min_distance );
+    // 向量化滑动平均之后，峰值检测与有效峰值筛选在一次遍历中完成；训练时有效峰值未知，需要先得到所有峰值
+    vector< int > peak_indices;
+    detect_peaks( data, range, min_distance, valid_peak_value, is_train, filtered_accel_data, peak_indices );
+    if ( ! is_train )
+        return Map< VectorXi >( peak_indices.data(), peak_indices.size() );
 
     // 计算峰值均值
-    Eigen::VectorXd peak_values = filtered_accel_data( peak_indices );
-    if ( is_train )
-    {
-        double mean_peak = peak_values.mean();
-        valid_peak_value = 0.8 * mean_peak;
-    }
+    Eigen::VectorXi all_peak_indices = Map< VectorXi >( peak_indices.data(), peak_indices.size() );
+    Eigen::VectorXd peak_values      = filtered_accel_data( all_peak_indices );
+    double          mean_peak        = peak_values.mean();
+    valid_peak_value                 = 0.8 * mean_peak;
 
     // 筛选有效峰值>80%均值
     Eigen::Array< bool, Eigen::Dynamic, 1 > valid_mask = peak_values.array() > valid_peak_value;
@@ -128,42 +104,53 @@ Eigen::VectorXi CFmStepPredictor::find_real_peak_indices( const Eigen::VectorXd&
     int                                     count     = 0;
     for ( int i = 0; i < mask_size; ++i )
         if ( valid_mask[ i ] )
-            real_peak_indices[ count++ ] = peak_indices[ i ];
+            real_peak_indices[ count++ ] = all_peak_indices[ i ];
 
     return real_peak_indices;
 }
 
-double CFmStepPredictor::compute_variance( const Eigen::VectorXd& data, int start_idx, int end_idx )
+void CFmStepPredictor::prefix_sums( const Eigen::VectorXd& data, Eigen::VectorXd& sum, Eigen::VectorXd& square_sum )
+{
+    // sum[k]、square_sum[k]为前k个点之和与平方和；数据先减去整体均值，避免区间方差计算时的数值抵消
+    const Eigen::Index n    = data.size();
+    const double       base = ( n > 0 ) ? data.mean() : 0.0;
+
+    sum.resize( n + 1 );
+    square_sum.resize( n + 1 );
+    sum[ 0 ]        = 0.0;
+    square_sum[ 0 ] = 0.0;
+    for ( Eigen::Index i = 0; i < n; ++i )
+    {
+        const double d      = data[ i ] - base;
+        sum[ i + 1 ]        = sum[ i ] + d;
+        square_sum[ i + 1 ] = square_sum[ i ] + d * d;
+    }
+}
+
+double CFmStepPredictor::compute_variance( const Eigen::VectorXd& sum, const Eigen::VectorXd& square_sum, int start_idx, int end_idx )
 {
     // 边界检查
-    const int n = data.size();
-    if ( start_idx < 0 || end_idx > n || start_idx >= end_idx )
+    const int n = sum.size() - 1;
+    if ( start_idx < 0 || end_idx >= n || start_idx >= end_idx )
         return 0.0;  // 返回安全值
 
-    // 计算数据段长度
-    const int segment_size = end_idx - start_idx + 1;
-
-    // 使用Eigen的block获取数据子集
-    const auto segment = data.segment( start_idx, segment_size );
-
-    // 计算均值
-    const double mean = segment.mean();
+    // 数据段[start_idx, end_idx]的均值与方差由前缀和之差得到
+    const int    segment_size = end_idx - start_idx + 1;
+    const double mean         = ( sum[ end_idx + 1 ] - sum[ start_idx ] ) / segment_size;
+    const double variance     = ( square_sum[ end_idx + 1 ] - square_sum[ start_idx ] ) / segment_size - mean * mean;
 
-    // 计算方差
-    const double variance = ( segment.array() - mean ).square().sum() / segment_size;
-
-    return variance;
+    return std::max( variance, 0.0 );
 }
 
-FeatureMatrix CFmStepPredictor::calculate_features( const CFmDataManager& data, const Eigen::VectorXi& real_peak_indices, const Eigen::VectorXd& filtered_accel_data, int start_step_index, int end_step_index )
+FeatureMatrix CFmStepPredictor::calculate_features( const CFmDataManager& data, const Eigen::VectorXi& real_peak_indices, const Eigen::VectorXd& filtered_sum, const Eigen::VectorXd& filtered_square_sum, int start_step_index, int end_step_index )
 {
     // 计算频率f
-    const VectorXd& data_time     = data.get_pdr_data( PDR_DATA_FIELD_TIME );
-    double          time_interval = data_time[ real_peak_indices[ end_step_index ] ] - data_time[ real_peak_indices[ start_step_index ] ];
-    double          f             = ( end_step_index - start_step_index ) / time_interval;
+    ConstVectorRef data_time     = data.get_pdr_data( PDR_DATA_FIELD_TIME );
+    double         time_interval = data_time[ real_peak_indices[ end_step_index ] ] - data_time[ real_peak_indices[ start_step_index ] ];
+    double         f             = ( end_step_index - start_step_index ) / time_interval;
 
     // 计算方差sigma
-    double sigma = compute_variance( filtered_accel_data, real_peak_indices[ start_step_index ], real_peak_indices[ end_step_index ] );
+    double sigma = compute_variance( filtered_sum, filtered_square_sum, real_peak_indices[ start_step_index ], real_peak_indices[ end_step_index ] );
 
     // 存储特征
     FeatureMatrix features;
@@ -173,15 +160,15 @@ FeatureMatrix CFmStepPredictor::calculate_features( const CFmDataManager& data,
     return features;
 }
 
-FeatureMatrix CFmStepPredictor::calculate_features( const Eigen::VectorXi& real_peak_indices, const Eigen::VectorXd& filtered_accel_data, int start_step_index, int end_step_index )
+FeatureMatrix CFmStepPredictor::calculate_features( const Eigen::VectorXi& real_peak_indices, const Eigen::VectorXd& filtered_sum, const Eigen::VectorXd& filtered_square_sum, int start_step_index, int end_step_index )
 {
     // 计算频率f
-    const VectorXd& train_data_time = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
-    double          time_interval   = train_data_time[ real_peak_indices[ end_step_index ] ] - train_data_time[ real_peak_indices[ start_step_index ] ];
-    double          f               = ( end_step_index - start_step_index ) / time_interval;
+    ConstVectorRef train_data_time = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
+    double         time_interval   = train_data_time[ real_peak_indices[ end_step_index ] ] - train_data_time[ real_peak_indices[ start_step_index ] ];
+    double         f               = ( end_step_index - start_step_index ) / time_interval;
 
     // 计算方差sigma
-    double sigma = compute_variance( filtered_accel_data, real_peak_indices[ start_step_index ], real_peak_indices[ end_step_index ] );
+    double sigma = compute_variance( filtered_sum, filtered_square_sum, real_peak_indices[ start_step_index ], real_peak_indices[ end_step_index ] );
 
     // 存储特征
     FeatureMatrix features;
@@ -191,131 +178,41 @@ FeatureMatrix CFmStepPredictor::calculate_features( const Eigen::VectorXi& real_
     return features;
 }
 
-LinearModel CFmStepPredictor::select_model( const string& model_str, std::vector< FeatureMatrix >& x, std::vector< double >& y )
-{
-    LinearModel model;
-
-    if ( model_str == "Linear" )
-    {
-        // 线性回归
-        dlib::rr_trainer< dlib::linear_kernel< FeatureMatrix > > trainer;
-        trainer.set_lambda( 0 );
-        model = trainer.train( x, y );
-    }
-#if 0
-    else if (model_str == "DecisionTree")
-    {
-        // Dlib没有直接的决策树回归器，使用回归树代替
-        dlib::regression_tree_trainer trainer;
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "SVR")
-    {
-        // SVR回归 - 需要指定核类型
-        typedef dlib::linear_kernel<FeatureMatrix> kernel_type;
-        dlib::svr_trainer<kernel_type> trainer;
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "KNeighbors")
-    {
-        knn_regressor knn(5);
-        knn.train(x, y);
-        model = knn;
-    }
-    else if (model_str == "RandomForest")
-    {
-        // 随机森林回归
-        dlib::random_forest_regression_trainer trainer;
-        trainer.set_num_trees(20);
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "AdaBoost")
-    {
-        // AdaBoost回归 - Dlib可能不支持，使用梯度提升代替
-        dlib::gradient_tree_regression_trainer trainer;
-        trainer.set_num_trees(50);
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "GradientBoosting")
-    {
-        // 梯度提升回归树
-        dlib::gradient_tree_regression_trainer trainer;
-        trainer.set_num_trees(100);
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "Bagging")
-    {
-        // Bagging回归 - Dlib可能不支持，使用其他回归器代替
-        dlib::linear_least_squares_regression_trainer trainer;
-        model = trainer.train(x, y);
-    }
-    else if (model_str == "ExtraTree")
-    {
-        throw std::runtime_error("ExtraTree not supported in Dlib");
-    }
-#endif
-    else
-    {
-        throw std::runtime_error( "Unknown model: " + model_str );
-    }
-
-    return model;
-}
-
-void CFmStepPredictor::save_model( const LinearModel& model, const double& valid_peak_value, const std::string& filename )
-{
-    std::ofstream fout( filename, std::ios::binary );
-    if ( ! fout )
-        throw std::runtime_error( "Unable to open file: " + filename );
-
-    // 使用dlib的序列化机制
-    dlib::serialize( model, fout );
-    dlib::serialize( valid_peak_value, fout );
-}
-
-void CFmStepPredictor::save_model( const double& mean_model, const double& valid_peak_value, const std::string& filename )
+void CFmStepPredictor::save_model( const CFmStepModel& model, const double& valid_peak_value, const std::string& filename )
 {
     std::ofstream fout( filename, std::ios::binary );
     if ( ! fout )
         throw std::runtime_error( "Unable to open file: " + filename );
 
     // 使用dlib的序列化机制
-    dlib::serialize( mean_model, fout );
+    model.serialize( fout );
     dlib::serialize( valid_peak_value, fout );
 }
 
-void CFmStepPredictor::load_model( const std::string& filename, LinearModel& model, double& valid_peak_value )
-{
-    std::ifstream fin( filename, std::ios::binary );
-    if ( ! fin )
-        throw std::runtime_error( "Unable to open file: " + filename );
-
-    // 使用dlib的反序列化机制
-    dlib::deserialize( model, fin );
-    dlib::deserialize( valid_peak_value, fin );
-}
-
-void CFmStepPredictor::load_model( const std::string& filename, double& mean_model, double& valid_peak_value )
+void CFmStepPredictor::load_model( const std::string& filename, CFmStepModel& model, double& valid_peak_value )
 {
     std::ifstream fin( filename, std::ios::binary );
     if ( ! fin )
         throw std::runtime_error( "Unable to open file: " + filename );
 
     // 使用dlib的反序列化机制
-    dlib::deserialize( mean_model, fin );
+    model.deserialize( fin );
     dlib::deserialize( valid_peak_value, fin );
 }
 
 // 步长回归处理函数
-LinearModel CFmStepPredictor::step_process_regression( const std::string& model_str, int move_average, int min_distance, size_t distance_frac_step, const std::string& save_model_name, double& valid_peak_value, bool write_log )
+void CFmStepPredictor::step_process_regression( CFmStepModel& model, int move_average, int min_distance, size_t distance_frac_step, const std::string& save_model_name, double& valid_peak_value, bool write_log )
 {
     Eigen::VectorXd filtered_accel_data;
-    const VectorXd& accelerometer_data_mag = m_train_data->get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
+    ConstVectorRef  accelerometer_data_mag = m_train_data->get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
     Eigen::VectorXi real_peak_indices      = find_real_peak_indices( accelerometer_data_mag, move_average, min_distance, filtered_accel_data, valid_peak_value, true );
 
-    // 特征提取
-    const VectorXd&              train_data_time      = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
-    const VectorXd&              train_true_data_time = m_train_data->get_true_data( TRUE_DATA_FIELD_TIME );
+    // 特征提取：各段的方差由滤波后加速度的前缀和O(1)得到
+    Eigen::VectorXd filtered_sum, filtered_square_sum;
+    prefix_sums( filtered_accel_data, filtered_sum, filtered_square_sum );
+
+    ConstVectorRef               train_data_time      = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
+    ConstVectorRef               train_true_data_time = m_train_data->get_true_data( TRUE_DATA_FIELD_TIME );
     Eigen::Index                 step_index           = 0;
     Eigen::Index                 n_segments           = m_train_data->get_train_data_size() / distance_frac_step;  // 按每个坐标点分段计算一次步长sigma、f
     std::vector< FeatureMatrix > x;
@@ -332,11 +229,11 @@ LinearModel CFmStepPredictor::step_process_regression( const std::string& model_
             continue;  // 没有检测到步伐，跳过
 
         // 计算行走距离
-        const VectorXd& true_data_x = m_train_data->get_true_data( TRUE_DATA_FIELD_X );
-        const VectorXd& true_data_y = m_train_data->get_true_data( TRUE_DATA_FIELD_Y );
-        double          distance    = 0.0;
-        Eigen::Index    start_idx   = ( i - 1 ) * distance_frac_step;
-        Eigen::Index    end_idx     = i * distance_frac_step;
+        ConstVectorRef true_data_x = m_train_data->get_true_data( TRUE_DATA_FIELD_X );
+        ConstVectorRef true_data_y = m_train_data->get_true_data( TRUE_DATA_FIELD_Y );
+        double         distance    = 0.0;
+        Eigen::Index   start_idx   = ( i - 1 ) * distance_frac_step;
+        Eigen::Index   end_idx     = i * distance_frac_step;
         for ( Eigen::Index k = start_idx; k < end_idx; ++k )
         {
             double dx = true_data_x[ k + 1 ] - true_data_x[ k ];
@@ -349,44 +246,42 @@ LinearModel CFmStepPredictor::step_process_regression( const std::string& model_
         y.push_back( step_length );
 
         // 存储特征
-        FeatureMatrix features = calculate_features( real_peak_indices, filtered_accel_data, last_step_index, step_index );
+        FeatureMatrix features = calculate_features( real_peak_indices, filtered_sum, filtered_square_sum, last_step_index, step_index );
         x.push_back( features );
     }
 
-    LinearModel model = select_model( model_str, x, y );
+    // 训练模型
+    StepFeatures    features( x.size(), 2 );
+    Eigen::VectorXd step_lengths = Eigen::Map< const Eigen::VectorXd >( y.data(), y.size() );
+    for ( size_t i = 0; i < x.size(); ++i )
+    {
+        features( i, 0 ) = x[ i ]( 0 );
+        features( i, 1 ) = x[ i ]( 1 );
+    }
+    model.train( features, step_lengths );
 
     // 保存模型（可选）
     if ( ! save_model_name.empty() )
-        save_model( dlib::any_cast< LinearModel >( model ), valid_peak_value, save_model_name );
-
-    // LinearModel m;
-    // double vpv = 0.0;
-    // load_model(save_model_name, m, vpv);
+        save_model( model, valid_peak_value, save_model_name );
 
     // 输出预测结果（可选）
     if ( write_log )
     {
-        // std::cout << "Actual: " << valid_peak_value << ", valid_peak_value: " << vpv << std::endl;
-
+        Eigen::VectorXd predictions = model.predict( features );
         for ( Eigen::Index i = 0; i < ( Eigen::Index )y.size(); ++i )
-        {
-            double prediction = model( x[ i ] );
-            std::cout << "Actual: " << y[ i ] << ", Predicted: " << prediction << std::endl;
-        }
+            std::cout << "Actual: " << y[ i ] << ", Predicted: " << predictions[ i ] << std::endl;
     }
-
-    return model;
 }
 
 double CFmStepPredictor::step_process_mean( int move_average, int min_distance, const std::string& save_model_name, double& valid_peak_value )
 {
     Eigen::VectorXd filtered_accel_data;
-    const VectorXd& accelerometer_data_mag = m_train_data->get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
+    ConstVectorRef  accelerometer_data_mag = m_train_data->get_pdr_data( PDR_DATA_FIELD_ACC_MAG );
     Eigen::VectorXi real_peak_indices      = find_real_peak_indices( accelerometer_data_mag, move_average, min_distance, filtered_accel_data, valid_peak_value, true );
 
     // 计算总移动距离
-    const VectorXd& train_data_time      = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
-    const VectorXd& train_true_data_time = m_train_data->get_true_data( TRUE_DATA_FIELD_TIME );
+    ConstVectorRef  train_data_time      = m_train_data->get_pdr_data( PDR_DATA_FIELD_TIME );
+    ConstVectorRef  train_true_data_time = m_train_data->get_true_data( TRUE_DATA_FIELD_TIME );
     int             n                    = m_train_data->get_train_data_size();
     Eigen::VectorXd dx                   = m_train_data->get_true_data( TRUE_DATA_FIELD_X ).tail( n - 1 ) - m_train_data->get_true_data( TRUE_DATA_FIELD_X ).head( n - 1 );
     Eigen::VectorXd dy                   = m_train_data->get_true_data( TRUE_DATA_FIELD_Y ).tail( n - 1 ) - m_train_data->get_true_data( TRUE_DATA_FIELD_Y ).head( n - 1 );
@@ -401,7 +296,7 @@ double CFmStepPredictor::step_process_mean( int move_average, int min_distance,
 
     // 保存模型（可选）
     if ( ! save_model_name.empty() )
-        save_model( step_length, valid_peak_value, save_model_name );
+        save_model( CFmMeanStepModel( step_length ), valid_peak_value, save_model_name );
 
     return step_length;
 }
\ No newline at end of file
@@ -1,13 +1,15 @@
+#pragma once
 #include <eigen3/Eigen/Dense>
 #include <dlib/mlp.h>
 #include <dlib/svm.h>
 #include <dlib/statistics.h>
 #include "data_manager.h"
+#include <memory>
 
 using FeatureMatrix = dlib::matrix<double, 2, 1>;
 using LinearModel = dlib::decision_function<dlib::linear_kernel<FeatureMatrix>>;
 
-using AnyModel = dlib::any_decision_function<FeatureMatrix>;
+class CFmStepModel;
 
 class CFmStepPredictor
 {
@@ -16,47 +18,52 @@ public:
     CFmStepPredictor(const PDRConfig &config);
     virtual ~CFmStepPredictor();
 
-    Eigen::VectorXi find_real_peak_indices(const Eigen::VectorXd &data,
+    Eigen::VectorXi find_real_peak_indices(const ConstVectorRef &data,
                                            int range,
                                            int min_distance,
                                            Eigen::VectorXd &filtered_accel_data,
                                            double &valid_peak_value,
                                            bool is_train = false);
+    // 特征段方差使用的前缀和：sum[k]、square_sum[k]为前k个点(减去整体均值后)之和与平方和
+    void prefix_sums(const Eigen::VectorXd &data, Eigen::VectorXd &sum, Eigen::VectorXd &square_sum);
     FeatureMatrix calculate_features(const CFmDataManager &data,
                                      const Eigen::VectorXi &real_peak_indices,
-                                     const Eigen::VectorXd &filtered_accel_data,
+                                     const Eigen::VectorXd &filtered_sum,
+                                     const Eigen::VectorXd &filtered_square_sum,
                                      int start_step_index,
                                      int end_step_index);
     double step_process_mean(int move_average,
                              int min_distance,
                              const std::string &save_model_name,
                              double &valid_peak_value);
-    LinearModel step_process_regression(const std::string &model_str,
-                                        int move_average,
-                                        int min_distance,
-                                        size_t distance_frac_step,
-                                        const std::string &save_model_name,
-                                        double &valid_peak_value,
-                                        bool write_log = false);
+    // 按训练数据各段的特征与实际步长训练model（"Mean"以外的模型）
+    void step_process_regression(CFmStepModel &model,
+                                 int move_average,
+                                 int min_distance,
+                                 size_t distance_frac_step,
+                                 const std::string &save_model_name,
+                                 double &valid_peak_value,
+                                 bool write_log = false);
 
-    void save_model(const LinearModel &model, const double &valid_peak_value, const std::string &filename); // TODO:使用AnyModel会引起序列化错误
-    void save_model(const double &mean_model, const double &valid_peak_value, const std::string &filename);
-    void load_model(const std::string &filename, LinearModel &model, double &valid_peak_value); // TODO:使用AnyModel会引起序列化错误
-    void load_model(const std::string &filename, double &mean_model, double &valid_peak_value);
+    // 模型文件：模型自身的序列化数据之后接有效峰值
+    void save_model(const CFmStepModel &model, const double &valid_peak_value, const std::string &filename);
+    void load_model(const std::string &filename, CFmStepModel &model, double &valid_peak_value);
 
 private:
-    Eigen::VectorXd filter(int range, const Eigen::VectorXd &data);
-    Eigen::VectorXi find_peaks(const Eigen::VectorXd &data, int min_distance);
-    double compute_variance(const Eigen::VectorXd &data, int start_idx, int end_idx);
+    void detect_peaks(const ConstVectorRef &data,
+                      int range,
+                      int min_distance,
+                      double valid_peak_value,
+                      bool keep_all,
+                      Eigen::VectorXd &filter_data,
+                      std::vector<int> &peak_indices);
+    double compute_variance(const Eigen::VectorXd &sum, const Eigen::VectorXd &square_sum, int start_idx, int end_idx);
     FeatureMatrix calculate_features(const Eigen::VectorXi &real_peak_indices,
-                                     const Eigen::VectorXd &filtered_accel_data,
+                                     const Eigen::VectorXd &filtered_sum,
+                                     const Eigen::VectorXd &filtered_square_sum,
                                      int start_step_index,
                                      int end_step_index);
-    LinearModel select_model(const std::string &model_str,
-                             std::vector<FeatureMatrix> &x,
-                             std::vector<double> &y);
-
 private:
     const PDRConfig& m_config;
-    CFmDataManager *m_train_data;
+    std::unique_ptr<CFmDataManager> m_train_data; // 训练数据视图，引用构造时传入的训练数据，训练(step_process_*)期间其必须有效
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "stream_lowpass.h"
+#include <algorithm>
+#include <stdexcept>
+
+CFmStreamLowPass::CFmStreamLowPass( int channels, double butter_wn, int lookahead ) : m_lookahead( lookahead )
+{
+    if ( channels <= 0 )
+        throw std::invalid_argument( "Filter channels must be greater than 0" );
+    if ( lookahead < 0 )
+        throw std::invalid_argument( "Filter lookahead must not be negative" );
+
+    m_forward.resize( channels );
+    for ( LowPass& f : m_forward )
+        f.setupN( butter_wn );
+    m_backward.setupN( butter_wn );
+
+    m_offset.assign( channels, 0.0 );
+    m_started.assign( channels, false );
+    m_pending.resize( channels );
+}
+
+CFmStreamLowPass::~CFmStreamLowPass() {}
+
+void CFmStreamLowPass::reset()
+{
+    for ( LowPass& f : m_forward )
+        f.reset();
+    m_backward.reset();
+
+    std::fill( m_offset.begin(), m_offset.end(), 0.0 );
+    std::fill( m_started.begin(), m_started.end(), false );
+    for ( std::vector< double >& pending : m_pending )
+        pending.clear();
+}
+
+double CFmStreamLowPass::filter( int channel, double value )
+{
+    // 以首个输入值作为偏置，等价于滤波器已处于该值的稳态，无需预热
+    if ( ! m_started[ channel ] )
+    {
+        m_offset[ channel ]  = value;
+        m_started[ channel ] = true;
+    }
+
+    return m_forward[ channel ].filter( value - m_offset[ channel ] ) + m_offset[ channel ];
+}
+
+Eigen::VectorXd CFmStreamLowPass::process( int channel, const Eigen::Ref< const Eigen::VectorXd >& input )
+{
+    const Eigen::Index n = input.size();
+
+    // 不做反向滤波时直接输出正向滤波结果
+    if ( m_lookahead == 0 )
+    {
+        Eigen::VectorXd output( n );
+        for ( Eigen::Index i = 0; i < n; ++i )
+            output[ i ] = filter( channel, input[ i ] );
+        return output;
+    }
+
+    // 正向滤波，结果接在上次留下的点之后
+    std::vector< double >& pending = m_pending[ channel ];
+    for ( Eigen::Index i = 0; i < n; ++i )
+        pending.push_back( filter( channel, input[ i ] ) );
+
+    // 块[begin, begin + lookahead)从其后lookahead个点处的稳态开始反向滤波，凑齐前视点的块才输出
+    const size_t    block  = m_lookahead;
+    const size_t    blocks = pending.size() >= 2 * block ? ( pending.size() - block ) / block : 0;
+    Eigen::VectorXd output( blocks * block );
+    for ( size_t k = 0; k < blocks; ++k )
+        backward_block( pending, k * block, ( k + 2 ) * block - 1, output.data() + k * block );
+
+    pending.erase( pending.begin(), pending.begin() + blocks * block );
+    return output;
+}
+
+Eigen::VectorXd CFmStreamLowPass::flush( int channel )
+{
+    std::vector< double >& pending = m_pending[ channel ];
+    const size_t           size    = pending.size();
+    const size_t           block   = m_lookahead;
+
+    // 剩余的块只使用到数据末尾为止的前视点
+    Eigen::VectorXd output( size );
+    for ( size_t begin = 0; begin < size; begin += block )
+        backward_block( pending, begin, std::min( begin + 2 * block, size ) - 1, output.data() + begin );
+
+    pending.clear();
+    return output;
+}
+
+void CFmStreamLowPass::backward_block( const std::vector< double >& pending, size_t begin, size_t last, double* output )
+{
+    const size_t end    = std::min< size_t >( begin + m_lookahead, last + 1 );
+    const double offset = pending[ last ];
+
+    m_backward.reset();
+    for ( size_t i = last + 1; i-- > begin; )
+    {
+        const double y = m_backward.filter( pending[ i ] - offset ) + offset;
+        if ( i < end )
+            output[ i - begin ] = y;
+    }
+}
\ No newline at end of file
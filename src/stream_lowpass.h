@@ -0,0 +1,43 @@
+#pragma once
+#include "Iir.h"
+#include <eigen3/Eigen/Dense>
+#include <vector>
+
+// 流式巴特沃斯低通滤波：各通道的正向滤波状态在多次调用之间保持，反向滤波只在固定长度的前视段内进行，
+// 每次调用的代价只与新增点数成正比，不再随窗口长度、镜像填充和预热次数增长；
+// 反向滤波按采样序号对齐的lookahead点分块，尚无足够前视点的块留到之后的调用，
+// 每个点都有lookahead~2*lookahead-1个前视点，输出与数据如何分批送入无关
+class CFmStreamLowPass
+{
+public:
+    // lookahead为反向滤波的前视点数，为0时只做因果正向滤波
+    CFmStreamLowPass( int channels, double butter_wn, int lookahead );
+    ~CFmStreamLowPass();
+
+    // 清除所有通道的滤波状态，下一个输入点作为新的稳态起点
+    void reset();
+    // 单点因果滤波
+    double filter( int channel, double value );
+    // 对新增的一段数据滤波：正向滤波延续之前的状态，再对已有lookahead个前视点的块反向滤波，
+    // 返回按序接在上次输出之后的滤波结果，其余点留到之后的调用或flush；lookahead为0时返回全部新增点
+    Eigen::VectorXd process( int channel, const Eigen::Ref< const Eigen::VectorXd >& input );
+    // 数据结束：输出该通道剩余的点，数据末尾不足lookahead的点只使用已有的前视点
+    Eigen::VectorXd flush( int channel );
+
+    inline int get_lookahead() const
+    {
+        return m_lookahead;
+    }
+private:
+    typedef Iir::Butterworth::LowPass< 2, Iir::DirectFormII > LowPass;
+
+    int                                  m_lookahead;
+    std::vector< LowPass >               m_forward;   // 各通道正向滤波器
+    std::vector< double >                m_offset;    // 各通道首个输入值，作为偏置使滤波从稳态开始
+    std::vector< bool >                  m_started;   // 各通道是否已有输入
+    std::vector< std::vector< double > > m_pending;   // 各通道已正向滤波、尚未输出的点，从块的起点开始
+    LowPass                              m_backward;  // 反向滤波器，每个前视段从稳态重新开始
+
+    // 对pending中从begin开始的一块反向滤波，前视到last为止，结果写入output
+    void backward_block( const std::vector< double >& pending, size_t begin, size_t last, double* output );
+};
\ No newline at end of file
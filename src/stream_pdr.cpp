@@ -0,0 +1,182 @@
+#include "stream_pdr.h"
+#include "data_buffer_loader.h"
+#include "exception.h"
+#include <cmath>
+#include <cstring>
+
+CFmStreamPDR::CFmStreamPDR( const PDRConfig& config, CFmPDR& pdr, CFmGravityEstimator& gravity_estimator, double x0, double y0 )
+    : m_config( config ), m_pdr( pdr ), m_started( false ), m_flushed( false ), m_have_lacc( false ), m_gravity_estimator( gravity_estimator ), m_lowpass( 6, config.butter_wn, 0 ), m_step_detector( config ), m_last_x( 0.0 ), m_last_y( 0.0 )
+{
+    if ( config.move_average <= 0 || config.min_distance <= 0 || config.least_start_point <= 0 )
+        throw std::invalid_argument( "move_average, min_distance and least_start_point must be greater than 0" );
+
+    memset( &m_si, 0x00, sizeof( m_si ) );
+    m_si.x0 = x0;
+    m_si.y0 = y0;
+
+    m_start_samples.reserve( config.least_start_point + 1 );
+}
+
+CFmStreamPDR::~CFmStreamPDR() {}
+
+Eigen::MatrixXd CFmStreamPDR::push( const PDRSensorData& data )
+{
+    if ( m_flushed )
+        throw std::logic_error( "Stream PDR has been flushed" );
+
+    if ( data.length == 0 || ! data.acc_time || ! data.acc_x || ! data.acc_y || ! data.acc_z || ! data.gyr_x || ! data.gyr_y || ! data.gyr_z || ! data.mag_x || ! data.mag_y || ! data.mag_z )
+        throw DataException( DataException::EMPTY_ERROR, "Pushed sensor data is empty" );
+
+    // 线性加速度计是否可用以首次推送为准，之后保持一致
+    const bool have_lacc = ( data.lacc_x != nullptr && data.lacc_y != nullptr && data.lacc_z != nullptr );
+    if ( ! m_started && m_start_samples.empty() )
+        m_have_lacc = have_lacc;
+    else if ( m_have_lacc && ! have_lacc )
+        throw DataException( DataException::COLUMN_INCONSISTENT, "Linear accelerometer data is missing" );
+
+    for ( unsigned long i = 0; i < data.length; ++i )
+    {
+        StreamSample sample;
+        sample.time      = data.acc_time[ i ];
+        sample.mag_time  = data.mag_time ? data.mag_time[ i ] : data.acc_time[ i ];
+        sample.acc[ 0 ]  = data.acc_x[ i ];
+        sample.acc[ 1 ]  = data.acc_y[ i ];
+        sample.acc[ 2 ]  = data.acc_z[ i ];
+        sample.lacc[ 0 ] = m_have_lacc ? data.lacc_x[ i ] : 0.0;
+        sample.lacc[ 1 ] = m_have_lacc ? data.lacc_y[ i ] : 0.0;
+        sample.lacc[ 2 ] = m_have_lacc ? data.lacc_z[ i ] : 0.0;
+        sample.gyr[ 0 ]  = data.gyr_x[ i ];
+        sample.gyr[ 1 ]  = data.gyr_y[ i ];
+        sample.gyr[ 2 ]  = data.gyr_z[ i ];
+        sample.mag[ 0 ]  = data.mag_x[ i ];
+        sample.mag[ 1 ]  = data.mag_y[ i ];
+        sample.mag[ 2 ]  = data.mag_z[ i ];
+
+        if ( m_started )
+        {
+            process_sample( sample );
+        }
+        else
+        {
+            // 起点信息需要least_start_point以上的点数
+            m_start_samples.push_back( sample );
+            if ( ( int )m_start_samples.size() > m_config.least_start_point )
+                start_navigation();
+        }
+    }
+
+    return take_output();
+}
+
+Eigen::MatrixXd CFmStreamPDR::flush()
+{
+    if ( m_flushed || ! m_started )
+    {
+        m_flushed = true;
+        return Eigen::MatrixXd();
+    }
+    m_flushed = true;
+
+    // 输出缓存中剩余的最后一步
+    m_step_detector.finish();
+
+    return take_output();
+}
+
+void CFmStreamPDR::start_navigation()
+{
+    const size_t          n = m_start_samples.size();
+    std::vector< double > columns[ 16 ];
+    for ( auto& column : columns )
+        column.resize( n );
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        const StreamSample& s = m_start_samples[ i ];
+        for ( int k = 0; k < 4; ++k )
+            columns[ k * 4 ][ i ] = s.time;
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            columns[ 1 + axis ][ i ]  = s.acc[ axis ];
+            columns[ 5 + axis ][ i ]  = s.lacc[ axis ];
+            columns[ 9 + axis ][ i ]  = s.gyr[ axis ];
+            columns[ 13 + axis ][ i ] = s.mag[ axis ];
+        }
+    }
+
+    PDRData pdr_data;
+    memset( &pdr_data, 0x00, sizeof( pdr_data ) );
+    PDRSensorData& sensor_data = pdr_data.sensor_data;
+    double** fields[ 16 ]      = { &sensor_data.acc_time, &sensor_data.acc_x, &sensor_data.acc_y, &sensor_data.acc_z, &sensor_data.lacc_time, &sensor_data.lacc_x, &sensor_data.lacc_y, &sensor_data.lacc_z,
+                                   &sensor_data.gyr_time, &sensor_data.gyr_x, &sensor_data.gyr_y, &sensor_data.gyr_z, &sensor_data.mag_time, &sensor_data.mag_x, &sensor_data.mag_y, &sensor_data.mag_z };
+    for ( int k = 0; k < 16; ++k )
+        *fields[ k ] = ( m_have_lacc || k < 4 || k > 7 ) ? columns[ k ].data() : nullptr;
+    sensor_data.length = n;
+
+    // 一次性使用起点数据确定初始东向量和行进方向
+    CFmDataBufferLoader start_loader( m_config, 0, pdr_data );
+    m_si      = m_pdr.start( m_si.x0, m_si.y0, start_loader );
+    m_e0      = Eigen::Vector3d( m_si.e0_x, m_si.e0_y, m_si.e0_z );
+    m_started = true;
+    m_step_detector.reset( m_pdr.get_merge_direction_step().get_valid_peak_value() );
+
+    // 缓存的点同样参与推算
+    for ( const StreamSample& s : m_start_samples )
+        process_sample( s );
+    m_start_samples.clear();
+    m_start_samples.shrink_to_fit();
+}
+
+void CFmStreamPDR::process_sample( const StreamSample& sample )
+{
+    // 重力估计
+    Eigen::Vector3d gravity;
+    if ( m_have_lacc )
+    {
+        gravity = Eigen::Vector3d( sample.acc[ 0 ] - sample.lacc[ 0 ], sample.acc[ 1 ] - sample.lacc[ 1 ], sample.acc[ 2 ] - sample.lacc[ 2 ] );
+    }
+    else
+    {
+        gravity = m_gravity_estimator.update( Eigen::Vector3d::Map( sample.acc ), Eigen::Vector3d::Map( sample.gyr ), Eigen::Vector3d::Map( sample.mag ) );
+    }
+
+    // 低通滤波
+    const double raw[ 6 ] = { sample.mag[ 0 ], sample.mag[ 1 ], sample.mag[ 2 ], gravity.x(), gravity.y(), gravity.z() };
+    double       filtered[ 6 ];
+    for ( int c = 0; c < 6; ++c )
+        filtered[ c ] = m_lowpass.filter( c, raw[ c ] );
+
+    // 东向量与行进方向
+    Eigen::Vector3d mag_f( filtered[ 0 ], filtered[ 1 ], filtered[ 2 ] );
+    Eigen::Vector3d grv_f( filtered[ 3 ], filtered[ 4 ], filtered[ 5 ] );
+    Eigen::Vector3d e = grv_f.cross( mag_f );
+
+    const double direction       = CFmDirectionPredictor::calc_direction( e, grv_f, m_e0, m_si.direction0 );
+    const double accel_magnitude = std::sqrt( sample.acc[ 0 ] * sample.acc[ 0 ] + sample.acc[ 1 ] * sample.acc[ 1 ] + sample.acc[ 2 ] * sample.acc[ 2 ] );
+    m_step_detector.push( sample.time, accel_magnitude, direction );
+}
+
+Eigen::MatrixXd CFmStreamPDR::take_output()
+{
+    constexpr double                  kK         = 1e5;
+    const CFmMergeDirectionStep&      merge      = m_pdr.get_merge_direction_step();
+    const std::vector< DetectedStep > steps      = m_step_detector.take_steps();
+    const Eigen::VectorXd             steps_pred = merge.predict_step_lengths( steps );
+    Eigen::MatrixXd                   t( steps.size(), 4 );
+
+    for ( size_t i = 0; i < steps.size(); ++i )
+    {
+        // 累加位移
+        double step_pred = steps_pred[ i ];
+        double rad       = steps[ i ].direction * M_PI / 180.0;
+        m_last_x += step_pred * std::cos( rad );
+        m_last_y += step_pred * std::sin( rad );
+
+        t( i, 0 ) = steps[ i ].time;
+        t( i, 1 ) = m_last_x / kK + m_si.x0;
+        t( i, 2 ) = m_last_y / kK + m_si.y0;
+        t( i, 3 ) = steps[ i ].direction;
+    }
+
+    return t;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include "gravity_estimator.h"
+#include "pdr.h"
+#include "step_detector.h"
+#include "stream_lowpass.h"
+#include <vector>
+
+// 流式推算使用的单个采样点
+typedef struct _StreamSample
+{
+    double time;       ///< 时间戳（单位：秒）
+    double mag_time;   ///< 磁力计的采样时间戳，磁力计与IMU分别采样（单位：秒）
+    double acc[ 3 ];   ///< 加速度计
+    double lacc[ 3 ];  ///< 线性加速度计
+    double gyr[ 3 ];   ///< 陀螺仪
+    double mag[ 3 ];   ///< 磁力计
+} StreamSample;
+
+// 流式(推送式)PDR引擎：逐点或小批量接收传感器数据，滤波、重力估计、峰值检测状态在调用之间保持，
+// 每个采样点的处理代价为常数（起点确定前的缓存除外），每检测到一步即输出一个位置点
+class CFmStreamPDR
+{
+public:
+    CFmStreamPDR( const PDRConfig& config, CFmPDR& pdr, CFmGravityEstimator& gravity_estimator, double x0, double y0 );
+    ~CFmStreamPDR();
+
+    // 推入传感器数据，返回本次新确定的位置点，每行为(time, x, y, direction)，可能为空
+    Eigen::MatrixXd push( const PDRSensorData& data );
+    // 结束推算，输出缓存中剩余的最后一步
+    Eigen::MatrixXd flush();
+
+    inline bool is_started() const
+    {
+        return m_started;
+    }
+private:
+    const PDRConfig&            m_config;
+    CFmPDR&                     m_pdr;
+    StartInfo                   m_si;
+    bool                        m_started;        // 是否已确定起点信息
+    bool                        m_flushed;        // 是否已结束推算
+    bool                        m_have_lacc;      // 是否使用线性加速度计计算重力
+    std::vector< StreamSample > m_start_samples;  // 确定起点信息前缓存的采样点
+
+    // 重力估计，由调用者持有
+    CFmGravityEstimator& m_gravity_estimator;
+
+    // 磁力计、重力因果低通滤波
+    CFmStreamLowPass m_lowpass;
+    Eigen::Vector3d  m_e0;
+
+    // 步态检测
+    CFmStepDetector m_step_detector;
+
+    double m_last_x;  // 相对起点的位置（单位：米）
+    double m_last_y;
+
+    void            start_navigation();
+    void            process_sample( const StreamSample& sample );
+    Eigen::MatrixXd take_output();
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "synthetic_device.h"
+#include <cmath>
+#include <stdexcept>
+
+constexpr unsigned kSeed          = 20240601;  // 噪声种子
+constexpr double   kGravity       = 9.8035;    // 重力加速度（单位：m/s^2）
+constexpr double   kStepFreq      = 1.8;       // 步频（单位：Hz）
+constexpr double   kTurnPeriod    = 90.0;      // 行进方向往复转动的周期（单位：秒）
+constexpr double   kTurnAmp       = 0.5;       // 行进方向转动幅度（单位：弧度）
+constexpr double   kMagHorizontal = 25.0;      // 地磁水平分量（单位：uT）
+constexpr double   kMagVertical   = -40.0;     // 地磁垂直分量（单位：uT）
+
+CFmSyntheticDevice::CFmSyntheticDevice( int sample_rate, double speed )
+    : CFmDeviceBackend( speed > 0 ? sample_rate * speed : 0 ), m_sample_rate( sample_rate ), m_index( 0 ), m_random( kSeed ), m_noise( 0.0, 1.0 )
+{
+    if ( sample_rate <= 0 )
+        throw std::invalid_argument( "sample_rate must be greater than 0" );
+}
+
+CFmSyntheticDevice::~CFmSyntheticDevice() {}
+
+unsigned long CFmSyntheticDevice::Read( PDRSensorData& sensor_data, unsigned long length, bool is_first )
+{
+    if ( is_first )
+    {
+        m_index = 0;
+        m_random.seed( kSeed );
+    }
+
+    for ( unsigned long i = 0; i < length; ++i )
+    {
+        WaitNextSample( is_first );
+        is_first = false;
+
+        const double t       = static_cast< double >( m_index++ ) / m_sample_rate;
+        const double phase   = 2.0 * M_PI * kStepFreq * t;
+        const double turn    = 2.0 * M_PI / kTurnPeriod;
+        const double heading = kTurnAmp * std::sin( turn * t );
+        const double yaw     = kTurnAmp * turn * std::cos( turn * t ) * 180.0 / M_PI;
+
+        // 每步一个竖直方向的加速度峰值，水平方向随步伐前后、左右摆动
+        sensor_data.acc_time[ i ] = t;
+        sensor_data.acc_x[ i ]    = 1.2 * std::sin( phase + 0.5 ) + 0.05 * m_noise( m_random );
+        sensor_data.acc_y[ i ]    = 0.4 * std::sin( phase / 2.0 ) + 0.05 * m_noise( m_random );
+        sensor_data.acc_z[ i ]    = kGravity + 2.5 * std::sin( phase ) + 0.05 * m_noise( m_random );
+        sensor_data.gyr_time[ i ] = t;
+        sensor_data.gyr_x[ i ]    = 5.0 * std::sin( phase ) + 0.2 * m_noise( m_random );
+        sensor_data.gyr_y[ i ]    = 3.0 * std::cos( phase ) + 0.2 * m_noise( m_random );
+        sensor_data.gyr_z[ i ]    = yaw + 0.2 * m_noise( m_random );
+
+        // 地磁场在设备坐标系中随行进方向转动
+        sensor_data.mag_time[ i ] = t;
+        sensor_data.mag_x[ i ]    = kMagHorizontal * std::cos( heading ) + 0.3 * m_noise( m_random );
+        sensor_data.mag_y[ i ]    = -kMagHorizontal * std::sin( heading ) + 0.3 * m_noise( m_random );
+        sensor_data.mag_z[ i ]    = kMagVertical + 0.3 * m_noise( m_random );
+        sensor_data.length        = i + 1;
+    }
+
+    return length;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include "device_backend.h"
+#include <random>
+
+// 合成数据后端：按固定步频生成行走时的加速度计、陀螺仪、磁力计数据，行进方向缓慢往复转动，
+// 叠加固定种子的高斯噪声，数据可复现；单位与I2C后端一致（m/s^2、dps、uT），以speed倍速输出，speed<=0时不控制节拍
+class CFmSyntheticDevice : public CFmDeviceBackend
+{
+public:
+    CFmSyntheticDevice( int sample_rate, double speed );
+    ~CFmSyntheticDevice();
+
+    unsigned long Read( PDRSensorData& sensor_data, unsigned long length, bool is_first ) override;
+private:
+    int                                m_sample_rate;
+    unsigned long long                 m_index;  // 下一个采样点的序号
+    std::mt19937                       m_random;
+    std::normal_distribution< double > m_noise;
+};
\ No newline at end of file
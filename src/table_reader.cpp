@@ -0,0 +1,96 @@
+#include "table_reader.h"
+#include "csv_reader.h"
+#include "sensor_log.h"
+#include "sensor_record.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <sys/stat.h>
+
+static bool is_regular_file( const std::string& path )
+{
+    struct stat st;
+    return stat( path.c_str(), &st ) == 0 && S_ISREG( st.st_mode );
+}
+
+Eigen::MatrixXd CFmTableReader::read_matrix( int start_col, int end_col, long num_rows ) const
+{
+    const long total_rows = static_cast< long >( m_rows );
+    const long total_cols = static_cast< long >( m_header.size() );
+
+    // 处理 num_rows 参数
+    if ( num_rows < 0 )
+        num_rows = total_rows;  // -1 表示获取所有行
+    else if ( num_rows > total_rows )
+        throw std::out_of_range( "请求的行数超过文档总行数" );
+
+    // 处理列范围参数，任一列为-1时获取所有列
+    if ( start_col == -1 || end_col == -1 )
+    {
+        start_col = 0;
+        end_col   = total_cols - 1;
+    }
+    if ( start_col < 0 || end_col >= total_cols || start_col > end_col )
+        throw std::invalid_argument( "无效的列范围" );
+
+    // 矩阵按列存储，各列直接作为读取目标
+    const int              num_cols = end_col - start_col + 1;
+    Eigen::MatrixXd        mat( num_rows, num_cols );
+    std::vector< double* > columns( num_cols );
+    for ( int k = 0; k < num_cols; ++k )
+        columns[ k ] = mat.col( k ).data();
+
+    read_columns( start_col, num_cols, columns.data(), static_cast< size_t >( num_rows ) );
+    return mat;
+}
+
+void CFmTableReader::find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const
+{
+    first_row = 0;
+    num_rows  = m_rows;
+    if ( std::isinf( start_time ) && start_time < 0 && std::isinf( end_time ) && end_time > 0 )
+        return;
+
+    // 没有时间索引时读取整个时间列后二分查找
+    std::vector< double > time( m_rows );
+    double* const         columns[ 1 ] = { time.data() };
+    read_rows( 0, 0, 1, columns, m_rows );
+
+    const auto first = std::lower_bound( time.begin(), time.end(), start_time );
+    const auto last  = std::lower_bound( first, time.end(), end_time );
+    first_row        = static_cast< size_t >( first - time.begin() );
+    num_rows         = static_cast< size_t >( last - first );
+}
+
+Eigen::MatrixXd CFmTableReader::read_time_range( double start_time, double end_time ) const
+{
+    size_t first_row, num_rows;
+    find_rows( start_time, end_time, first_row, num_rows );
+
+    const int              num_cols = static_cast< int >( m_header.size() );
+    Eigen::MatrixXd        mat( num_rows, num_cols );
+    std::vector< double* > columns( num_cols );
+    for ( int k = 0; k < num_cols; ++k )
+        columns[ k ] = mat.col( k ).data();
+
+    read_rows( first_row, 0, num_cols, columns.data(), num_rows );
+    return mat;
+}
+
+std::unique_ptr< CFmTableReader > CFmTableReader::open( const std::string& dir, const std::string& name )
+{
+    const std::string base = dir + "/" + name;
+    if ( is_regular_file( base + kRecordExtension ) )
+        return std::make_unique< CFmRecordReader >( base + kRecordExtension );
+    if ( is_regular_file( base + kLogExtension ) )
+        return std::make_unique< CFmLogReader >( base + kLogExtension );
+    if ( is_regular_file( base + ".csv" ) )
+        return std::make_unique< CFmCsvReader >( base + ".csv" );
+    return nullptr;
+}
+
+bool CFmTableReader::exists( const std::string& dir, const std::string& name )
+{
+    const std::string base = dir + "/" + name;
+    return is_regular_file( base + kRecordExtension ) || is_regular_file( base + kLogExtension ) || is_regular_file( base + ".csv" );
+}
\ No newline at end of file
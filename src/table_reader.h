@@ -0,0 +1,52 @@
+#pragma once
+#include <eigen3/Eigen/Dense>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 按列读取的数据表：一个传感器的一个数据文件，首列为时间，文本(CSV)、二进制记录(sensor_record.h)与压缩日志(sensor_log.h)共用该接口
+class CFmTableReader
+{
+public:
+    virtual ~CFmTableReader() = default;
+
+    // 数据行数
+    inline size_t rows() const
+    {
+        return m_rows;
+    }
+    inline size_t cols() const
+    {
+        return m_header.size();
+    }
+    inline const std::vector< std::string >& header() const
+    {
+        return m_header;
+    }
+
+    // 从第first_row行开始，读取第start_col列开始的count列的至多max_rows行，第k列写入columns[k]，返回读取的行数
+    virtual size_t read_rows( size_t first_row, int start_col, int count, double* const* columns, size_t max_rows ) const = 0;
+
+    // 时间(第0列)在[start_time, end_time)内的行：首行行号与行数，要求时间递增；范围为(-inf, +inf)时不读取时间列
+    virtual void find_rows( double start_time, double end_time, size_t& first_row, size_t& num_rows ) const;
+
+    // 读取第start_col列开始的count列的前max_rows行
+    inline size_t read_columns( int start_col, int count, double* const* columns, size_t max_rows ) const
+    {
+        return read_rows( 0, start_col, count, columns, max_rows );
+    }
+
+    // 读取为矩阵，start_col或end_col为-1时取全部列，num_rows为-1时取全部行
+    Eigen::MatrixXd read_matrix( int start_col = -1, int end_col = -1, long num_rows = -1 ) const;
+    // 读取时间在[start_time, end_time)内的全部列
+    Eigen::MatrixXd read_time_range( double start_time, double end_time ) const;
+
+    // 打开dir目录下名为name的数据表（不含扩展名），依次为二进制记录(.fmr)、压缩日志(.fmz)、CSV(.csv)，都不存在时返回nullptr
+    static std::unique_ptr< CFmTableReader > open( const std::string& dir, const std::string& name );
+    static bool                              exists( const std::string& dir, const std::string& name );
+protected:
+    CFmTableReader() : m_rows( 0 ) {}
+
+    std::vector< std::string > m_header;
+    size_t                     m_rows;
+};
\ No newline at end of file
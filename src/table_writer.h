@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+// 按列追加写入的数据表，二进制记录(sensor_record.h)与压缩日志(sensor_log.h)共用该接口
+class CFmTableWriter
+{
+public:
+    virtual ~CFmTableWriter() = default;
+
+    // 追加rows行，columns[k]为第k列
+    virtual void append( const double* const* columns, size_t rows ) = 0;
+    // 把已追加的数据落盘(fdatasync)
+    virtual void sync() = 0;
+
+    virtual size_t cols() const = 0;
+};
\ No newline at end of file
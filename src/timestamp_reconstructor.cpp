@@ -0,0 +1,67 @@
+#include "timestamp_reconstructor.h"
+#include <cmath>
+
+// 遗忘因子，每批一个观测时约等效于最近100个观测
+constexpr double kForgetting = 0.99;
+// 频率偏差的上限，IMU内部振荡器的偏差在数个百分点以内，超出时视为观测异常
+constexpr double kMaxSkew = 0.05;
+// 观测的时间跨度小于该值（单位：秒）时只估计偏移
+constexpr double kMinSpan = 1.0;
+
+CFmTimestampReconstructor::CFmTimestampReconstructor()
+{
+    Reset();
+}
+
+void CFmTimestampReconstructor::Reset()
+{
+    m_valid      = false;
+    m_sensor0_us = 0;
+    m_host0_ns   = 0;
+    m_sw         = 0.0;
+    m_sx         = 0.0;
+    m_sy         = 0.0;
+    m_sxx        = 0.0;
+    m_sxy        = 0.0;
+    m_offset     = 0.0;
+    m_skew       = 0.0;
+}
+
+void CFmTimestampReconstructor::Observe( int64_t sensor_us, int64_t host_ns )
+{
+    if ( ! m_valid )
+    {
+        m_sensor0_us = sensor_us;
+        m_host0_ns   = host_ns;
+        m_valid      = true;
+    }
+
+    const double x = static_cast< double >( sensor_us - m_sensor0_us ) / 1e6;
+    const double y = static_cast< double >( host_ns - m_host0_ns ) / 1e9 - x;
+
+    m_sw  = kForgetting * m_sw + 1.0;
+    m_sx  = kForgetting * m_sx + x;
+    m_sy  = kForgetting * m_sy + y;
+    m_sxx = kForgetting * m_sxx + x * x;
+    m_sxy = kForgetting * m_sxy + x * y;
+
+    // 观测跨度足够时才估计频率偏差，否则读取延迟的抖动会被当作频率偏差
+    const double var_x = m_sw * m_sxx - m_sx * m_sx;
+    if ( var_x > kMinSpan * kMinSpan * m_sw * m_sw )
+    {
+        m_skew = ( m_sw * m_sxy - m_sx * m_sy ) / var_x;
+        m_skew = std::fmax( -kMaxSkew, std::fmin( kMaxSkew, m_skew ) );
+    }
+    m_offset = ( m_sy - m_skew * m_sx ) / m_sw;
+}
+
+int64_t CFmTimestampReconstructor::ToHost( int64_t sensor_us ) const
+{
+    const double x = static_cast< double >( sensor_us - m_sensor0_us ) / 1e6;
+    return m_host0_ns + std::llround( ( x + m_offset + m_skew * x ) * 1e9 );
+}
+
+double CFmTimestampReconstructor::GetSkewPpm() const
+{
+    return m_skew * 1e6;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+// 时间戳重建：传感器时钟(IMU FIFO帧时间戳)到主机时钟(CLOCK_MONOTONIC)的线性映射 host = host0 + (1 + skew) * sensor + offset，
+// 每次突发读取以(最新帧的传感器时间, 读取完成的主机时间)作为一个观测，按指数遗忘的最小二乘估计偏移与频率偏差(skew)，
+// 调度抖动只进入映射的估计，按帧时间戳换算出的采样时间间隔保持传感器时钟的均匀性
+class CFmTimestampReconstructor
+{
+public:
+    CFmTimestampReconstructor();
+
+    void Reset();
+    // 加入一个观测：传感器时间（单位：微秒，已展开回绕）与同一时刻的主机时间（单位：纳秒）
+    void Observe( int64_t sensor_us, int64_t host_ns );
+
+    // 传感器时间换算为主机时间（单位：纳秒），须至少有一个观测
+    int64_t ToHost( int64_t sensor_us ) const;
+    // 传感器时钟相对主机时钟的频率偏差（单位：ppm），正值表示传感器时钟偏慢
+    double GetSkewPpm() const;
+
+    inline bool IsValid() const
+    {
+        return m_valid;
+    }
+private:
+    bool    m_valid;
+    int64_t m_sensor0_us;  // 首个观测作为回归原点，避免大数相减损失精度
+    int64_t m_host0_ns;
+
+    // 回归 y = offset + skew * x，x为相对原点的传感器时间，y为相对原点的主机时间与传感器时间之差（单位：秒）
+    double m_sw;  // 权重和
+    double m_sx;
+    double m_sy;
+    double m_sxx;
+    double m_sxy;
+    double m_offset;
+    double m_skew;
+};
\ No newline at end of file